@@ -0,0 +1,222 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    asset_loader.cpp
+ * \brief   Asynchronous asset loading - files are decoded by loader threads, GL objects
+ *          are created on the GL thread a few at a time.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <IL/il.h>
+#include "asset_loader.h"
+
+typedef struct _AssetJob {
+  std::string name;
+  AssetDecodeFunction decode;
+  AssetUploadFunction upload;
+  void *data;
+  bool decoded;
+} AssetJob;
+
+struct AssetLoader {
+
+  std::vector<AssetJob> jobs;           // not resized while the loader threads run
+  std::vector<std::thread> threads;
+
+  std::atomic<unsigned int> nextJob;    // next job to be decoded
+  std::atomic<unsigned int> decodedCount;
+  std::atomic<bool> quit;
+  unsigned int uploadedCount;           // GL thread only
+
+  std::mutex mutex;                     // guards ready
+  std::deque<unsigned int> ready;       // decoded jobs waiting for upload
+
+} assetLoader;
+
+// DevIL binds images to a global state, only one thread may use it at a time
+static std::mutex imageLibraryMutex;
+
+typedef std::chrono::steady_clock AssetClock;
+
+static void loaderThread(void) {
+
+  while(assetLoader.quit == false) {
+    const unsigned int index = assetLoader.nextJob.fetch_add(1);
+    if(index >= assetLoader.jobs.size())
+      return;
+
+    AssetJob &job = assetLoader.jobs[index];
+    job.decoded = job.decode(job.data);
+
+    std::lock_guard<std::mutex> lock(assetLoader.mutex);
+    assetLoader.ready.push_back(index);
+    assetLoader.decodedCount++;
+  }
+}
+
+void queueAsset(const char *name, AssetDecodeFunction decode, AssetUploadFunction upload, void *data) {
+
+  if(assetLoader.threads.empty() == false) {
+    std::cerr << "queueAsset(): " << name << " queued while loading, finish the loading first" << std::endl;
+    return;
+  }
+
+  AssetJob job;
+  job.name = name;
+  job.decode = decode;
+  job.upload = upload;
+  job.data = data;
+  job.decoded = false;
+
+  assetLoader.jobs.push_back(job);
+}
+
+void startAssetLoading(unsigned int threadCount) {
+
+  assetLoader.nextJob = 0;
+  assetLoader.decodedCount = 0;
+  assetLoader.uploadedCount = 0;
+  assetLoader.quit = false;
+
+  if(threadCount < 1)
+    threadCount = 1;
+  if(threadCount > assetLoader.jobs.size())
+    threadCount = (unsigned int)assetLoader.jobs.size();
+
+  for(unsigned int i = 0; i < threadCount; i++)
+    assetLoader.threads.push_back(std::thread(loaderThread));
+}
+
+bool updateAssetLoading(float timeBudget) {
+
+  const AssetClock::time_point start = AssetClock::now();
+
+  for(;;) {
+    unsigned int index;
+    {
+      std::lock_guard<std::mutex> lock(assetLoader.mutex);
+      if(assetLoader.ready.empty())
+        break;
+      index = assetLoader.ready.front();
+      assetLoader.ready.pop_front();
+    }
+
+    AssetJob &job = assetLoader.jobs[index];
+    job.upload(job.data, job.decoded);
+    assetLoader.uploadedCount++;
+
+    if(std::chrono::duration<float, std::milli>(AssetClock::now() - start).count() >= timeBudget)
+      break;
+  }
+
+  if(assetLoader.uploadedCount < assetLoader.jobs.size())
+    return false;
+
+  // all threads ran out of jobs
+  finishAssetLoading();
+  return true;
+}
+
+bool assetLoadingFinished(void) {
+  return assetLoader.jobs.empty();
+}
+
+float assetLoadingProgress(void) {
+
+  if(assetLoader.jobs.empty())
+    return 1.0f;
+
+  return 0.5f * (assetLoader.decodedCount + assetLoader.uploadedCount) / (float)assetLoader.jobs.size();
+}
+
+void finishAssetLoading(void) {
+
+  assetLoader.quit = true;
+
+  for(size_t i = 0; i < assetLoader.threads.size(); i++)
+    assetLoader.threads[i].join();
+  assetLoader.threads.clear();
+
+  assetLoader.jobs.clear();
+  assetLoader.ready.clear();
+}
+
+bool decodeImage(const std::string &fileName, ImageData &image) {
+
+  image.fileName = fileName;
+  image.width = 0;
+  image.height = 0;
+  image.pixels.clear();
+
+  // the file is read outside of the lock -> disk reads of the loader threads overlap
+  std::ifstream file(fileName.c_str(), std::ios::binary);
+  const std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  if(bytes.empty()) {
+    std::cerr << "decodeImage(): cannot read image " << fileName << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(imageLibraryMutex);
+
+  ILuint imageId;
+  ilGenImages(1, &imageId);
+  ilBindImage(imageId);
+
+  bool decoded = (ilLoadL(IL_TYPE_UNKNOWN, &bytes[0], (ILuint)bytes.size()) == IL_TRUE)
+              && (ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE) == IL_TRUE);
+
+  if(decoded) {
+    image.width = (unsigned int)ilGetInteger(IL_IMAGE_WIDTH);
+    image.height = (unsigned int)ilGetInteger(IL_IMAGE_HEIGHT);
+    const unsigned char *pixels = ilGetData();
+    image.pixels.assign(pixels, pixels + 4 * image.width * image.height);
+  }
+  else {
+    std::cerr << "decodeImage(): cannot decode image " << fileName << std::endl;
+  }
+
+  ilDeleteImages(1, &imageId);
+
+  return decoded;
+}
+
+void uploadImage(const ImageData &image, GLenum target) {
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(target, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &image.pixels[0]);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+GLuint createTextureFromImage(const ImageData &image, bool mipmap) {
+
+  if(image.pixels.empty())
+    return 0;
+
+  GLuint texture = 0;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  uploadImage(image, GL_TEXTURE_2D);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  if(mipmap) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  else {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  CHECK_GL_ERROR();
+
+  return texture;
+}
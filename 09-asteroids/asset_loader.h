@@ -0,0 +1,67 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    asset_loader.h
+ * \brief   Asynchronous asset loading - files are decoded by loader threads, GL objects
+ *          are created on the GL thread a few at a time.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __ASSET_LOADER_H
+#define __ASSET_LOADER_H
+
+#include <string>
+#include <vector>
+#include "pgr.h"
+
+// decodes the asset on a loader thread (file I/O, parsing, decompression), must not call GL
+typedef bool (*AssetDecodeFunction)(void *data);
+// creates the GL objects on the GL thread, decoded is the value returned by the decode function
+typedef void (*AssetUploadFunction)(void *data, bool decoded);
+
+// image decoded to RGBA, 8 bits per channel, rows ordered as set by pgr::initialize()
+typedef struct _ImageData {
+  std::string fileName;
+  unsigned int width;
+  unsigned int height;
+  std::vector<unsigned char> pixels;
+} ImageData;
+
+/// Adds the asset to the list loaded by the next startAssetLoading() call, data must live until it is uploaded.
+void queueAsset(const char *name, AssetDecodeFunction decode, AssetUploadFunction upload, void *data);
+
+//**************************************************************************************************
+/// Starts decoding of the queued assets.
+/**
+ \param[in]  threadCount  Number of loader threads, at most one thread per asset is created.
+*/
+void startAssetLoading(unsigned int threadCount);
+
+//**************************************************************************************************
+/// Uploads decoded assets, called by the GL thread once per frame while loading.
+/**
+ At least one asset is uploaded per call if any is decoded, further assets only while the time budget lasts.
+
+ \param[in]  timeBudget  Time in milliseconds the uploads may take.
+ \return                 True if all queued assets are uploaded.
+*/
+bool updateAssetLoading(float timeBudget);
+
+/// True if there is no asset waiting to be decoded or uploaded.
+bool assetLoadingFinished(void);
+
+/// Loaded part of the queued assets, 0...1 (decoding and uploading count half each).
+float assetLoadingProgress(void);
+
+/// Stops the loader threads, assets not uploaded yet are dropped.
+void finishAssetLoading(void);
+
+// thread-safe image decoding - calls to DevIL are serialized as the library keeps global state
+bool decodeImage(const std::string &fileName, ImageData &image);
+
+// GL thread only - uploads the image to level 0 of the target of the bound texture
+void uploadImage(const ImageData &image, GLenum target);
+
+// GL thread only - counterpart of pgr::createTexture() for a decoded image, returns 0 for an empty image
+GLuint createTextureFromImage(const ImageData &image, bool mipmap = true);
+
+#endif // __ASSET_LOADER_H
@@ -8,376 +8,148 @@
 //----------------------------------------------------------------------------------------
 
 #include <time.h>
-#include <list>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include "pgr.h"
 #include "render_stuff.h"
 #include "spline.h"
+#include "simulation.h"
+#include "job_system.h"
+#include "profiler.h"
+#include "asset_loader.h"
+#include "particles.h"
+#include "picking.h"
+#include "replay.h"
+#include "culling.h"
+#include "render_queue.h"
+#include "clustered_lights.h"
+#include "program_cache.h"
+#include "gpu_motion.h"
 
 
 extern SCommonShaderProgram shaderProgram;
 extern bool useLighting;
+extern bool useInstancing;
+extern bool useGpuMotion;
 
-typedef std::list<void *> GameObjectsList; 
+// objects drawn in the current frame
+VisibleObjects visibleObjects;
 
-struct GameState {
+// point lights of the current frame and their clusters
+std::vector<PointLight> pointLights;
+LightClusters lightClusters;
 
-  int windowWidth;    // set by reshape callback
-  int windowHeight;   // set by reshape callback
+// time the GL thread may spend by uploading loaded assets in one frame, in milliseconds
+#define ASSET_UPLOAD_TIME_BUDGET 8.0f
 
-  bool freeCameraMode;        // false;
-  float cameraElevationAngle; // in degrees = initially 0.0f
+// options given on the command line
+struct ApplicationOptions {
 
-  bool gameOver;              // false;
-  bool keyMap[KEYS_COUNT];    // false
+  bool         headless;      // --headless      run the simulation only, without window and OpenGL
+  unsigned int ticks;         // --ticks N       number of simulation steps in the headless mode
+  float        timeStep;      // --dt SECONDS    fixed time step of the headless simulation
+  unsigned int asteroidCount; // --asteroids N   number of asteroids created on (re)start of the headless game
+  unsigned int seed;          // --seed N        seed of the random generator, current time by default
+  int          collisionMode; // --collisions brute|grid|verify|kinetic
+  unsigned int threadCount;   // --threads N     threads updating objects and recording draws, 1 = single-threaded, hardware threads by default
+  std::string  profileFile;   // --profile FILE  profiling statistics are written to this CSV file on exit
+  std::string  recordFile;    // --record FILE   seed and input of each simulation step are recorded to this file
+  std::string  replayFile;    // --replay FILE   recorded game is played instead of the input, headless or in the window
 
-  float elapsedTime;
-  float missileLaunchTime;
-  float ufoMissileLaunchTime;
+} options;
 
-} gameState;
+void resetCamera(void) {
 
-struct GameObjects {
-
-  SpaceShipObject *spaceShip; // NULL
-
-  GameObjectsList asteroids;
-  GameObjectsList missiles;
-  GameObjectsList ufos;
-
-  GameObjectsList explosions;
-  BannerObject* bannerObject; // NULL;
-} gameObjects;
-
-//**************************************************************************************************
-/// Checks whether a given point is inside a sphere or not.
-/**
- \param[in]  point      Point to be tested.
- \param[in]  center     Center of the sphere.
- \param[in]  radius     Radius of the sphere.
- \return                True if the point lies inside the sphere, otherwise false.
-*/
-bool pointInSphere(const glm::vec3 &point, const glm::vec3 &center, float radius) {
-// ======== BEGIN OF SOLUTION - TASK 6_2-1 ======== //
-  // check whether the given point lies within a sphere of given radius or not
-    
-    // varianta 1
-    //float dx = point.x - center.x;
-    //float dy = point.y - center.y;
-    //float dz = point.z - center.z;
-    //float dst = dx * dx + dy * dy + dz * dz;
-
-    //if (dst <= radius * radius)
-    //    return true;
-
-    
-    // varianta 2
-    if (glm::dot(point - center, point - center) <= radius * radius)
-        return true;
-
-
-    // varianta 3
-    //if (glm::distance(center, point) <= radius)
-    //    return true;
-
-
-// ========  END OF SOLUTION - TASK 6_2-1  ======== //
-
-  return false;
-}
-
-//**************************************************************************************************
-/// Checks if there is intersection between two given spheres or not.
-/**
- \param[in]  center1    First sphere center.
- \param[in]  radius1    First sphere radius.
- \param[in]  center2    Second sphere center.
- \param[in]  radius2    Second sphere radius.
- \return                True if the spheres overlap, otherwise false.
-*/
-bool spheresIntersection(const glm::vec3 &center1, float radius1, const glm::vec3 &center2, float radius2) {
-// ======== BEGIN OF SOLUTION - TASK 6_2-2 ======== //
-  // check whether given spheres are intersecting each other or not
-/*    glm::vec3 delta = center1 - center2;
-
-    if (glm::dot(delta, delta) < (radius1 + radius2) * (radius1 + radius2))
-        return true;*/
-
-    float dx = center1.x - center2.x;
-    float dy = center1.y - center2.y;
-    float dz = center1.z - center2.z;
-    float dst = dx * dx + dy * dy + dz * dz;
-
-    if (glm::distance(center1, center2) <= (radius1 + radius2))
-        return true;
-
-
-// ========  END OF SOLUTION - TASK 6_2-2  ======== //
-
-  return false;
-}
-
-void insertExplosion(const glm::vec3 &position) {
-
-  ExplosionObject* newExplosion = new ExplosionObject;
-
-  newExplosion->speed = 0.0f;
-  newExplosion->destroyed = false;
-
-  newExplosion->startTime = gameState.elapsedTime;
-  newExplosion->currentTime = newExplosion->startTime;
-
-  newExplosion->size = BILLBOARD_SIZE;
-  newExplosion->direction = glm::vec3(0.0f, 0.0f, 1.0f);
-
-  newExplosion->frameDuration = 0.1f;
-  newExplosion->textureFrames = 16;
-
-  newExplosion->position = position;
-
-  gameObjects.explosions.push_back(newExplosion);
-}
-
-void increaseSpaceShipSpeed(float deltaSpeed = SPACESHIP_SPEED_INCREMENT) {
-
-  gameObjects.spaceShip->speed =
-    std::min(gameObjects.spaceShip->speed + deltaSpeed, SPACESHIP_SPEED_MAX);
-}
-
-void decreaseSpaceShipSpeed(float deltaSpeed = SPACESHIP_SPEED_INCREMENT) {
-
-  gameObjects.spaceShip->speed =
-    std::max(gameObjects.spaceShip->speed - deltaSpeed, 0.0f);
-}
-
-void turnSpaceShipLeft(float deltaAngle) {
-
-  gameObjects.spaceShip->viewAngle += deltaAngle;
-
-  if(gameObjects.spaceShip->viewAngle > 360.0f)
-    gameObjects.spaceShip->viewAngle -= 360.0f;
-
-  float angle = glm::radians(gameObjects.spaceShip->viewAngle);
-
-  gameObjects.spaceShip->direction.x = cos(angle);
-  gameObjects.spaceShip->direction.y = sin(angle);
-}
-
-void turnSpaceShipRight(float deltaAngle) {
-
-  gameObjects.spaceShip->viewAngle -= deltaAngle;
-
-  if(gameObjects.spaceShip->viewAngle < 0.0f)
-    gameObjects.spaceShip->viewAngle += 360.0f;
-
-  float angle = glm::radians(gameObjects.spaceShip->viewAngle);
-
-  gameObjects.spaceShip->direction.x = cos(angle);
-  gameObjects.spaceShip->direction.y = sin(angle);
-}
-
-void teleport(void) {
-
-  // generate new space ship position randomly
-  gameObjects.spaceShip->position = glm::vec3(
-    (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-    (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-    0.0f
-  );
-}
-
-void cleanUpObjects(void) {
-
-  // delete asteroids
-  while(!gameObjects.asteroids.empty()) {
-    delete gameObjects.asteroids.back();
-    gameObjects.asteroids.pop_back();
-  } 
-
-  // delete missiles
-  while(!gameObjects.missiles.empty()) {
-    delete gameObjects.missiles.back();
-    gameObjects.missiles.pop_back();
-  } 
-
-  // delete ufos
-  while(!gameObjects.ufos.empty()) {
-    delete gameObjects.ufos.back();
-    gameObjects.ufos.pop_back();
-  } 
-
-  // delete explosions
-  while(!gameObjects.explosions.empty()) {
-    delete gameObjects.explosions.back();
-    gameObjects.explosions.pop_back();
-  } 
-
-  // remove banner
-  if(gameObjects.bannerObject != NULL) {
-    delete gameObjects.bannerObject;
-    gameObjects.bannerObject = NULL;
+  if(gameState.freeCameraMode == true) {
+    gameState.freeCameraMode = false;
+    glutPassiveMotionFunc(NULL);
   }
+  gameState.cameraElevationAngle = 0.0f;
 }
 
-// generates random position that does not collide with the spaceship
-glm::vec3 generateRandomPosition(void) {
- glm::vec3 newPosition;
-  bool invalidPosition = false;
-
-  do {
-
-    // position is generated randomly
-    // coordinates are in range -1.0f ... 1.0f
-    newPosition = glm::vec3(
-      (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-      (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-      0.0f
-    );
-    invalidPosition = pointInSphere(newPosition, gameObjects.spaceShip->position, 3.0f*SPACESHIP_SIZE);
+void restartGame(void) {
 
-  } while (invalidPosition == true);
+  resetSimulation(0.001f * (float)glutGet(GLUT_ELAPSED_TIME)); // milliseconds => seconds
 
-  return newPosition;
+  resetCamera();
 }
 
-AsteroidObject* createAsteroid(void) {
- AsteroidObject* newAsteroid = new AsteroidObject;
-
-  newAsteroid->destroyed = false;
+// Starts the recording or the replay given on the command line, called before the first simulation step.
+// A recording seeds the random generator and restarts the game by its first step, a replay does the same
+// from the log -> the replay starts from the recorded state whatever was played before.
+bool beginSession(unsigned int asteroidCount) {
 
-  newAsteroid->startTime = gameState.elapsedTime;
-  newAsteroid->currentTime = newAsteroid->startTime;
+  if(options.replayFile.empty() == false) {
+    ReplaySettings settings;
+    if(loadReplay(options.replayFile, settings) == false)
+      return false;
 
-  newAsteroid->size = ASTEROID_SIZE;
-
-  // generate motion direction randomly in range -1.0f ... 1.0f
-  newAsteroid->direction = glm::vec3(
-    (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-    (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-    0.0f
-  );
-  newAsteroid->direction = glm::normalize(newAsteroid->direction);
-
-  // position is generated randomly as well
-  newAsteroid->position = generateRandomPosition();
-
-  // motion speed 0.0f ... 1.0f
-  newAsteroid->speed = ASTEROID_SPEED_MAX * (float)(rand() / (double)RAND_MAX);
-  // rotation speed 0.0f ... 1.0f
-  newAsteroid->rotationSpeed = ASTEROID_ROTATION_SPEED_MAX * (float)(rand() / (double)RAND_MAX);
-
-  return newAsteroid;
-}
+    seedSimulationRandom(settings.seed);
+    gameState.collisionMode = settings.collisionMode;
 
-UfoObject* createUfo(void) {
- UfoObject* newUfo = new UfoObject;
-
-  newUfo->destroyed = false;
-
-  newUfo->startTime = gameState.elapsedTime;
-  newUfo->currentTime = newUfo->startTime;
+    printf("Replaying %s: seed %u, collisions: %s\n", options.replayFile.c_str(), settings.seed, collisionModeNames[gameState.collisionMode]);
+  }
+  else if(options.recordFile.empty() == false) {
+    ReplaySettings settings;
+    settings.seed = options.seed;
+    settings.collisionMode = gameState.collisionMode;
+    settings.timeStep = (options.headless == true) ? options.timeStep : 0.0f;
 
-  newUfo->size = UFO_SIZE;
+    if(beginRecording(options.recordFile, settings) == false)
+      return false;
 
-  // generate initial position randomly
-  newUfo->initPosition = generateRandomPosition();
-  newUfo->position = newUfo->initPosition;
-  // random speed in range 0.0f ... 1.0f
-  newUfo->speed = (float)(rand() / (double)RAND_MAX);
-  // random rotation speed in range 0.0f ... 1.0f
-  newUfo->speed = UFO_ROTATION_SPEED_MAX * (float)(rand() / (double)RAND_MAX);
+    seedSimulationRandom(settings.seed);
+    queueCommand(COMMAND_RESTART, asteroidCount);
 
-  // generate randomly in range -1.0f ... 1.0f
-  newUfo->direction = glm::vec3(
-    (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-    (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-    0.0f
-  );
-  newUfo->direction = glm::normalize(newUfo->direction);
+    printf("Recording to %s\n", options.recordFile.c_str());
+  }
 
-  return newUfo;
+  return true;
 }
 
-void restartGame(void) {
-
-  cleanUpObjects();
-
-  gameState.elapsedTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME); // milliseconds => seconds
+// Runs one simulation step. Its input is read from the replay, or taken from the key map and the queued
+// commands and recorded. Returns false when the replay has ended.
+bool advanceSimulation(float elapsedTime) {
 
-  // initialize space ship
-  if(gameObjects.spaceShip == NULL)
-    gameObjects.spaceShip = new SpaceShipObject;
+  TickInput input;
 
-  gameObjects.spaceShip->position = glm::vec3(0.0f, 0.0f, 0.0f);
-  gameObjects.spaceShip->viewAngle = 90.0f; // degrees
-  gameObjects.spaceShip->direction = glm::vec3(cos(glm::radians(gameObjects.spaceShip->viewAngle)), sin(glm::radians(gameObjects.spaceShip->viewAngle)), 0.0f);
-  gameObjects.spaceShip->speed = 0.0f;
-  gameObjects.spaceShip->size = SPACESHIP_SIZE;
-  gameObjects.spaceShip->destroyed = false;
-  gameObjects.spaceShip->startTime = gameState.elapsedTime;
-  gameObjects.spaceShip->currentTime = gameObjects.spaceShip->startTime;
-
-  // initialize asteroids
-  for(int i=0; i<ASTEROIDS_COUNT_MIN; i++) {
-    AsteroidObject* newAsteroid = createAsteroid();
-    
-    gameObjects.asteroids.push_back(newAsteroid); 
+  if(isReplaying() == true) {
+    if(nextReplayTick(input) == false)
+      return false;
   }
-
-  if(gameState.freeCameraMode == true) {
-    gameState.freeCameraMode = false;
-    glutPassiveMotionFunc(NULL);
+  else {
+    input = gatherTickInput(elapsedTime);
   }
-  gameState.cameraElevationAngle = 0.0f;
-
-  // reset key map
-  for(int i=0; i<KEYS_COUNT; i++)
-    gameState.keyMap[i] = false;
-
-  gameState.gameOver = false;
-  gameState.missileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
-  gameState.ufoMissileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
-}
 
-void createMissile(const glm::vec3 &missilePosition, const glm::vec3 &missileDirection, float &missileLaunchTime) {
+  simulationStep(input);
 
-  float currentTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME); // milliseconds => seconds
-  if(currentTime-missileLaunchTime < MISSILE_LAUNCH_TIME_DELAY)
-    return;
-
-  missileLaunchTime = currentTime;
-
-  MissileObject* newMissile = new MissileObject;
+  if(isReplaying() == true)
+    verifyReplayTick(simulationStateHash());
+  else if(isRecording() == true)
+    recordTick(input, simulationStateHash());
 
-  newMissile->destroyed   = false;
-  newMissile->startTime   = gameState.elapsedTime;
-  newMissile->currentTime = newMissile->startTime;
-  newMissile->size        = MISSILE_SIZE;
-  newMissile->speed       = MISSILE_SPEED;
-  newMissile->position    = missilePosition;
-  newMissile->direction   = glm::normalize(missileDirection);
-  
-  gameObjects.missiles.push_back(newMissile); 
+  return true;
 }
 
-BannerObject* createBanner(void) {
- BannerObject* newBanner = new BannerObject;
- 
-  newBanner->size = BANNER_SIZE;
-  newBanner->position = glm::vec3(0.0f, 0.0f, 0.0f);
-  newBanner->direction = glm::vec3(0.0f, 1.0f, 0.0f);
-  newBanner->speed = 0.0f;
-  newBanner->size = 1.0f;
-
-  newBanner->destroyed = false;
+// Closes the recording and the replay and reports them.
+void endSession(void) {
 
-  newBanner->startTime = gameState.elapsedTime;
-  newBanner->currentTime = newBanner->startTime;
+  if(isRecording() == true) {
+    const unsigned int ticks = endRecording();
+    printf("Recorded %u steps to %s\n", ticks, options.recordFile.c_str());
+  }
 
-  return newBanner;
+  if(isReplaying() == true) {
+    printf("%s", replayReport().c_str());
+    closeReplay();
+  }
 }
 
 void drawWindowContents() {
 
+  beginProfile(PROFILE_DRAW);
+
   // setup parallel projection
   glm::mat4 orthoProjectionMatrix = glm::ortho(
     -SCENE_WIDTH, SCENE_WIDTH,
@@ -420,382 +192,236 @@ void drawWindowContents() {
     projectionMatrix = glm::perspective(glm::radians(60.0f), gameState.windowWidth/(float)gameState.windowHeight, 0.1f, 10.0f);
   }
 
-  glUseProgram(shaderProgram.program);
-  glUniform1f(shaderProgram.timeLocation, gameState.elapsedTime);
-
-  glUniform3fv(shaderProgram.reflectorPositionLocation, 1, glm::value_ptr(gameObjects.spaceShip->position));
-  glUniform3fv(shaderProgram.reflectorDirectionLocation, 1, glm::value_ptr(gameObjects.spaceShip->direction));
-  glUseProgram(0);
-
-  // draw space ship
-  drawSpaceShip(gameObjects.spaceShip, viewMatrix, projectionMatrix);
-
-// ======== BEGIN OF SOLUTION - TASK 6_3-1 ======== //
-  // enable stencil test
-  glEnable(GL_STENCIL_TEST);
-
-
-  // set the stencil operations - if the stencil test and depth test are passed than
-  // value in the stencil buffer is replaced with the object ID (byte 1..255, 0 ... background)
-  glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+  // the top view shows the whole scene, the view from the ship only a part of it
+  beginProfile(PROFILE_DRAW_CULLING);
+  Frustum frustum;
+  if(gameState.freeCameraMode == true)
+    extractFrustum(projectionMatrix * viewMatrix, frustum);
+
+  cullObjects((gameState.freeCameraMode == true) ? &frustum : NULL,
+    gameObjects.asteroids, gameObjects.missiles, gameObjects.ufos, gameObjects.explosions, visibleObjects);
+  endProfile(PROFILE_DRAW_CULLING);
+
+  const unsigned int visibleCount = visibleObjectCount(visibleObjects);
+  const unsigned int objectsTotal = objectCount(gameObjects.asteroids) + objectCount(gameObjects.missiles) +
+    objectCount(gameObjects.ufos) + objectCount(gameObjects.explosions);
+  profileCount(PROFILE_COUNTER_VISIBLE, visibleCount);
+  profileCount(PROFILE_COUNTER_CULLED, objectsTotal - visibleCount);
+
+  // missiles, ufos and explosions light their neighbourhood, only the lighting shaders use the clusters
+  if(useLighting == true) {
+    beginProfile(PROFILE_DRAW_LIGHTS);
+    gatherPointLights(gameObjects.missiles, gameObjects.ufos, gameObjects.explosions, pointLights);
+    binPointLights(pointLights, viewMatrix, projectionMatrix, gameState.windowWidth, gameState.windowHeight, lightClusters);
+    uploadLightClusters(lightClusters);
+    endProfile(PROFILE_DRAW_LIGHTS);
+
+    profileCount(PROFILE_COUNTER_LIGHTS, lightClusters.lightCount);
+  }
 
+  // camera, lights and time shared by all programs drawing the scene
+  setFrameUniforms(viewMatrix, projectionMatrix, gameState.elapsedTime, gameObjects.spaceShip->position, gameObjects.spaceShip->direction,
+    lightClusters.scale, lightClusters.logarithmicSlices);
 
-// ========  END OF SOLUTION - TASK 6_3-1  ======== //
-  CHECK_GL_ERROR(); 
-  // draw asteroids
-  int id = 0;
-  for(GameObjectsList::iterator it = gameObjects.asteroids.begin(); it != gameObjects.asteroids.end(); ++it) {
-// ======== BEGIN OF SOLUTION - TASK 6_3-2 ======== //
-    // set the stencil test function
-    // -> stencil test always passes and reference value for stencil test is set to be object ID (id+1)
-      glStencilFunc(GL_ALWAYS, id+1, -1);
+  // asteroids and ufos moving on the GPU need records of the objects spawned since the last frame only
+  if(useGpuMotion == true)
+    profileCount(PROFILE_COUNTER_MOTION, updateGpuMotion(gameObjects.asteroids, gameObjects.ufos));
 
+  // distant asteroids and space ship are drawn with fewer triangles
+  profileCount(PROFILE_COUNTER_TRIANGLES, selectMeshLods(gameObjects.asteroids, gameObjects.spaceShip, visibleObjects, gameState.windowHeight));
 
-// ========  END OF SOLUTION - TASK 6_3-2  ======== //
-    CHECK_GL_ERROR(); 
+  // single objects are queued by the draw functions and drawn sorted by their state
+  beginProfile(PROFILE_DRAW_OBJECTS);
+  beginRenderQueue();
 
-    AsteroidObject* asteroid = (AsteroidObject*)(*it);
-    drawAsteroid(asteroid, viewMatrix, projectionMatrix);
+  // draw space ship
+  drawSpaceShip(gameObjects.spaceShip);
 
-    id++;
+  if(useInstancing == true) {
+    // draw asteroids, missiles and ufos - one draw call per geometry, objects over the capacity are queued
+    drawInstancedObjects(gameObjects.asteroids, gameObjects.missiles, gameObjects.ufos, visibleObjects);
   }
-  // disable stencil test
-  glDisable(GL_STENCIL_TEST);
-
-  // draw missiles
-  for(GameObjectsList::iterator it = gameObjects.missiles.begin(); it != gameObjects.missiles.end(); ++it) {
-    MissileObject* missile = (MissileObject *)(*it);
-    drawMissile(missile, viewMatrix, projectionMatrix); 
+  else {
+    // draw asteroids, missiles and ufos - packets are recorded by the worker threads, drawn by this one
+    if(visibleObjects.asteroids.empty() == false)
+      drawAsteroids(gameObjects.asteroids, &visibleObjects.asteroids[0], (unsigned int)visibleObjects.asteroids.size());
+    if(visibleObjects.missiles.empty() == false)
+      drawMissiles(gameObjects.missiles, &visibleObjects.missiles[0], (unsigned int)visibleObjects.missiles.size());
+    if(visibleObjects.ufos.empty() == false)
+      drawUfos(gameObjects.ufos, &visibleObjects.ufos[0], (unsigned int)visibleObjects.ufos.size());
   }
 
-  // draw ufos
-  for(GameObjectsList::iterator it = gameObjects.ufos.begin(); it != gameObjects.ufos.end(); ++it) {
-    UfoObject* ufo = (UfoObject *)(*it);
-    drawUfo(ufo, viewMatrix, projectionMatrix); 
+  if(useParticles == false && visibleObjects.explosions.empty() == false) {
+    // billboards of the explosions, drawn in the effects pass
+    drawExplosions(gameObjects.explosions, &visibleObjects.explosions[0], (unsigned int)visibleObjects.explosions.size());
   }
 
+  beginProfile(PROFILE_DRAW_QUEUE);
+  sortRenderQueue();
+  endProfile(PROFILE_DRAW_QUEUE);
+
+  executeRenderQueue(RENDER_PASS_OPAQUE);
+  endProfile(PROFILE_DRAW_OBJECTS);
+
   // draw skybox
+  beginProfile(PROFILE_DRAW_SKYBOX);
   drawSkybox(viewMatrix, projectionMatrix); 
+  endProfile(PROFILE_DRAW_SKYBOX);
 
   // draw explosions with depth test disabled
-  glDisable(GL_DEPTH_TEST);
-
-  for(GameObjectsList::iterator it = gameObjects.explosions.begin(); it != gameObjects.explosions.end(); ++it) {
-    ExplosionObject* explosion = (ExplosionObject *)(*it);
-    drawExplosion(explosion, viewMatrix, projectionMatrix); 
+  beginProfile(PROFILE_DRAW_EXPLOSIONS);
+  if(useParticles == true) {
+    // debris and sparks of all explosions - one transform feedback pass and one draw call
+    glDisable(GL_DEPTH_TEST);
+    updateParticles(gameState.elapsedTime);
+    drawParticles(viewMatrix, projectionMatrix, gameState.windowHeight, gameState.elapsedTime);
+    glEnable(GL_DEPTH_TEST);
   }
-  glEnable(GL_DEPTH_TEST);
+  else {
+    executeRenderQueue(RENDER_PASS_EFFECTS);
+  }
+  endProfile(PROFILE_DRAW_EXPLOSIONS);
+
+  const RenderQueueStats queueStats = renderQueueStats();
+  profileCount(PROFILE_COUNTER_PACKETS, queueStats.packets);
+  profileCount(PROFILE_COUNTER_BINDS, queueStats.binds);
 
   if(gameState.gameOver == true) {
     // draw game over banner
-    if(gameObjects.bannerObject != NULL)
+    if(gameObjects.bannerObject != NULL) {
+      beginProfile(PROFILE_DRAW_BANNER);
       drawBanner(gameObjects.bannerObject, orthoViewMatrix, orthoProjectionMatrix);
+      endProfile(PROFILE_DRAW_BANNER);
+    }
   }
-}
 
-// Called to update the display. You should call glutSwapBuffers after all of your
-// rendering to display what you rendered.
-void displayCallback() {
-  GLbitfield mask = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
-  mask |= GL_STENCIL_BUFFER_BIT;
-
-  glClear(mask);
-
-  drawWindowContents();
-
-  glutSwapBuffers();
+  endProfile(PROFILE_DRAW);
 }
 
-// Called whenever the window is resized. The new window size is given, in pixels.
-// This is an opportunity to call glViewport or glScissor to keep up with the change in size.
-void reshapeCallback(int newWidth, int newHeight) {
-
-  gameState.windowWidth = newWidth;
-  gameState.windowHeight = newHeight;
-
-  glViewport(0, 0, (GLsizei) newWidth, (GLsizei) newHeight);
-}
+// progress bar in the middle of the window, drawn by scissored clears -> no shader needed
+void drawLoadingScreen(float progress) {
 
-// Test collisons between objects in the scene and insert explosion billboards.
-void checkCollisions(void) {
+  const int width  = gameState.windowWidth / 2;
+  const int height = 16;
+  const int x = (gameState.windowWidth - width) / 2;
+  const int y = (gameState.windowHeight - height) / 2;
 
-  // test collisions between asteroid and spaceship
-  GameObjectsList::iterator it;
+  glEnable(GL_SCISSOR_TEST);
 
-  for(it = gameObjects.asteroids.begin(); it != gameObjects.asteroids.end(); ++it) {
-    AsteroidObject * asteroid = (AsteroidObject *)(*it);
+  glScissor(x - 2, y - 2, width + 4, height + 4);
+  glClearColor(0.6f, 0.6f, 0.6f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
 
-    if(asteroid->destroyed == false) {
-      // check whether a given asteroid collides with spaceship or not
-      // calls spheresIntersection() function with appropriate parameters
-      if(spheresIntersection(gameObjects.spaceShip->position, gameObjects.spaceShip->size, asteroid->position, asteroid->size) == true) {
-        asteroid->destroyed = true;	                       // mark asteroid dead
-        insertExplosion(gameObjects.spaceShip->position);  // insert explostion billboard
-        gameState.gameOver = true;                         // -> game over
-      }
-    }
-  }
+  glScissor(x, y, width, height);
+  glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
 
-  // test collisions beween ufo and spaceship
-  for(it = gameObjects.ufos.begin(); it != gameObjects.ufos.end(); ++it) {
-    UfoObject * ufo = (UfoObject *)(*it);
-
-    if(ufo->destroyed == false) {
-      // check whether a given ufo collides with spaceship or not
-      // calls spheresIntersection() function with appropriate parameters
-      if(spheresIntersection(gameObjects.spaceShip->position, gameObjects.spaceShip->size, ufo->position, ufo->size) == true) {
-        ufo->destroyed = true;	                           // mark ufo dead
-        insertExplosion(gameObjects.spaceShip->position);  // insert explosion billboard
-        gameState.gameOver = true;                         // -> game over
-      }
-    }
+  const int filled = (int)(progress * width);
+  if(filled > 0) {
+    glScissor(x, y, filled, height);
+    glClearColor(0.9f, 0.6f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
   }
 
-  // check collisions missile x asteroid and missile x ufo (brute force)  
-  for(it = gameObjects.missiles.begin(); it != gameObjects.missiles.end(); ++it) {
-    MissileObject * missile = (MissileObject *)(*it);
-
-      // test missile with each asteroid
-    for(GameObjectsList::iterator itA = gameObjects.asteroids.begin(); itA != gameObjects.asteroids.end(); ++itA) {
-      AsteroidObject * asteroid = (AsteroidObject *)(*itA);
-
-      if(asteroid->destroyed == false) {
-        // check whether a given missile hits asteroid or not
-        // calls pointInSphere() function with proper parameters
-        if(pointInSphere(missile->position, asteroid->position, asteroid->size) == true) {	
-          missile->destroyed = true;           // remove missile
-          asteroid->destroyed = true;          // remove asteroid
-          insertExplosion(missile->position);  // insert explosion billboard
-
-          // asteroid break-up into random number of parts
-          if(asteroid->size > ASTEROID_SIZE_MIN) {
-            int howManyAsteroids = rand() % ASTEROID_PARTS + 1;
-
-            for(int i=0; i<howManyAsteroids; i++) {
-              AsteroidObject* newAsteroid = createAsteroid();
-
-              // same position, smaller size
-              newAsteroid->position = asteroid->position;
-              newAsteroid->size = asteroid->size * ASTEROID_SIZE_FACTOR;
-
-              gameObjects.asteroids.push_front(newAsteroid); 
-            }
-          }
-        }
-      }
-    }
-
-    // test missile against each ufo
-    for(GameObjectsList::iterator itU = gameObjects.ufos.begin(); itU != gameObjects.ufos.end(); ++itU) {
-      UfoObject * ufo = (UfoObject *)(*itU);
-
-      if(ufo->destroyed == false) {
-        // check whether a given missile hits ufo or not
-        // calls pointInSphere() function with proper parameters
-        if(pointInSphere(missile->position, ufo->position, ufo->size) == true) {
-          missile->destroyed = true;           // remove missile
-          ufo->destroyed = true;               // mark ufo dead
-          insertExplosion(missile->position);  // insert explosion billboard
-        }
-      }
-    }
-
-    // check whether a given missile hits spaceship or not
-    // calls pointInSphere() function with proper parameters
-    if(pointInSphere(missile->position, gameObjects.spaceShip->position, gameObjects.spaceShip->size) == true) {
-      missile->destroyed = true;           // remove missile
-      insertExplosion(missile->position);  // insert explosion billboard
-      gameState.gameOver = true;           // -> game over
-    }
-  }
+  glDisable(GL_SCISSOR_TEST);
+  glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 }
 
-void updateObjects(float elapsedTime) {
+// Draws the ID pass of a pending click and handles the clicks whose readback has finished.
+// The IDs are asteroid handles, asteroids destroyed since the click are recognized as stale handles.
+void updatePicking(void) {
 
-  // update space ship 
-  float timeDelta = elapsedTime - gameObjects.spaceShip->currentTime;
-  gameObjects.spaceShip->currentTime = elapsedTime;
-  gameObjects.spaceShip->position += timeDelta * gameObjects.spaceShip->speed * gameObjects.spaceShip->direction;
+  // the ID pass is drawn with the camera of the frame uniforms set by drawWindowContents()
+  if(beginPickPass() == true) {
+    drawAsteroidIds(gameObjects.asteroids);
+    endPickPass();
+  }
 
-  // check the new position and wrap it if it is necessary
-  gameObjects.spaceShip->position = checkBounds(gameObjects.spaceShip->position, gameObjects.spaceShip->size);
+  ObjectHandle picked[PICK_REQUESTS_MAX];
+  const unsigned int pickedCount = resolvePicks(picked, PICK_REQUESTS_MAX);
 
-  // update asteroids
-  GameObjectsList::iterator it = gameObjects.asteroids.begin();
-  while(it != gameObjects.asteroids.end()) {
-    AsteroidObject* asteroid = (AsteroidObject*)(*it);
+  for(unsigned int i = 0; i < pickedCount; i++) {
 
-    if(asteroid->destroyed == true) {
-      it = gameObjects.asteroids.erase(it);
+    if(picked[i] == INVALID_OBJECT_HANDLE) {
+      // background was clicked
+      printf("Clicked on background\n");
+      continue;
     }
-    else {
-      // update asteroid
-      float timeDelta = elapsedTime - asteroid->currentTime;
-
-      asteroid->currentTime = elapsedTime;
-      asteroid->position += timeDelta * asteroid->speed * asteroid->direction;
 
-      // check the new position and wrap it if it is necessary
-      asteroid->position = checkBounds(asteroid->position, asteroid->size);
+    const unsigned int index = objectIndex(gameObjects.asteroids, picked[i]);
 
-      ++it;
+    if(index == INVALID_OBJECT_INDEX || gameObjects.asteroids.destroyed[index] == true) {
+      printf("Clicked on object with ID: %u, already destroyed\n", picked[i]);
+      continue;
     }
-  }
 
-  // update missiles
-  it = gameObjects.missiles.begin();
-  while(it != gameObjects.missiles.end()) {
-    MissileObject* missile = (MissileObject*)(*it);
+    printf("Clicked on object with ID: %u\n", picked[i]);
 
-    // update missile
-    float timeDelta = elapsedTime - missile->currentTime;
-
-    missile->currentTime = elapsedTime;
-    missile->position += timeDelta * missile->speed * missile->direction;
+    // asteroid explodes in the next simulation step
+    queueCommand(COMMAND_DESTROY_ASTEROID, picked[i]);
+  }
+}
 
-    // check the new position and wrap it if it is necessary
-    missile->position = checkBounds(missile->position, missile->size);
+// Called to update the display. You should call glutSwapBuffers after all of your
+// rendering to display what you rendered.
+void displayCallback() {
+  GLbitfield mask = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
 
-    if((missile->currentTime-missile->startTime)*missile->speed > MISSILE_MAX_DISTANCE) 
-      missile->destroyed = true;
+  glClear(mask);
 
-    if(missile->destroyed == true) {
-      it = gameObjects.missiles.erase(it);
-    }
-    else {
-      ++it;
+  // models are being loaded - upload what is ready and show the progress
+  if(assetLoadingFinished() == false) {
+    if(updateAssetLoading(ASSET_UPLOAD_TIME_BUDGET) == true) {
+      printf("Assets loaded in %.2f s\n", 0.001f * (float)glutGet(GLUT_ELAPSED_TIME));
+      // game starts when it is visible
+      restartGame();
+      if(beginSession(ASTEROIDS_COUNT_MIN) == false)
+        printf("Playing without %s\n", options.replayFile.empty() ? "recording" : "replay");
     }
+    drawLoadingScreen(assetLoadingProgress());
+    glutSwapBuffers();
+    return;
   }
 
-  // update ufos
-  it = gameObjects.ufos.begin();
-  while(it != gameObjects.ufos.end()) {
-    UfoObject* ufo = (UfoObject*)(*it);
-
-    if(ufo->destroyed == true) {
-      it = gameObjects.ufos.erase(it);
-    }
-    else {
-      // update ufo
-      ufo->currentTime = elapsedTime;
+  drawWindowContents();
 
-      float curveParamT = ufo->speed * (ufo->currentTime - ufo->startTime);
+  updatePicking();
 
-      ufo->position = ufo->initPosition + evaluateClosedCurve( curveData, curveSize, curveParamT );
-      ufo->direction = glm::normalize(evaluateClosedCurve_1stDerivative(curveData, curveSize, curveParamT));
+  profileCommit(PROFILE_DRAW_FIRST, PROFILE_DRAW_LAST);
 
-      // check the new position and wrap it if it is necessary
-      ufo->position = checkBounds(ufo->position, ufo->size);
+  if(showProfilerOverlay == true)
+    drawProfilerOverlay(gameState.windowWidth, gameState.windowHeight);
 
-      ++it;
-    }
-  }
+  glutSwapBuffers();
+}
 
-  // update explosion billboards
-  it = gameObjects.explosions.begin();
-  while(it != gameObjects.explosions.end()) {
-    ExplosionObject* explosion = (ExplosionObject*)(*it);
+// Called whenever the window is resized. The new window size is given, in pixels.
+// This is an opportunity to call glViewport or glScissor to keep up with the change in size.
+void reshapeCallback(int newWidth, int newHeight) {
 
-    // update explosion
-    explosion->currentTime = elapsedTime;
+  gameState.windowWidth = newWidth;
+  gameState.windowHeight = newHeight;
 
-    if(explosion->currentTime > explosion->startTime + explosion->textureFrames*explosion->frameDuration)
-      explosion->destroyed = true;
+  glViewport(0, 0, (GLsizei) newWidth, (GLsizei) newHeight);
 
-    if(explosion->destroyed == true) {
-      it = gameObjects.explosions.erase(it);
-    }
-    else {
-      ++it;
-    }
-  }
+  resizePicking(newWidth, newHeight);
 }
 
 // Callback responsible for the scene update
 void timerCallback(int) {
 
-  // update scene time
-  gameState.elapsedTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME); // milliseconds => seconds
-
-  // call appropriate actions according to the currently pressed keys in key map
-  // (combinations of keys are supported but not used in this implementation)
-  if(gameState.keyMap[KEY_RIGHT_ARROW] == true)
-    turnSpaceShipRight(SPACESHIP_VIEW_ANGLE_DELTA);
-
-  if(gameState.keyMap[KEY_LEFT_ARROW] == true)
-    turnSpaceShipLeft(SPACESHIP_VIEW_ANGLE_DELTA);
-
-  if(gameState.keyMap[KEY_UP_ARROW] == true)
-    increaseSpaceShipSpeed();
-
-  if(gameState.keyMap[KEY_DOWN_ARROW] == true)
-    decreaseSpaceShipSpeed();
-
-  if((gameState.gameOver == true) && (gameObjects.bannerObject != NULL)) {
-    gameObjects.bannerObject->currentTime = gameState.elapsedTime;
-  }
-
-  // update objects in the scene
-  updateObjects(gameState.elapsedTime);
-
-  // space pressed -> launch missile
-  if(gameState.keyMap[KEY_SPACE] == true) {
-    // missile position and direction
-    glm::vec3 missilePosition = gameObjects.spaceShip->position;
-    glm::vec3 missileDirection = gameObjects.spaceShip->direction;
-
-    missilePosition += missileDirection*1.5f*SPACESHIP_SIZE;
-
-    createMissile(missilePosition, missileDirection, gameState.missileLaunchTime);
-  }
-
-  // test collisions among objects in the scene
-  checkCollisions();
-
-  // generate new ufos randomly
-  if(gameObjects.ufos.size() < UFOS_COUNT_MIN) {
-    int howManyUfos = rand() % (UFOS_COUNT_MAX - UFOS_COUNT_MIN + 1);
-
-    for(int i=0; i<howManyUfos; i++) {
-      UfoObject* newUfo = createUfo();
-
-      gameObjects.ufos.push_back(newUfo); 
-    }
-  }
-
-  if(gameObjects.ufos.size() > 0 && (rand() % 100) == 0) { // generate ufo missile or not?
-    int ufoIndex = rand() % gameObjects.ufos.size();       // which ufo should shoot?
-
-    GameObjectsList::iterator it = gameObjects.ufos.begin();
-    std::advance(it, ufoIndex); // now it points to the nth ufo of the list (counting from zero)
-    UfoObject* ufo = (UfoObject*)(*it);
-
-    // missile position and direction
-    glm::vec3 missilePosition = ufo->position;
-    glm::vec3 missileDirection = ufo->direction;
-
-    missilePosition += missileDirection*1.5f*UFO_SIZE;
-
-    createMissile(missilePosition, missileDirection, gameState.ufoMissileLaunchTime);
-  }
-
-  // generate new asteroids randomly
-  if(gameObjects.asteroids.size() < ASTEROIDS_COUNT_MIN) {
-    int howManyAsteroids = rand() % (ASTEROIDS_COUNT_MAX - ASTEROIDS_COUNT_MIN + 1);
-
-    for(int i=0; i<howManyAsteroids; i++) {
-      AsteroidObject* newAsteroid = createAsteroid();
-
-      gameObjects.asteroids.push_back(newAsteroid); 
-    }
-  }
-
-  // game over? -> create banner with scrolling text "game over"
-  if(gameState.gameOver == true) {
-    gameState.keyMap[KEY_SPACE] = false;
-    if(gameObjects.bannerObject == NULL) {
-      // if game over and banner still not created -> create banner
-      gameObjects.bannerObject = createBanner();
+  // update scene time and the objects in the scene, the game waits for the models
+  if(assetLoadingFinished() == true) {
+    // a replay runs with the recorded time
+    if(advanceSimulation(0.001f * (float)glutGet(GLUT_ELAPSED_TIME)) == false) { // milliseconds => seconds
+      // replay has ended
+#ifndef __APPLE__
+      glutLeaveMainLoop();
+#else
+      endSession();
+      exit(0);
+#endif
+      return;
     }
   }
 
@@ -836,7 +462,8 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
 #endif
       break;
     case 'r': // restart game
-      restartGame();
+      queueCommand(COMMAND_RESTART, ASTEROIDS_COUNT_MIN);
+      resetCamera();
       break;
     case ' ': // launch missile
       if(gameState.gameOver != true)
@@ -844,7 +471,7 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
       break;
     case 't': // teleport space ship
       if(gameState.gameOver != true)
-        teleport();
+        queueCommand(COMMAND_TELEPORT);
       break;
     case 'c': // switch camera
       gameState.freeCameraMode = !gameState.freeCameraMode;
@@ -856,17 +483,33 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
         glutPassiveMotionFunc(NULL);
       }
       break;
-    case'e': { // insert explosion randomly
-        glm::vec3 explosionPosition = glm::vec3(
-          (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-          (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-          0.0f
-        );
-        insertExplosion(explosionPosition);
-      }
+    case'e': // insert explosion randomly
+      queueCommand(COMMAND_EXPLOSION);
       break;
     case'g': // game over
-      gameState.gameOver = true;
+      queueCommand(COMMAND_GAME_OVER);
+      break;
+    case'i': // switch instanced drawing
+      useInstancing = !useInstancing && (useLighting == true);
+      useGpuMotion = useGpuMotion && useInstancing;
+      printf("Instanced drawing: %s\n", useInstancing ? "on" : "off");
+      break;
+    case'm': // switch motion of asteroids and ufos evaluated by the vertex shader
+      useGpuMotion = !useGpuMotion && (useInstancing == true);
+      printf("GPU motion: %s\n", useGpuMotion ? "on" : "off");
+      break;
+    case'x': // switch particle explosions and explosion billboards
+      useParticles = !useParticles;
+      printf("Particle explosions: %s\n", useParticles ? "on" : "off");
+      break;
+    case'p': // show/hide profiler overlay
+      showProfilerOverlay = !showProfilerOverlay;
+      break;
+    case'b': { // switch collision broadphase
+        const int collisionMode = (gameState.collisionMode + 1) % COLLISION_MODES_COUNT;
+        queueCommand(COMMAND_COLLISION_MODE, collisionMode);
+        printf("Collision mode: %s\n", collisionModeNames[collisionMode]);
+      }
       break;
     default:
       ; // printf("Unrecognized key pressed\n");
@@ -940,83 +583,240 @@ void specialKeyboardUpCallback(int specKeyReleased, int mouseX, int mouseY) {
 // and each release generates a mouse callback.
 void mouseCallback(int buttonPressed, int buttonState, int mouseX, int mouseY ) {
 
-  // do picking only on mouse down
-  if( ( buttonPressed == GLUT_LEFT_BUTTON ) && ( buttonState == GLUT_DOWN ) ) {
+  // nothing to pick while the models are being loaded
+  if(assetLoadingFinished() == false)
+    return;
 
-    // store value from the stencil buffer (byte)
-    unsigned char asteroidID = 0; 
-// ======== BEGIN OF SOLUTION - TASK 6_3-3 ======== //
-    // read value from the stencil buffer for one pixel under the mouse cursor into asteroidID variable
+  // do picking only on mouse down, the ID pass is drawn after the next frame
+  // and its result is handled a few frames later without waiting for the GPU
+  if( ( buttonPressed == GLUT_LEFT_BUTTON ) && ( buttonState == GLUT_DOWN ) ) {
     // recalculate y, as glut has origin in upper left corner
-
-    glReadPixels(mouseX, (gameState.windowHeight - mouseY - 1), 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &asteroidID);
-
-// ========  END OF SOLUTION - TASK 6_3-3  ======== //
-
-    // the buffer was initially cleared to zeros
-    if(asteroidID == 0) {
-   		// background was clicked
-      printf("Clicked on background\n");
-    }
-    else {
-      // object was clicked
-      printf("Clicked on object with ID: %d\n", (int)asteroidID);
-
-      GameObjectsList::iterator it = gameObjects.asteroids.begin();
-      std::advance(it, asteroidID-1); // now it points to the nth asteroid of the list (counting from zero)
-      AsteroidObject* asteroid = (AsteroidObject*)(*it);
-
-      if(asteroid->destroyed == false) {
-        asteroid->destroyed = true;	          // remove asteroid
-        insertExplosion(asteroid->position);  // insert explosion billboard
-      }
-    }
+    requestPick(mouseX, gameState.windowHeight - mouseY - 1);
   }
 }
 
 // Called after the window and OpenGL are initialized. Called exactly once, before the main loop.
 void initializeApplication() {
 
-  // initialize random seed
-  srand ((unsigned int)time(NULL));
-
   // initialize OpenGL
   glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-  glClearStencil(0);  // this is the default value
   glEnable(GL_DEPTH_TEST);
 
   useLighting = true;
+  useInstancing = true;
 
-  // initialize shaders
+  // initialize shaders, their binaries are cached -> warm starts skip the GLSL compilation
+  initializeProgramCache();
   initializeShaderPrograms();
-  // create geometry for all models used
-  initializeModels();
 
-  gameObjects.spaceShip = NULL;
-  gameObjects.bannerObject = NULL;
+  const ProgramCacheStats programStats = programCacheStats();
+  printf("Shader programs: %u loaded from cache, %u compiled\n", programStats.loaded, programStats.compiled);
+  // create geometry for all models used, meshes and textures are loaded in the background
+  initializeModels(std::max(1u, std::thread::hardware_concurrency()));
+
+  initializeGpuProfiler();
+
+  // impacts emit particles, the particles are uploaded and drawn with the explosions
+  initializeParticles();
+
+  // clicked asteroids are found by the ID buffer, it is sized by the reshape callback
+  initializePicking();
+
+  // point lights of the objects are binned each frame into the buffers of the light clusters
+  initializeClusteredLights();
+
+  initializeSimulation(options.seed);
+  setExplosionListener(emitImpactParticles);
+
+  // the ufo curve is uploaded once, object records follow the pools when the GPU motion is switched on
+  initializeGpuMotion(ufoCurve);
+  gameState.collisionMode = options.collisionMode;
 
   // test whether the curve segment is correctly computed (tasks 1 and 2)
   testCurve(evaluateCurveSegment, evaluateCurveSegment_1stDerivative);
+  // the same test for the batch kernel used by the ufos
+  testCurve(evaluateCurveSegmentBatched, evaluateCurveSegmentBatched_1stDerivative);
 
   restartGame();
 }
 
 void finalizeApplication(void) {
 
-  cleanUpObjects();
+  // window closed while loading
+  finishAssetLoading();
+
+  endSession();
 
-  delete gameObjects.spaceShip;
-  gameObjects.spaceShip = NULL;
+  printf("\n%s", objectPoolReport(gameState.elapsedTime).c_str());
+
+  finalizeSimulation();
 
   // delete buffers - space ship, asteroid, missile, ufo, banner, and explosion
   cleanupModels();
 
   // delete shaders
   cleanupShaderPrograms();
+
+  cleanupGpuProfiler();
+
+  cleanupParticles();
+
+  cleanupPicking();
+
+  cleanupClusteredLights();
+
+  cleanupGpuMotion();
+
+  if(options.profileFile.empty() == false && writeProfileCsv(options.profileFile) == false)
+    printf("Cannot write profile to %s\n", options.profileFile.c_str());
+
+  finalizeJobSystem();
+}
+
+// Runs the game logic without window using a fixed time step and reports simulation throughput.
+// The space ship is driven by a simple autopilot (turning and firing), the game is restarted when it is over.
+// A replay runs all recorded steps with the recorded input instead.
+void runHeadless(void) {
+
+  typedef std::chrono::steady_clock Clock;
+
+  initializeSimulation(options.seed);
+  gameState.collisionMode = options.collisionMode;
+
+  resetSimulation(0.0f, options.asteroidCount);
+
+  if(beginSession(options.asteroidCount) == false) {
+    finalizeSimulation();
+    return;
+  }
+
+  printf("Headless simulation: %u ticks, dt = %f s, %u asteroids, seed %u, collisions: %s, threads: %u\n",
+    options.ticks, options.timeStep, options.asteroidCount, options.seed, collisionModeNames[gameState.collisionMode], jobSystemThreadCount());
+
+  unsigned int restarts = 0;
+  unsigned int reportTicks = 0;
+
+  const Clock::time_point startTime = Clock::now();
+  Clock::time_point reportTime = startTime;
+
+  const bool replaying = isReplaying();
+  unsigned int tick = 1;
+
+  for(; replaying == true || tick <= options.ticks; tick++) {
+
+    if(replaying == false) {
+      gameState.keyMap[KEY_LEFT_ARROW] = true;
+      gameState.keyMap[KEY_SPACE] = true;
+    }
+
+    // a replay ignores the time step and ends with the log
+    const float elapsedTime = (float)(tick * (double)options.timeStep);
+    if(advanceSimulation(elapsedTime) == false)
+      break;
+
+    // restart is queued -> it is recorded as the input of the next step
+    if(gameState.gameOver == true && replaying == false) {
+      queueCommand(COMMAND_RESTART, options.asteroidCount);
+      restarts++;
+    }
+
+    reportTicks++;
+
+    // report throughput once per second of the wall clock time
+    const Clock::time_point now = Clock::now();
+    const double reportSeconds = std::chrono::duration<double>(now - reportTime).count();
+    if(reportSeconds >= 1.0) {
+      printf("tick %u: %.1f ticks/s, asteroids %u, missiles %u, ufos %u, explosions %u\n",
+        tick, reportTicks / reportSeconds,
+        objectCount(gameObjects.asteroids), objectCount(gameObjects.missiles),
+        objectCount(gameObjects.ufos), objectCount(gameObjects.explosions));
+
+      reportTicks = 0;
+      reportTime = now;
+    }
+  }
+
+  const unsigned int ticks = tick - 1;
+
+  const double totalSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+  printf("Simulated %u ticks (%.1f s of game time) in %.3f s: %.1f ticks/s, %u restarts\n",
+    ticks, gameState.elapsedTime, totalSeconds, ticks / std::max(totalSeconds, 1e-9), restarts);
+
+  endSession();
+
+  printf("\n%s", profileReport().c_str());
+  // rates are per second of the game time
+  printf("\n%s", objectPoolReport(gameState.elapsedTime).c_str());
+
+  if(options.profileFile.empty() == false && writeProfileCsv(options.profileFile) == false)
+    printf("Cannot write profile to %s\n", options.profileFile.c_str());
+
+  finalizeSimulation();
+}
+
+// Reads command line options, unknown arguments are left to GLUT.
+void parseCommandLine(int argc, char** argv) {
+
+  options.headless = false;
+  options.ticks = 10000;
+  options.timeStep = 0.033f;
+  options.asteroidCount = ASTEROIDS_COUNT_MIN;
+  options.seed = (unsigned int)time(NULL);
+  options.collisionMode = COLLISIONS_GRID;
+  options.threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  for(int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool hasValue = (i + 1 < argc);
+
+    if(arg == "--headless")
+      options.headless = true;
+    else if(arg == "--ticks" && hasValue)
+      options.ticks = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if(arg == "--dt" && hasValue)
+      options.timeStep = (float)atof(argv[++i]);
+    else if(arg == "--asteroids" && hasValue)
+      options.asteroidCount = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if(arg == "--seed" && hasValue)
+      options.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if(arg == "--profile" && hasValue)
+      options.profileFile = argv[++i];
+    else if(arg == "--record" && hasValue)
+      options.recordFile = argv[++i];
+    else if(arg == "--replay" && hasValue)
+      options.replayFile = argv[++i];
+    else if(arg == "--threads" && hasValue)
+      options.threadCount = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if(arg == "--collisions" && hasValue) {
+      const std::string mode = argv[++i];
+      if(mode == "brute")
+        options.collisionMode = COLLISIONS_BRUTE_FORCE;
+      else if(mode == "verify")
+        options.collisionMode = COLLISIONS_VERIFY;
+      else if(mode == "kinetic")
+        options.collisionMode = COLLISIONS_KINETIC;
+      else
+        options.collisionMode = COLLISIONS_GRID;
+    }
+  }
+
+  if(options.timeStep <= 0.0f)
+    options.timeStep = 0.033f;
 }
 
 int main(int argc, char** argv) {
 
+  parseCommandLine(argc, argv);
+
+  initializeJobSystem(options.threadCount);
+
+  // no window, no OpenGL - just the game logic
+  if(options.headless == true) {
+    runHeadless();
+    finalizeJobSystem();
+    return 0;
+  }
+
   // initialize windowing system
   glutInit(&argc, argv);
 
@@ -1,7 +1,20 @@
 #version 140
 
-uniform mat4 PVMmatrix;     // Projection * View * Model --> model to clip coordinates
-uniform float time;         // used for simulation of moving lights (such as sun)
+// per-frame data shared by the programs, filled once per frame by setFrameUniforms()
+layout(std140) uniform FrameData {
+  mat4  Vmatrix;            // View              --> world to eye coordinates
+  mat4  Pmatrix;            // Projection        --> eye to clip coordinates
+  mat4  PVmatrix;           // Projection * View --> world to clip coordinates
+  vec4  sunDirection;       // direction to the sun (eye coordinates)
+  vec4  reflectorPosition;  // space ship reflector position (eye coordinates)
+  vec4  reflectorDirection; // space ship reflector direction (eye coordinates, normalized)
+  vec4  clusterScale;       // light clusters per pixel (xy), depth slice scale and bias (zw)
+  float time;               // elapsed time in seconds
+  float clusterLogDepth;    // 1 -> depth slices are logarithmic, 0 -> linear
+};
+
+uniform mat4 PVMmatrix;     // Projection * View * Model --> model to clip coordinates, the banner has its own camera
+uniform float startTime;    // time the banner appeared
 
 in vec3 position;           // vertex position in world space
 in vec2 texCoord;           // incoming texture coordinates
@@ -15,7 +28,7 @@ void main() {
   // vertex position after the projection (gl_Position is predefined output variable)
   gl_Position = PVMmatrix * vec4(position, 1.0);   // outgoing vertex in clip coordinates
 
-  float localTime = time * decay;
+  float localTime = (time - startTime) * decay;
   // localTime = 0;
 
   vec2 offset = vec2((floor(localTime) - localTime) * 4 + 1.0, 0.0);
@@ -0,0 +1,445 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    benchmark.cpp
+ * \brief   Benchmarks of the simulation hot paths, runs without window and OpenGL.
+ *
+ * Results are printed as CSV, one line per benchmark and object count:
+ *   benchmark,count,threads,iterations,seconds,ns_per_item,items_per_second
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pgr.h"
+#include "render_stuff.h"
+#include "simulation.h"
+#include "spline.h"
+#include "culling.h"
+#include "render_queue.h"
+#include "clustered_lights.h"
+#include "mesh_lod.h"
+#include "job_system.h"
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+struct BenchmarkOptions {
+
+  unsigned int seed;          // --seed N        seed of the random generator (fixed by default -> reproducible inputs)
+  unsigned int minCount;      // --min-count N   smallest object count
+  unsigned int maxCount;      // --max-count N   largest object count, counts grow by a factor of 10
+  double       minTime;       // --min-time S    each measurement is repeated until it takes at least this long
+  unsigned int threadCount;   // --threads N     threads of the job system used by updateObjects()
+  std::string  filter;        // --filter NAME   run only benchmarks whose name contains NAME
+
+} options;
+
+// results are accumulated here so that the compiler cannot drop the benchmarked calls
+volatile float benchmarkSink = 0.0f;
+
+static float randomFloat(float minValue, float maxValue) {
+  return minValue + (maxValue - minValue) * (float)(rand() / (double)RAND_MAX);
+}
+
+static glm::vec3 randomPosition(float extent) {
+  return glm::vec3(randomFloat(-extent, extent), randomFloat(-extent, extent), 0.0f);
+}
+
+static glm::vec3 randomDirection(void) {
+  return glm::normalize(glm::vec3(randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), 0.0f) + glm::vec3(1e-6f, 0.0f, 0.0f));
+}
+
+static void printResult(const char* name, unsigned int count, unsigned long long iterations, double seconds) {
+
+  const double items = (double)count * iterations;
+  printf("%s,%u,%u,%llu,%.6f,%.3f,%.1f\n", name, count, jobSystemThreadCount(), iterations, seconds, 1e9 * seconds / items, items / seconds);
+  fflush(stdout);
+}
+
+static bool selected(const char* name) {
+  return options.filter.empty() || std::string(name).find(options.filter) != std::string::npos;
+}
+
+// repeats pass() until options.minTime elapses, one pass processes count items
+template <class Pass>
+static void runBenchmark(const char* name, unsigned int count, const Pass &pass) {
+
+  unsigned long long iterations = 0;
+  const BenchmarkClock::time_point start = BenchmarkClock::now();
+  double seconds = 0.0;
+
+  do {
+    pass();
+    iterations++;
+    seconds = std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+  } while(seconds < options.minTime);
+
+  printResult(name, count, iterations, seconds);
+}
+
+// micro benchmarks of the GL-free helper functions
+static void benchmarkFunctions(unsigned int count) {
+
+  srand(options.seed);
+
+  std::vector<glm::vec3> positions(count), directions(count), centers(count);
+  std::vector<float> radii(count), params(count);
+
+  for(unsigned int i = 0; i < count; i++) {
+    positions[i]  = randomPosition(1.2f * SCENE_WIDTH);
+    directions[i] = randomDirection();
+    centers[i]    = randomPosition(SCENE_WIDTH);
+    radii[i]      = randomFloat(0.5f * ASTEROID_SIZE_MIN, ASTEROID_SIZE);
+    params[i]     = randomFloat(0.0f, (float)curveSize);
+  }
+
+  if(selected("checkBounds")) {
+    runBenchmark("checkBounds", count, [&]() {
+      float sum = 0.0f;
+      for(unsigned int i = 0; i < count; i++)
+        sum += checkBounds(positions[i], radii[i]).x;
+      benchmarkSink = benchmarkSink + sum;
+    });
+  }
+
+  if(selected("pointInSphere")) {
+    runBenchmark("pointInSphere", count, [&]() {
+      unsigned int hits = 0;
+      for(unsigned int i = 0; i < count; i++)
+        hits += pointInSphere(positions[i], centers[i], 0.5f) ? 1 : 0;
+      benchmarkSink = benchmarkSink + (float)hits;
+    });
+  }
+
+  if(selected("spheresIntersection")) {
+    runBenchmark("spheresIntersection", count, [&]() {
+      unsigned int hits = 0;
+      for(unsigned int i = 0; i < count; i++)
+        hits += spheresIntersection(positions[i], radii[i], centers[i], 0.5f) ? 1 : 0;
+      benchmarkSink = benchmarkSink + (float)hits;
+    });
+  }
+
+  if(selected("evaluateClosedCurve")) {
+    runBenchmark("evaluateClosedCurve", count, [&]() {
+      float sum = 0.0f;
+      for(unsigned int i = 0; i < count; i++)
+        sum += evaluateClosedCurve(curveData, curveSize, params[i]).x;
+      benchmarkSink = benchmarkSink + sum;
+    });
+  }
+
+  if(selected("evaluateClosedCurveBatch")) {
+    std::vector<CurveSegmentCoefficients> segments;
+    computeClosedCurveCoefficients(curveData, curveSize, segments);
+
+    std::vector<glm::vec3> curvePositions(count), curveDerivatives(count);
+
+    runBenchmark("evaluateClosedCurveBatch", count, [&]() {
+      evaluateClosedCurveBatch(&segments[0], curveSize, &params[0], count, &curvePositions[0], &curveDerivatives[0]);
+      benchmarkSink = benchmarkSink + curvePositions[count - 1].x;
+    });
+  }
+
+  if(selected("evaluateClosedCurveByArcLength")) {
+    CurveArcLengthTable table;
+    buildCurveArcLengthTable(curveData, curveSize, 128, table);
+
+    std::vector<float> distances(count);
+    for(unsigned int i = 0; i < count; i++)
+      distances[i] = params[i] * table.totalLength / (float)curveSize;
+
+    std::vector<glm::vec3> curvePositions(count), curveTangents(count);
+
+    runBenchmark("evaluateClosedCurveByArcLength", count, [&]() {
+      evaluateClosedCurveByArcLength(table, &distances[0], count, &curvePositions[0], &curveTangents[0]);
+      benchmarkSink = benchmarkSink + curvePositions[count - 1].x;
+    });
+  }
+
+  if(selected("alignObject")) {
+    runBenchmark("alignObject", count, [&]() {
+      float sum = 0.0f;
+      for(unsigned int i = 0; i < count; i++)
+        sum += alignObject(positions[i], directions[i], glm::vec3(0.0f, 0.0f, 1.0f))[0].x;
+      benchmarkSink = benchmarkSink + sum;
+    });
+  }
+
+  if(selected("cullSpheres")) {
+    // view of the free camera from the scene center -> about a third of the objects is visible
+    const glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    const glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 10.0f);
+
+    Frustum frustum;
+    extractFrustum(projectionMatrix * viewMatrix, frustum);
+
+    std::vector<unsigned int> visible;
+    visible.reserve(count);
+
+    runBenchmark("cullSpheres", count, [&]() {
+      benchmarkSink = benchmarkSink + (float)cullSpheres(frustum, &positions[0], &radii[0], count, visible);
+    });
+  }
+
+  if(selected("radixSortKeys")) {
+    // keys of a frame with a few programs, meshes and textures -> the state bytes are mostly equal
+    std::vector<RenderSortItem> keys(count);
+    for(unsigned int i = 0; i < count; i++) {
+      const unsigned long long program = 1 + rand() % 3;
+      const unsigned long long vertexArrayObject = 1 + rand() % 5;
+      const unsigned long long texture = rand() % 4;
+      const unsigned long long depth = rand() & 0xffffff;
+
+      keys[i].key = (program << 52) | (vertexArrayObject << 40) | (texture << 28) | (depth << 4);
+      keys[i].packet = i;
+    }
+
+    std::vector<RenderSortItem> items;
+    std::vector<RenderSortItem> scratch;
+
+    // the unsorted keys are copied in each iteration, the copy is part of the measured time
+    runBenchmark("radixSortKeys", count, [&]() {
+      items = keys;
+      radixSortKeys(items, scratch);
+      benchmarkSink = benchmarkSink + (float)items[0].packet;
+    });
+  }
+
+  // larger counts would be cut to the light limit
+  if(selected("binPointLights") && count <= POINT_LIGHTS_MAX) {
+    // lights of the size of the missile ones seen by the free camera from the scene center
+    const glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    const glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 10.0f);
+
+    std::vector<PointLight> lights(count);
+    for(unsigned int i = 0; i < count; i++) {
+      lights[i].position = positions[i];
+      lights[i].radius = 20.0f * MISSILE_SIZE;
+      lights[i].color = glm::vec3(1.0f);
+    }
+
+    LightClusters clusters;
+
+    runBenchmark("binPointLights", count, [&]() {
+      binPointLights(lights, viewMatrix, projectionMatrix, 800, 600, clusters);
+      benchmarkSink = benchmarkSink + (float)clusters.indices.size();
+    });
+  }
+
+  if(selected("selectMeshLod")) {
+    // asteroids seen by the free camera from the scene center, levels are kept between iterations as between frames
+    const glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    const glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 10.0f);
+    const glm::mat4 projectionViewMatrix = projectionMatrix * viewMatrix;
+
+    std::vector<unsigned char> lods(count, 0);
+
+    runBenchmark("selectMeshLod", count, [&]() {
+      unsigned int sum = 0;
+      for(unsigned int i = 0; i < count; i++) {
+        const float radius = projectedRadius(projectionMatrix, projectionViewMatrix, 600, positions[i], radii[i]);
+        lods[i] = (unsigned char)selectMeshLod(radius, lods[i], MESH_LODS_MAX);
+        sum += lods[i];
+      }
+      benchmarkSink = benchmarkSink + (float)sum;
+    });
+  }
+}
+
+// fills the scene with count asteroids, count/100 missiles and count/100 ufos
+static void createScene(unsigned int count) {
+
+  srand(options.seed);
+  seedSimulationRandom(options.seed);
+
+  resetSimulation(0.0f, count);
+
+  const unsigned int missileCount = std::max(1u, count / 100);
+  const unsigned int ufoCount = std::max(1u, count / 100);
+
+  // the scene is larger than any game -> pools need more room than resetSimulation() reserves,
+  // each object explodes once at most and each missile may hit the space ship
+  reserveObjects(gameObjects.missiles, missileCount);
+  reserveObjects(gameObjects.ufos, ufoCount);
+  reserveObjects(gameObjects.explosions, count + ufoCount + missileCount);
+
+  for(unsigned int i = 0; i < missileCount; i++) {
+    MissileObject missile;
+
+    missile.position  = randomPosition(SCENE_WIDTH);
+    missile.direction = randomDirection();
+    missile.speed     = MISSILE_SPEED;
+    missile.size      = MISSILE_SIZE;
+    missile.destroyed = false;
+    missile.startTime = gameState.elapsedTime;
+    missile.currentTime = missile.startTime;
+
+    insertObject(gameObjects.missiles, missile);
+  }
+
+  for(unsigned int i = 0; i < ufoCount; i++)
+    insertObject(gameObjects.ufos, createUfo());
+}
+
+// macro benchmarks of the simulation phases on a full scene
+static void benchmarkSimulation(unsigned int count) {
+
+  if(selected("updateObjects")) {
+    createScene(count);
+
+    // time alternates between two values -> objects move back and forth, missiles never expire
+    // and the scene keeps its size however many passes are run
+    unsigned int pass = 0;
+    runBenchmark("updateObjects", count, [&]() {
+      updateObjects((pass++ % 2) ? 0.02f : 0.01f);
+    });
+  }
+
+  // collisions destroy objects -> the scene is restored before each pass, restoring is not measured
+  static const struct {
+    const char* name;
+    int mode;
+  } collisionBenchmarks[] = {
+    { "checkCollisions/grid",  COLLISIONS_GRID },
+    { "checkCollisions/brute", COLLISIONS_BRUTE_FORCE },
+  };
+
+  for(unsigned int b = 0; b < sizeof(collisionBenchmarks) / sizeof(collisionBenchmarks[0]); b++) {
+    if(selected(collisionBenchmarks[b].name) == false)
+      continue;
+
+    // brute force is quadratic, skip counts taking minutes per pass
+    if(collisionBenchmarks[b].mode == COLLISIONS_BRUTE_FORCE && count > 100000)
+      continue;
+
+    createScene(count);
+    gameState.collisionMode = collisionBenchmarks[b].mode;
+
+    const AsteroidPool asteroids = gameObjects.asteroids;
+    const MissilePool  missiles  = gameObjects.missiles;
+    const UfoPool      ufos      = gameObjects.ufos;
+    const SpaceShipObject spaceShip = *gameObjects.spaceShip;
+
+    unsigned long long iterations = 0;
+    double seconds = 0.0;
+
+    do {
+      gameObjects.asteroids = asteroids;
+      gameObjects.missiles  = missiles;
+      gameObjects.ufos      = ufos;
+      clearObjects(gameObjects.explosions);
+      *gameObjects.spaceShip = spaceShip;
+      gameState.gameOver = false;
+
+      const BenchmarkClock::time_point start = BenchmarkClock::now();
+      checkCollisions();
+      seconds += std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+
+      iterations++;
+    } while(seconds < options.minTime);
+
+    benchmarkSink = benchmarkSink + (float)objectCount(gameObjects.explosions);
+
+    printResult(collisionBenchmarks[b].name, count, iterations, seconds);
+  }
+
+  // consecutive steps of a game - the kinetic collisions keep their events from step to step, so the time
+  // has to advance, the scene is created again when its missiles expire (updates and the scene are not measured)
+  static const struct {
+    const char* name;
+    int mode;
+  } stepBenchmarks[] = {
+    { "collisionSteps/grid",    COLLISIONS_GRID },
+    { "collisionSteps/kinetic", COLLISIONS_KINETIC },
+  };
+
+  const float stepTime = 0.033f;
+  const unsigned int sceneSteps = (unsigned int)(MISSILE_MAX_DISTANCE / (MISSILE_SPEED * stepTime));
+
+  for(unsigned int b = 0; b < sizeof(stepBenchmarks) / sizeof(stepBenchmarks[0]); b++) {
+    if(selected(stepBenchmarks[b].name) == false)
+      continue;
+
+    unsigned long long iterations = 0;
+    double seconds = 0.0;
+
+    do {
+      const unsigned int step = iterations % sceneSteps;
+      if(step == 0) {
+        createScene(count);
+        gameState.collisionMode = stepBenchmarks[b].mode;
+      }
+
+      gameState.elapsedTime = (step + 1) * stepTime;
+      updateObjects(gameState.elapsedTime);
+
+      const BenchmarkClock::time_point start = BenchmarkClock::now();
+      checkCollisions();
+      seconds += std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+
+      iterations++;
+    } while(seconds < options.minTime || iterations % sceneSteps != 0);
+
+    benchmarkSink = benchmarkSink + (float)objectCount(gameObjects.explosions);
+
+    printResult(stepBenchmarks[b].name, count, iterations, seconds);
+  }
+
+  gameState.collisionMode = COLLISIONS_GRID;
+}
+
+static void parseCommandLine(int argc, char** argv) {
+
+  options.seed = 12345;
+  options.minCount = 10;
+  options.maxCount = 1000000;
+  options.minTime = 0.2;
+  options.threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  for(int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool hasValue = (i + 1 < argc);
+
+    if(arg == "--seed" && hasValue)
+      options.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if(arg == "--min-count" && hasValue)
+      options.minCount = std::max(1u, (unsigned int)strtoul(argv[++i], NULL, 10));
+    else if(arg == "--max-count" && hasValue)
+      options.maxCount = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if(arg == "--min-time" && hasValue)
+      options.minTime = atof(argv[++i]);
+    else if(arg == "--threads" && hasValue)
+      options.threadCount = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if(arg == "--filter" && hasValue)
+      options.filter = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--seed N] [--min-count N] [--max-count N] [--min-time SECONDS] [--threads N] [--filter NAME]\n", argv[0]);
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+
+  parseCommandLine(argc, argv);
+
+  initializeJobSystem(options.threadCount);
+  initializeSimulation(options.seed);
+
+  printf("benchmark,count,threads,iterations,seconds,ns_per_item,items_per_second\n");
+
+  for(unsigned long long count = options.minCount; count <= options.maxCount; count *= 10) {
+    benchmarkFunctions((unsigned int)count);
+    benchmarkSimulation((unsigned int)count);
+  }
+
+  finalizeSimulation();
+  finalizeJobSystem();
+
+  return 0;
+}
@@ -0,0 +1,179 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    clustered_lights.cpp
+ * \brief   Clustered forward lighting - point lights of the objects are binned into a grid
+ *          of view frustum cells (froxels), fragments evaluate only the lights of their cell.
+ *
+ * The light list is built here without GL, clustered_lights_gl.cpp uploads it to the buffer textures.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "clustered_lights.h"
+
+// cells covered by one light
+typedef struct _LightRange {
+  int minX, maxX;
+  int minY, maxY;
+  int minZ, maxZ;
+} LightRange;
+
+static std::vector<LightRange>   lightRanges;
+static std::vector<unsigned int> cellFill;     // indices already stored in each cell
+
+void gatherPointLights(const MissilePool &missiles, const UfoPool &ufos, const ExplosionPool &explosions, std::vector<PointLight> &lights) {
+
+  lights.clear();
+
+  PointLight light;
+
+  // explosions first - they are the brightest lights and are kept when the limit is reached
+  for(unsigned int i = 0; i < objectCount(explosions); i++) {
+    // fades out with the animation of the billboard
+    const float duration = explosions.textureFrames[i] * explosions.frameDuration[i];
+    const float fade = 1.0f - std::min((explosions.currentTime[i] - explosions.startTime[i]) / duration, 1.0f);
+
+    light.position = explosions.position[i];
+    light.radius = 3.0f * explosions.size[i];
+    light.color = glm::vec3(1.0f, 0.55f, 0.2f) * (2.0f * fade);
+    lights.push_back(light);
+  }
+
+  for(unsigned int i = 0; i < objectCount(ufos); i++) {
+    light.position = ufos.position[i];
+    light.radius = 5.0f * ufos.size[i];
+    light.color = glm::vec3(0.8f, 0.2f, 0.8f);
+    lights.push_back(light);
+  }
+
+  for(unsigned int i = 0; i < objectCount(missiles); i++) {
+    light.position = missiles.position[i];
+    light.radius = 20.0f * missiles.size[i];
+    light.color = glm::vec3(1.0f, 0.8f, 0.4f);
+    lights.push_back(light);
+  }
+}
+
+static int clampCell(int cell, int count) {
+
+  return std::max(0, std::min(cell, count - 1));
+}
+
+void binPointLights(const std::vector<PointLight> &lights, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix,
+                    int viewportWidth, int viewportHeight, LightClusters &clusters) {
+
+  // near and far distance of the projection, the last row is (0, 0, 0, 1) for orthographic ones
+  const bool perspective = (projectionMatrix[3][3] == 0.0f);
+  float nearDistance, farDistance;
+  if(perspective) {
+    nearDistance = projectionMatrix[3][2] / (projectionMatrix[2][2] - 1.0f);
+    farDistance  = projectionMatrix[3][2] / (projectionMatrix[2][2] + 1.0f);
+  }
+  else {
+    nearDistance = (projectionMatrix[3][2] + 1.0f) / projectionMatrix[2][2];
+    farDistance  = (projectionMatrix[3][2] - 1.0f) / projectionMatrix[2][2];
+  }
+
+  // slice = f(depth) * scale + bias maps near...far to 0...CLUSTER_GRID_Z
+  clusters.logarithmicSlices = perspective;
+  float sliceScale, sliceBias;
+  if(perspective) {
+    sliceScale = CLUSTER_GRID_Z / log(farDistance / nearDistance);
+    sliceBias = -log(nearDistance) * sliceScale;
+  }
+  else {
+    sliceScale = CLUSTER_GRID_Z / (farDistance - nearDistance);
+    sliceBias = -nearDistance * sliceScale;
+  }
+  clusters.scale = glm::vec4(CLUSTER_GRID_X / (float)viewportWidth, CLUSTER_GRID_Y / (float)viewportHeight, sliceScale, sliceBias);
+
+  const unsigned int count = std::min((unsigned int)lights.size(), (unsigned int)POINT_LIGHTS_MAX);
+
+  clusters.lights.clear();
+  clusters.cells.assign(CLUSTER_COUNT * 2, 0);
+  lightRanges.clear();
+
+  // cells covered by each light, lights outside of the view volume are dropped
+  for(unsigned int i = 0; i < count; i++) {
+
+    const glm::vec3 center = glm::vec3(viewMatrix * glm::vec4(lights[i].position, 1.0f));
+    const float radius = lights[i].radius;
+
+    const float minDepth = std::max(-center.z - radius, nearDistance);
+    const float maxDepth = std::min(-center.z + radius, farDistance);
+    if(minDepth > maxDepth)
+      continue;
+
+    LightRange range;
+    if(perspective) {
+      range.minZ = clampCell((int)floor(log(minDepth) * sliceScale + sliceBias), CLUSTER_GRID_Z);
+      range.maxZ = clampCell((int)floor(log(maxDepth) * sliceScale + sliceBias), CLUSTER_GRID_Z);
+    }
+    else {
+      range.minZ = clampCell((int)floor(minDepth * sliceScale + sliceBias), CLUSTER_GRID_Z);
+      range.maxZ = clampCell((int)floor(maxDepth * sliceScale + sliceBias), CLUSTER_GRID_Z);
+    }
+
+    // sphere reaching in front of the near plane can cover any pixel
+    glm::vec2 ndcMin = glm::vec2(-1.0f);
+    glm::vec2 ndcMax = glm::vec2(1.0f);
+
+    if(!perspective || -center.z - radius > nearDistance) {
+      // bounds of the projected corners of the eye space box around the sphere
+      ndcMin = glm::vec2(1.0f);
+      ndcMax = glm::vec2(-1.0f);
+      for(int corner = 0; corner < 8; corner++) {
+        const glm::vec3 offset = glm::vec3((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+        const glm::vec4 clip = projectionMatrix * glm::vec4(center + offset, 1.0f);
+        const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+      }
+
+      if(ndcMin.x > 1.0f || ndcMin.y > 1.0f || ndcMax.x < -1.0f || ndcMax.y < -1.0f)
+        continue;
+    }
+
+    range.minX = clampCell((int)floor((ndcMin.x * 0.5f + 0.5f) * CLUSTER_GRID_X), CLUSTER_GRID_X);
+    range.maxX = clampCell((int)floor((ndcMax.x * 0.5f + 0.5f) * CLUSTER_GRID_X), CLUSTER_GRID_X);
+    range.minY = clampCell((int)floor((ndcMin.y * 0.5f + 0.5f) * CLUSTER_GRID_Y), CLUSTER_GRID_Y);
+    range.maxY = clampCell((int)floor((ndcMax.y * 0.5f + 0.5f) * CLUSTER_GRID_Y), CLUSTER_GRID_Y);
+
+    lightRanges.push_back(range);
+
+    clusters.lights.push_back(glm::vec4(center, radius));
+    clusters.lights.push_back(glm::vec4(lights[i].color, 0.0f));
+
+    // count the references of each cell, the offsets are computed afterwards
+    for(int z = range.minZ; z <= range.maxZ; z++)
+      for(int y = range.minY; y <= range.maxY; y++)
+        for(int x = range.minX; x <= range.maxX; x++)
+          clusters.cells[2 * (x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z)) + 1]++;
+  }
+
+  clusters.lightCount = (unsigned int)lightRanges.size();
+
+  // offsets of the cells, references over the limit are dropped
+  unsigned int offset = 0;
+  for(unsigned int cell = 0; cell < CLUSTER_COUNT; cell++) {
+    const unsigned int cellCount = std::min(clusters.cells[2 * cell + 1], (unsigned int)CLUSTER_LIGHT_INDICES_MAX - offset);
+    clusters.cells[2 * cell] = offset;
+    clusters.cells[2 * cell + 1] = cellCount;
+    offset += cellCount;
+  }
+
+  clusters.indices.resize(offset);
+
+  // indices of the lights are stored in the order of the list, the cells are filled up to their counts
+  cellFill.assign(CLUSTER_COUNT, 0);
+  for(unsigned int light = 0; light < clusters.lightCount; light++) {
+    const LightRange &range = lightRanges[light];
+    for(int z = range.minZ; z <= range.maxZ; z++)
+      for(int y = range.minY; y <= range.maxY; y++)
+        for(int x = range.minX; x <= range.maxX; x++) {
+          const unsigned int cell = x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z);
+          if(cellFill[cell] < clusters.cells[2 * cell + 1])
+            clusters.indices[clusters.cells[2 * cell] + cellFill[cell]++] = (unsigned short)light;
+        }
+  }
+}
@@ -0,0 +1,74 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    clustered_lights.h
+ * \brief   Clustered forward lighting - point lights of the objects are binned into a grid
+ *          of view frustum cells (froxels), fragments evaluate only the lights of their cell.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __CLUSTERED_LIGHTS_H
+#define __CLUSTERED_LIGHTS_H
+
+#include <vector>
+#include "pgr.h"
+#include "object_pool.h"
+
+// cells of the grid, must match the constants in lightingPerVertex.frag
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_COUNT  (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+
+// lights beyond the limit are not drawn
+#define POINT_LIGHTS_MAX          1024
+// light indices of all cells together, references beyond the limit are dropped
+#define CLUSTER_LIGHT_INDICES_MAX 65536
+
+// texturing units of the light buffers, units 0 and 1 are used by the material and instance textures
+#define POINT_LIGHTS_TEXTURE_UNIT   2
+#define LIGHT_CLUSTERS_TEXTURE_UNIT 3
+#define LIGHT_INDICES_TEXTURE_UNIT  4
+
+typedef struct _PointLight {
+  glm::vec3 position;   // world space
+  float     radius;     // the light does not reach further
+  glm::vec3 color;
+} PointLight;
+
+// light list of one frame in the layout read by the fragment shader
+typedef struct _LightClusters {
+  glm::vec4                   scale;              // cells per pixel (xy), slice scale and bias (zw)
+  bool                        logarithmicSlices;  // slice = log(depth) * scale.z + scale.w, depth * scale.z + scale.w otherwise
+  unsigned int                lightCount;
+  std::vector<glm::vec4>      lights;             // 2 texels per light: eye space position and radius, color
+  std::vector<unsigned int>   cells;              // 2 values per cell: offset and number of its light indices
+  std::vector<unsigned short> indices;            // light indices of all cells
+} LightClusters;
+
+// creates the buffer textures of the light list
+void initializeClusteredLights(void);
+void cleanupClusteredLights(void);
+
+// replaces lights by the lights emitted by missiles, ufos and explosions
+void gatherPointLights(const MissilePool &missiles, const UfoPool &ufos, const ExplosionPool &explosions, std::vector<PointLight> &lights);
+
+//**************************************************************************************************
+/// Bins the lights into the cells of the view frustum.
+/**
+ A light is added to every cell intersected by the eye space bounding box of its sphere. Perspective
+ projections are sliced exponentially in depth, orthographic ones linearly. Does not call GL.
+
+ \param[in]   lights            Lights in world space, only the first POINT_LIGHTS_MAX are used.
+ \param[in]   viewMatrix        View transform.
+ \param[in]   projectionMatrix  Perspective or orthographic projection.
+ \param[in]   viewportWidth     Width of the viewport in pixels.
+ \param[in]   viewportHeight    Height of the viewport in pixels.
+ \param[out]  clusters          Light list of the frame, the vectors are reused.
+*/
+void binPointLights(const std::vector<PointLight> &lights, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix,
+                    int viewportWidth, int viewportHeight, LightClusters &clusters);
+
+// streams the light list to the buffer textures and binds them to their texturing units
+void uploadLightClusters(const LightClusters &clusters);
+
+#endif // __CLUSTERED_LIGHTS_H
@@ -0,0 +1,81 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    clustered_lights_gl.cpp
+ * \brief   Buffer textures of the clustered forward lighting, the light list built by
+ *          binPointLights() is streamed to them once per frame.
+ */
+//----------------------------------------------------------------------------------------
+
+#include "clustered_lights.h"
+
+// buffer objects and buffer textures of the light list, allocated for the maximum sizes
+struct LightBuffers {
+  GLuint lightBuffer;     // = 0; RGBA32F, 2 texels per light
+  GLuint lightTexture;    // = 0;
+  GLuint cellBuffer;      // = 0; RG32UI, 1 texel per cell
+  GLuint cellTexture;     // = 0;
+  GLuint indexBuffer;     // = 0; R16UI, 1 texel per light reference
+  GLuint indexTexture;    // = 0;
+} lightBuffers;
+
+static void createBufferTexture(GLsizeiptr size, GLenum format, GLuint &buffer, GLuint &texture) {
+
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+  glBufferData(GL_TEXTURE_BUFFER, size, NULL, GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_BUFFER, texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void initializeClusteredLights(void) {
+
+  createBufferTexture(POINT_LIGHTS_MAX * 2 * sizeof(glm::vec4), GL_RGBA32F, lightBuffers.lightBuffer, lightBuffers.lightTexture);
+  createBufferTexture(CLUSTER_COUNT * 2 * sizeof(unsigned int), GL_RG32UI, lightBuffers.cellBuffer, lightBuffers.cellTexture);
+  createBufferTexture(CLUSTER_LIGHT_INDICES_MAX * sizeof(unsigned short), GL_R16UI, lightBuffers.indexBuffer, lightBuffers.indexTexture);
+
+  CHECK_GL_ERROR();
+}
+
+void cleanupClusteredLights(void) {
+
+  glDeleteTextures(1, &lightBuffers.lightTexture);
+  glDeleteTextures(1, &lightBuffers.cellTexture);
+  glDeleteTextures(1, &lightBuffers.indexTexture);
+  glDeleteBuffers(1, &lightBuffers.lightBuffer);
+  glDeleteBuffers(1, &lightBuffers.cellBuffer);
+  glDeleteBuffers(1, &lightBuffers.indexBuffer);
+}
+
+// orphans the storage of the buffer and copies the used part of it
+static void streamBuffer(GLuint buffer, GLsizeiptr capacity, GLsizeiptr size, const void *data) {
+
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+  glBufferData(GL_TEXTURE_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+  if(size > 0)
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+}
+
+void uploadLightClusters(const LightClusters &clusters) {
+
+  streamBuffer(lightBuffers.lightBuffer, POINT_LIGHTS_MAX * 2 * sizeof(glm::vec4),
+               clusters.lights.size() * sizeof(glm::vec4), clusters.lights.empty() ? NULL : &clusters.lights[0]);
+  streamBuffer(lightBuffers.cellBuffer, CLUSTER_COUNT * 2 * sizeof(unsigned int),
+               clusters.cells.size() * sizeof(unsigned int), &clusters.cells[0]);
+  streamBuffer(lightBuffers.indexBuffer, CLUSTER_LIGHT_INDICES_MAX * sizeof(unsigned short),
+               clusters.indices.size() * sizeof(unsigned short), clusters.indices.empty() ? NULL : &clusters.indices[0]);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glActiveTexture(GL_TEXTURE0 + POINT_LIGHTS_TEXTURE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, lightBuffers.lightTexture);
+  glActiveTexture(GL_TEXTURE0 + LIGHT_CLUSTERS_TEXTURE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, lightBuffers.cellTexture);
+  glActiveTexture(GL_TEXTURE0 + LIGHT_INDICES_TEXTURE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, lightBuffers.indexTexture);
+  glActiveTexture(GL_TEXTURE0);
+
+  CHECK_GL_ERROR();
+}
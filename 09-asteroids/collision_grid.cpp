@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    collision_grid.cpp
+ * \brief   Uniform grid broadphase for collision tests in the wrap-around scene.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "pgr.h"
+#include "collision_grid.h"
+#include "data.h"
+
+// wraps cell coordinate to range 0...cells-1
+static inline int wrapCell(int cell, int cells) {
+
+  cell %= cells;
+  return (cell < 0) ? cell + cells : cell;
+}
+
+// cell coordinate of the given position along one axis
+static inline int cellCoordinate(float position, float halfExtent, float cellSize, int cells) {
+
+  // positions outside the grid are wrapped back the same way as in checkBounds()
+  if(position < -halfExtent)
+    position += 2.0f * halfExtent;
+  if(position > halfExtent)
+    position -= 2.0f * halfExtent;
+
+  return wrapCell((int)floor((position + halfExtent) / cellSize), cells);
+}
+
+void buildCollisionGrid(CollisionGrid &grid, const glm::vec3 positions[], const float radii[], unsigned int count) {
+
+  float maxRadius = 0.0f;
+  for(unsigned int i = 0; i < count; i++)
+    maxRadius = std::max(maxRadius, radii[i]);
+
+  grid.maxRadius = maxRadius;
+  grid.objectCount = count;
+
+  // object centers stay within the scene enlarged by the object size (see checkBounds())
+  grid.halfWidth  = SCENE_WIDTH  + maxRadius;
+  grid.halfHeight = SCENE_HEIGHT + maxRadius;
+
+  // cells must not be smaller than the largest radius -> a query visits just the neighboring cells
+  // about sqrt(count) cells per axis -> a few objects share a cell, clearing the cells of a small pool costs nothing
+  const int maxCells = std::min(COLLISION_GRID_MAX_CELLS, std::max(1, (int)ceil(sqrt((float)count))));
+  const float minCellSize = std::max(maxRadius, 1e-3f);
+  grid.cellsX = std::max(1, std::min(maxCells, (int)(2.0f * grid.halfWidth  / minCellSize)));
+  grid.cellsY = std::max(1, std::min(maxCells, (int)(2.0f * grid.halfHeight / minCellSize)));
+  grid.cellWidth  = 2.0f * grid.halfWidth  / grid.cellsX;
+  grid.cellHeight = 2.0f * grid.halfHeight / grid.cellsY;
+
+  const unsigned int cellCount = grid.cellsX * grid.cellsY;
+
+  // counting sort of objects by cells
+  grid.cellStart.assign(cellCount + 1, 0);
+  grid.objectCell.resize(count);
+  grid.cellObjects.resize(count);
+
+  for(unsigned int i = 0; i < count; i++) {
+    const int x = cellCoordinate(positions[i].x, grid.halfWidth,  grid.cellWidth,  grid.cellsX);
+    const int y = cellCoordinate(positions[i].y, grid.halfHeight, grid.cellHeight, grid.cellsY);
+
+    grid.objectCell[i] = y * grid.cellsX + x;
+    grid.cellStart[grid.objectCell[i] + 1]++;
+  }
+
+  for(unsigned int c = 0; c < cellCount; c++)
+    grid.cellStart[c + 1] += grid.cellStart[c];
+
+  // objects are scattered in ascending order -> each cell stays sorted
+  // cellStart[c] is used as an insertion cursor and restored afterwards
+  for(unsigned int i = 0; i < count; i++)
+    grid.cellObjects[grid.cellStart[grid.objectCell[i]]++] = i;
+
+  for(unsigned int c = cellCount; c > 0; c--)
+    grid.cellStart[c] = grid.cellStart[c - 1];
+  grid.cellStart[0] = 0;
+}
+
+void queryCollisionGrid(const CollisionGrid &grid, const glm::vec3 &center, float radius, std::vector<unsigned int> &candidates) {
+
+  candidates.clear();
+
+  if(grid.objectCount == 0)
+    return;
+
+  const int centerX = cellCoordinate(center.x, grid.halfWidth,  grid.cellWidth,  grid.cellsX);
+  const int centerY = cellCoordinate(center.y, grid.halfHeight, grid.cellHeight, grid.cellsY);
+
+  // number of neighboring cells that may contain an intersecting sphere
+  const int rangeX = std::min((int)ceil((radius + grid.maxRadius) / grid.cellWidth),  grid.cellsX / 2);
+  const int rangeY = std::min((int)ceil((radius + grid.maxRadius) / grid.cellHeight), grid.cellsY / 2);
+
+  for(int dy = -rangeY; dy <= rangeY; dy++) {
+    const int y = wrapCell(centerY + dy, grid.cellsY);
+
+    for(int dx = -rangeX; dx <= rangeX; dx++) {
+      const int cell = y * grid.cellsX + wrapCell(centerX + dx, grid.cellsX);
+
+      candidates.insert(candidates.end(), grid.cellObjects.begin() + grid.cellStart[cell], grid.cellObjects.begin() + grid.cellStart[cell + 1]);
+    }
+  }
+
+  // callers process candidates in the same order as the brute force loop does
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+}
@@ -0,0 +1,66 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    collision_grid.h
+ * \brief   Uniform grid broadphase for collision tests in the wrap-around scene.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __COLLISION_GRID_H
+#define __COLLISION_GRID_H
+
+#include <vector>
+#include "pgr.h" // glm
+
+// maximum number of grid cells along one axis (bounds the memory used by the grid)
+#define COLLISION_GRID_MAX_CELLS 256
+
+// uniform grid over the xy plane of the scene, spheres are binned by their centers
+// - the grid covers the range in which checkBounds() keeps object centers, i.e.
+//   -(SCENE_WIDTH+size)...SCENE_WIDTH+size and -(SCENE_HEIGHT+size)...SCENE_HEIGHT+size
+// - the grid is toroidal - positions outside the range are wrapped back into it the same way
+//   checkBounds() does and cells on the opposite borders are neighbors
+// - objects in each cell are stored sorted by their index (compressed sparse row layout)
+typedef struct _CollisionGrid {
+  float halfWidth;      // grid covers -halfWidth...halfWidth along x
+  float halfHeight;     // grid covers -halfHeight...halfHeight along y
+  int   cellsX;
+  int   cellsY;
+  float cellWidth;
+  float cellHeight;
+  float maxRadius;      // largest radius of all spheres stored in the grid
+
+  unsigned int objectCount;               // number of objects stored in the grid
+
+  std::vector<unsigned int> cellStart;    // index of the first object of each cell in cellObjects (cellsX*cellsY+1 items)
+  std::vector<unsigned int> cellObjects;  // object indices grouped by cells
+  std::vector<unsigned int> objectCell;   // cell of each object (used during the build)
+
+} CollisionGrid;
+
+//**************************************************************************************************
+/// Rebuilds the grid from the given spheres.
+/**
+ Cell size is derived from the largest radius so that only the neighboring cells have to be visited
+ by a query. The grid has at most about sqrt(count) cells along each axis, so an empty or small pool
+ gets a grid of a few cells only.
+
+ \param[out] grid       Grid to be rebuilt.
+ \param[in]  positions  Sphere centers.
+ \param[in]  radii      Sphere radii.
+ \param[in]  count      Number of spheres, sphere i is stored in the grid under index i.
+*/
+void buildCollisionGrid(CollisionGrid &grid, const glm::vec3 positions[], const float radii[], unsigned int count);
+
+//**************************************************************************************************
+/// Collects all spheres that may intersect the given sphere.
+/**
+ The result is a superset of the intersecting spheres, an exact test has to be done by the caller.
+
+ \param[in]  grid        Grid to be searched.
+ \param[in]  center      Center of the query sphere.
+ \param[in]  radius      Radius of the query sphere (zero for a point query).
+ \param[out] candidates  Indices of the candidate spheres sorted in ascending order without duplicates.
+*/
+void queryCollisionGrid(const CollisionGrid &grid, const glm::vec3 &center, float radius, std::vector<unsigned int> &candidates);
+
+#endif // __COLLISION_GRID_H
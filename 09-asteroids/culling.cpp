@@ -0,0 +1,135 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    culling.cpp
+ * \brief   View frustum culling of the scene objects by their bounding spheres.
+ */
+//----------------------------------------------------------------------------------------
+
+#include "culling.h"
+
+// SSE2 is part of every x86-64 target
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CULLING_USE_SSE
+#endif
+
+void extractFrustum(const glm::mat4 &projectionViewMatrix, Frustum &frustum) {
+
+  // rows of the matrix, glm stores columns
+  glm::vec4 row[4];
+  for(int i = 0; i < 4; i++)
+    row[i] = glm::vec4(projectionViewMatrix[0][i], projectionViewMatrix[1][i], projectionViewMatrix[2][i], projectionViewMatrix[3][i]);
+
+  // clip space -w <= x,y,z <= w -> planes w + x, w - x, w + y, w - y, w + z, w - z
+  const glm::vec4 planes[6] = {
+    row[3] + row[0], row[3] - row[0],
+    row[3] + row[1], row[3] - row[1],
+    row[3] + row[2], row[3] - row[2]
+  };
+
+  for(int p = 0; p < 6; p++) {
+    // normalized planes give distances, comparable to the radii
+    const float length = glm::length(glm::vec3(planes[p]));
+    frustum.a[p] = planes[p].x / length;
+    frustum.b[p] = planes[p].y / length;
+    frustum.c[p] = planes[p].z / length;
+    frustum.d[p] = planes[p].w / length;
+  }
+}
+
+unsigned int cullSpheres(const Frustum &frustum, const glm::vec3 *centers, const float *sizes, unsigned int count, std::vector<unsigned int> &visible) {
+
+  // every sphere may be visible, the list is shrunk to the visible ones at the end
+  visible.resize(count);
+  unsigned int visibleCount = 0;
+
+  unsigned int i = 0;
+
+#ifdef CULLING_USE_SSE
+  const __m128 radiusScale = _mm_set1_ps(-CULLING_RADIUS_SCALE);
+
+  for(; i + 4 <= count; i += 4) {
+    // four tightly packed centers x0y0z0x1 y1z1x2y2 z2x3y3z3 -> one register per coordinate
+    const float *c = &centers[i].x;
+    const __m128 r0 = _mm_loadu_ps(c);
+    const __m128 r1 = _mm_loadu_ps(c + 4);
+    const __m128 r2 = _mm_loadu_ps(c + 8);
+
+    const __m128 x2y2x3y3 = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(2, 1, 3, 2));
+    const __m128 y0z0y1z1 = _mm_shuffle_ps(r0, r1, _MM_SHUFFLE(1, 0, 2, 1));
+    const __m128 x = _mm_shuffle_ps(r0, x2y2x3y3, _MM_SHUFFLE(2, 0, 3, 0));
+    const __m128 y = _mm_shuffle_ps(y0z0y1z1, x2y2x3y3, _MM_SHUFFLE(3, 1, 2, 0));
+    const __m128 z = _mm_shuffle_ps(y0z0y1z1, r2, _MM_SHUFFLE(3, 0, 3, 1));
+
+    const __m128 negativeRadius = _mm_mul_ps(_mm_loadu_ps(sizes + i), radiusScale);
+
+    // sphere is outside if it lies completely behind any plane
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for(int p = 0; p < 6; p++) {
+      const __m128 distance = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.a[p]), x), _mm_mul_ps(_mm_set1_ps(frustum.b[p]), y)),
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.c[p]), z), _mm_set1_ps(frustum.d[p]))
+      );
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+    }
+
+    // each index is written, only indices of the visible spheres are kept -> no branches
+    const int mask = _mm_movemask_ps(inside);
+    for(int lane = 0; lane < 4; lane++) {
+      visible[visibleCount] = i + lane;
+      visibleCount += (mask >> lane) & 1;
+    }
+  }
+#endif
+
+  // the rest of the spheres (all spheres without SSE)
+  for(; i < count; i++) {
+    const float negativeRadius = -CULLING_RADIUS_SCALE * sizes[i];
+
+    bool inside = true;
+    for(int p = 0; p < 6 && inside; p++) {
+      const float distance = frustum.a[p] * centers[i].x + frustum.b[p] * centers[i].y + frustum.c[p] * centers[i].z + frustum.d[p];
+      inside = (distance >= negativeRadius);
+    }
+
+    if(inside)
+      visible[visibleCount++] = i;
+  }
+
+  visible.resize(visibleCount);
+
+  return visibleCount;
+}
+
+static void cullPool(const Frustum *frustum, const ObjectPool &pool, std::vector<unsigned int> &visible) {
+
+  const unsigned int count = objectCount(pool);
+
+  if(frustum == NULL) {
+    visible.resize(count);
+    for(unsigned int i = 0; i < count; i++)
+      visible[i] = i;
+    return;
+  }
+
+  if(count == 0) {
+    visible.clear();
+    return;
+  }
+
+  cullSpheres(*frustum, &pool.position[0], &pool.size[0], count, visible);
+}
+
+void cullObjects(const Frustum *frustum, const AsteroidPool &asteroids, const MissilePool &missiles, const UfoPool &ufos,
+                 const ExplosionPool &explosions, VisibleObjects &visible) {
+
+  cullPool(frustum, asteroids, visible.asteroids);
+  cullPool(frustum, missiles, visible.missiles);
+  cullPool(frustum, ufos, visible.ufos);
+  cullPool(frustum, explosions, visible.explosions);
+}
+
+unsigned int visibleObjectCount(const VisibleObjects &visible) {
+
+  return (unsigned int)(visible.asteroids.size() + visible.missiles.size() + visible.ufos.size() + visible.explosions.size());
+}
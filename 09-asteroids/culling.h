@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    culling.h
+ * \brief   View frustum culling of the scene objects by their bounding spheres.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __CULLING_H
+#define __CULLING_H
+
+#include <vector>
+#include "pgr.h"
+#include "render_stuff.h"
+
+// models are unitized to (-1..1)^3 and scaled by the object size -> sqrt(3) * size bounds any of them
+#define CULLING_RADIUS_SCALE 1.7320508f
+
+// frustum planes a*x + b*y + c*z + d >= 0 inside, each coefficient of all planes in one array
+// (left, right, bottom, top, near, far) so that a plane is applied to four spheres at once
+typedef struct _Frustum {
+  float a[6];
+  float b[6];
+  float c[6];
+  float d[6];
+} Frustum;
+
+// frustum of the given projection * view matrix in world space, planes are normalized
+void extractFrustum(const glm::mat4 &projectionViewMatrix, Frustum &frustum);
+
+//**************************************************************************************************
+/// Finds spheres intersecting the frustum.
+/**
+ Four spheres are tested at once by SSE where available. Spheres touching a plane are kept,
+ so nothing partially visible is culled.
+
+ \param[in]   frustum  Frustum in the space of the centers.
+ \param[in]   centers  Sphere centers.
+ \param[in]   sizes    Object sizes, the radius is CULLING_RADIUS_SCALE * size.
+ \param[in]   count    Number of spheres.
+ \param[out]  visible  Indices of the visible spheres in ascending order, the vector is overwritten.
+ \return               Number of visible spheres.
+*/
+unsigned int cullSpheres(const Frustum &frustum, const glm::vec3 *centers, const float *sizes, unsigned int count, std::vector<unsigned int> &visible);
+
+// fills visible with the objects intersecting the frustum, with all objects if frustum is NULL
+void cullObjects(const Frustum *frustum, const AsteroidPool &asteroids, const MissilePool &missiles, const UfoPool &ufos,
+                 const ExplosionPool &explosions, VisibleObjects &visible);
+
+// number of objects in all visible lists
+unsigned int visibleObjectCount(const VisibleObjects &visible);
+
+#endif // __CULLING_H
@@ -1,18 +1,15 @@
 #version 140
 
-uniform float time;           // used for simulation of moving lights (such as sun) and to select proper animation frame
-uniform mat4 Vmatrix;         // view (camera) transform --> world to eye coordinates
 uniform sampler2D texSampler; // sampler for texture access
 
 smooth in vec3 position_v;    // camera space fragment position
 smooth in vec2 texCoord_v;    // fragment texture coordinates
+flat in int frame_v;          // frame of the animation
 
 out vec4 color_f;             // outgoing fragment color
 
 // there are 8 frames in the row, two rows total
 uniform ivec2 pattern = ivec2(8, 2);
-// one frame lasts 0.1s
-uniform float frameDuration = 0.1f;
 
 
 vec4 sampleTexture(int frame) {
@@ -26,9 +23,6 @@ vec4 sampleTexture(int frame) {
 }
 
 void main() {
-  // frame of the texture to be used for explosion drawing 
-  int frame = int(time / frameDuration);
-
   // sample proper frame of the texture to get a fragment color  
-  color_f = sampleTexture(frame);
+  color_f = sampleTexture(frame_v);
 }
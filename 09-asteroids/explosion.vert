@@ -1,16 +1,39 @@
 #version 140
 
-uniform mat4 PVMmatrix;     // Projection * View * Model --> model to clip coordinates
+// per-frame data shared by the programs, filled once per frame by setFrameUniforms()
+layout(std140) uniform FrameData {
+  mat4  Vmatrix;            // View              --> world to eye coordinates
+  mat4  Pmatrix;            // Projection        --> eye to clip coordinates
+  mat4  PVmatrix;           // Projection * View --> world to clip coordinates
+  vec4  sunDirection;       // direction to the sun (eye coordinates)
+  vec4  reflectorPosition;  // space ship reflector position (eye coordinates)
+  vec4  reflectorDirection; // space ship reflector direction (eye coordinates, normalized)
+  vec4  clusterScale;       // light clusters per pixel (xy), depth slice scale and bias (zw)
+  float time;               // elapsed time in seconds
+  float clusterLogDepth;    // 1 -> depth slices are logarithmic, 0 -> linear
+};
 
-in vec3 position;           // vertex position in world space
+uniform vec4 billboard;             // center (xyz) and size (w) of the explosion in world coordinates
+uniform float startTime;            // time the explosion started
+// one frame lasts 0.1s
+uniform float frameDuration = 0.1f;
+
+in vec3 position;           // vertex position of the unit quad
 in vec2 texCoord;           // incoming texture coordinates
 
 smooth out vec2 texCoord_v; // outgoing vertex texture coordinates
+flat out int frame_v;       // frame of the animation, the same for the whole quad
 
 void main() {
 
+  // the quad is expanded in eye coordinates -> it always faces the camera
+  vec4 eyePosition = Vmatrix * vec4(billboard.xyz, 1.0) + vec4(billboard.w * position, 0.0);
+
   // vertex position after the projection (gl_Position is predefined output variable)
-  gl_Position = PVMmatrix * vec4(position, 1);   // outgoing vertex in clip coordinates
+  gl_Position = Pmatrix * eyePosition;   // outgoing vertex in clip coordinates
+
+  // frame of the texture to be used for explosion drawing
+  frame_v = int((time - startTime) / frameDuration);
 
   // outputs entering the fragment shader
   texCoord_v = texCoord;
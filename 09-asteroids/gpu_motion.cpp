@@ -0,0 +1,161 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    gpu_motion.cpp
+ * \brief   GPU resident motion of asteroids and ufos - their spawn state stays in buffer
+ *          textures and the vertex shader evaluates their transforms from the frame time.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "gpu_motion.h"
+
+// records allocated for an empty pool, the buffers grow geometrically
+#define MOTION_INITIAL_OBJECTS 1024
+
+GpuMotion gpuMotion;
+
+static void createMotionBuffer(MotionBuffer &buffer) {
+
+  buffer.allocated = std::min((unsigned int)MOTION_INITIAL_OBJECTS, gpuMotion.maxObjects);
+  buffer.handles.clear();
+
+  glGenBuffers(1, &buffer.bufferObject);
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer.bufferObject);
+  glBufferData(GL_TEXTURE_BUFFER, buffer.allocated * MOTION_TEXELS * sizeof(glm::vec4), NULL, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glGenTextures(1, &buffer.texture);
+  glBindTexture(GL_TEXTURE_BUFFER, buffer.texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer.bufferObject);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+static void deleteMotionBuffer(MotionBuffer &buffer) {
+
+  glDeleteTextures(1, &buffer.texture);
+  glDeleteBuffers(1, &buffer.bufferObject);
+  buffer.handles.clear();
+}
+
+void initializeGpuMotion(const CurveArcLengthTable &ufoCurve) {
+
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  gpuMotion.maxObjects = (unsigned int)maxTexels / MOTION_TEXELS;
+
+  createMotionBuffer(gpuMotion.asteroids);
+  createMotionBuffer(gpuMotion.ufos);
+
+  // the curve does not change -> uploaded once, segment coefficients first, then the arc-length table
+  const unsigned int segmentCount = (unsigned int)ufoCurve.count;
+  const unsigned int tableSize = (unsigned int)ufoCurve.parameters.size();
+
+  std::vector<glm::vec4> texels(3 * segmentCount + (tableSize + 3) / 4, glm::vec4(0.0f));
+  for(unsigned int s = 0; s < segmentCount; s++)
+    for(int row = 0; row < 3; row++)
+      texels[3*s + row] = glm::vec4(
+        ufoCurve.segments[s].coefficients[row][0], ufoCurve.segments[s].coefficients[row][1],
+        ufoCurve.segments[s].coefficients[row][2], ufoCurve.segments[s].coefficients[row][3]
+      );
+  for(unsigned int i = 0; i < tableSize; i++)
+    texels[3*segmentCount + i/4][i%4] = ufoCurve.parameters[i];
+
+  gpuMotion.curveShape = glm::vec4((float)segmentCount, (float)(tableSize - 1), ufoCurve.distanceScale, ufoCurve.totalLength);
+
+  glGenBuffers(1, &gpuMotion.curveBuffer);
+  glBindBuffer(GL_TEXTURE_BUFFER, gpuMotion.curveBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::vec4), &texels[0], GL_STATIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glGenTextures(1, &gpuMotion.curveTexture);
+  glActiveTexture(GL_TEXTURE0 + UFO_CURVE_TEXTURE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, gpuMotion.curveTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, gpuMotion.curveBuffer);
+  glActiveTexture(GL_TEXTURE0);
+
+  CHECK_GL_ERROR();
+}
+
+void cleanupGpuMotion(void) {
+
+  deleteMotionBuffer(gpuMotion.asteroids);
+  deleteMotionBuffer(gpuMotion.ufos);
+
+  glDeleteTextures(1, &gpuMotion.curveTexture);
+  glDeleteBuffers(1, &gpuMotion.curveBuffer);
+}
+
+// record of the object anchored at its current position and time
+static void appendMotionRecord(std::vector<glm::vec4> &texels, const ObjectPool &pool, unsigned int index,
+                               const glm::vec3 &anchorPosition, float rotationSpeed) {
+
+  texels.push_back(glm::vec4(anchorPosition, pool.size[index]));
+  texels.push_back(glm::vec4(pool.direction[index], pool.speed[index]));
+  texels.push_back(glm::vec4(rotationSpeed, pool.startTime[index], pool.currentTime[index], 0.0f));
+}
+
+// asteroids continue from their current position, ufos are placed relative to their initial position
+static void appendMotionRecord(std::vector<glm::vec4> &texels, const AsteroidPool &asteroids, unsigned int index) {
+
+  appendMotionRecord(texels, asteroids, index, asteroids.position[index], asteroids.rotationSpeed[index]);
+}
+
+static void appendMotionRecord(std::vector<glm::vec4> &texels, const UfoPool &ufos, unsigned int index) {
+
+  appendMotionRecord(texels, ufos, index, ufos.initPosition[index], ufos.rotationSpeed[index]);
+}
+
+template <class Pool>
+static unsigned int updateMotionBuffer(MotionBuffer &buffer, const Pool &pool) {
+
+  const unsigned int count = motionObjectCount(pool);
+
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer.bufferObject);
+
+  // new storage has no valid records
+  if(count > buffer.allocated) {
+    buffer.allocated = std::min(std::max(count, 2 * buffer.allocated), gpuMotion.maxObjects);
+    glBufferData(GL_TEXTURE_BUFFER, buffer.allocated * MOTION_TEXELS * sizeof(glm::vec4), NULL, GL_DYNAMIC_DRAW);
+    buffer.handles.clear();
+  }
+
+  buffer.handles.resize(count, INVALID_OBJECT_HANDLE);
+
+  // ranges of records whose object changed are uploaded by one call each
+  unsigned int uploaded = 0;
+  unsigned int i = 0;
+  while(i < count) {
+    if(buffer.handles[i] == pool.handle[i]) {
+      i++;
+      continue;
+    }
+
+    const unsigned int begin = i;
+    buffer.texels.clear();
+    while(i < count && buffer.handles[i] != pool.handle[i]) {
+      appendMotionRecord(buffer.texels, pool, i);
+      buffer.handles[i] = pool.handle[i];
+      i++;
+    }
+
+    glBufferSubData(GL_TEXTURE_BUFFER, begin * MOTION_TEXELS * sizeof(glm::vec4), buffer.texels.size() * sizeof(glm::vec4), &buffer.texels[0]);
+    uploaded += i - begin;
+  }
+
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  return uploaded;
+}
+
+unsigned int updateGpuMotion(const AsteroidPool &asteroids, const UfoPool &ufos) {
+
+  const unsigned int uploaded = updateMotionBuffer(gpuMotion.asteroids, asteroids) + updateMotionBuffer(gpuMotion.ufos, ufos);
+  CHECK_GL_ERROR();
+
+  return uploaded;
+}
+
+unsigned int motionObjectCount(const ObjectPool &pool) {
+
+  return std::min(objectCount(pool), gpuMotion.maxObjects);
+}
@@ -0,0 +1,71 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    gpu_motion.h
+ * \brief   GPU resident motion of asteroids and ufos - their spawn state stays in buffer
+ *          textures and the vertex shader evaluates their transforms from the frame time.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __GPU_MOTION_H
+#define __GPU_MOTION_H
+
+#include <vector>
+#include "pgr.h"
+#include "render_stuff.h"
+#include "spline.h"
+
+// texels of one object record, must match MOTION_TEXELS in lightingInstanced.vert
+//   0: position at the anchor time, size
+//   1: direction, speed
+//   2: rotation speed, start time, anchor time, unused
+// asteroids move along a straight line from the anchor, ufos follow the curve from their initial position
+#define MOTION_TEXELS 3
+
+// texturing unit of the ufo curve, units 0...4 are used by the material, instance and light textures
+#define UFO_CURVE_TEXTURE_UNIT 5
+
+// records of one pool, in the dense order of the pool
+typedef struct _MotionBuffer {
+  GLuint                    bufferObject;
+  GLuint                    texture;
+  unsigned int              allocated;  // objects the buffer storage can hold
+  std::vector<ObjectHandle> handles;    // object uploaded to each record, compared with the pool handles
+  std::vector<glm::vec4>    texels;     // records of one changed range before the upload
+} MotionBuffer;
+
+typedef struct _GpuMotion {
+  MotionBuffer asteroids;
+  MotionBuffer ufos;
+  unsigned int maxObjects;      // objects of one pool addressable by a buffer texture, the rest is not drawn
+
+  // ufo curve: 3 texels per segment (coefficients a, b, c, d of x, y and z), then 4 arc-length table entries per texel
+  GLuint       curveBuffer;
+  GLuint       curveTexture;
+  glm::vec4    curveShape;      // segments, table intervals, table intervals per unit of distance, total length
+} GpuMotion;
+
+extern GpuMotion gpuMotion;
+
+// creates the buffer textures and uploads the ufo curve, binds the curve to UFO_CURVE_TEXTURE_UNIT
+void initializeGpuMotion(const CurveArcLengthTable &ufoCurve);
+void cleanupGpuMotion(void);
+
+//**************************************************************************************************
+/// Uploads the records of the objects spawned, removed or moved within the pools.
+/**
+ The handle of each pool object is compared with the handle of its record - a differing handle
+ means the object at that dense index was inserted or moved there by the swap-and-pop removal.
+ Only the changed ranges are uploaded, the records of objects moving undisturbed are never
+ touched again. Positions are anchored at the current simulation state, so the analytic motion
+ of the shader continues the motion integrated by updateObjects().
+
+ \param[in]  asteroids  Asteroids of the scene.
+ \param[in]  ufos       Ufos of the scene.
+ \return                Number of uploaded records.
+*/
+unsigned int updateGpuMotion(const AsteroidPool &asteroids, const UfoPool &ufos);
+
+// number of objects of the pool that have a record and can be drawn
+unsigned int motionObjectCount(const ObjectPool &pool);
+
+#endif // __GPU_MOTION_H
@@ -0,0 +1,209 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    job_system.cpp
+ * \brief   Small work-stealing job system for data parallel loops.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "job_system.h"
+
+// number of chunks created per thread - more chunks balance better, fewer chunks cost less
+#define JOB_CHUNKS_PER_THREAD 4
+
+// one parallelFor() call, lives on the stack of the calling thread until all its chunks are done
+typedef struct _JobBatch {
+  JobRangeFunction function;
+  void *data;
+  std::atomic<unsigned int> pendingChunks;
+} JobBatch;
+
+typedef struct _JobChunk {
+  unsigned int begin;
+  unsigned int end;
+  JobBatch *batch;
+} JobChunk;
+
+// chunks owned by one thread - the owner pops from the front, thieves take from the back
+typedef struct _JobQueue {
+  std::mutex mutex;
+  std::deque<JobChunk> chunks;
+} JobQueue;
+
+struct JobSystem {
+
+  std::vector<std::thread> workers;
+  std::vector<JobQueue*> queues;      // queue 0 belongs to the thread calling parallelFor()
+
+  std::mutex mutex;                   // guards batchCounter and quit, used by both condition variables
+  std::condition_variable wakeUp;     // new chunks were queued or the system is stopping
+  std::condition_variable batchDone;  // the last chunk of a batch was finished
+  unsigned int batchCounter;          // incremented for each parallelFor() call
+  bool quit;
+
+} jobSystem;
+
+static bool popChunk(unsigned int queueIndex, JobChunk &chunk) {
+
+  JobQueue *queue = jobSystem.queues[queueIndex];
+  std::lock_guard<std::mutex> lock(queue->mutex);
+
+  if(queue->chunks.empty())
+    return false;
+
+  chunk = queue->chunks.front();
+  queue->chunks.pop_front();
+  return true;
+}
+
+static bool stealChunk(unsigned int thiefIndex, JobChunk &chunk) {
+
+  const unsigned int queueCount = (unsigned int)jobSystem.queues.size();
+
+  for(unsigned int i = 1; i < queueCount; i++) {
+    JobQueue *queue = jobSystem.queues[(thiefIndex + i) % queueCount];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+
+    if(queue->chunks.empty() == false) {
+      chunk = queue->chunks.back();
+      queue->chunks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+static void runChunk(const JobChunk &chunk) {
+
+  JobBatch *batch = chunk.batch;
+  batch->function(chunk.begin, chunk.end, batch->data);
+
+  // batch may be released by its owner as soon as the counter drops to zero
+  if(batch->pendingChunks.fetch_sub(1) == 1) {
+    std::lock_guard<std::mutex> lock(jobSystem.mutex);
+    jobSystem.batchDone.notify_all();
+  }
+}
+
+// processes own chunks first, then steals from the other threads until all queues are empty
+static void processChunks(unsigned int queueIndex) {
+
+  JobChunk chunk;
+  while(popChunk(queueIndex, chunk) || stealChunk(queueIndex, chunk))
+    runChunk(chunk);
+}
+
+static void workerThread(unsigned int queueIndex) {
+
+  unsigned int seenBatch = 0;
+
+  for(;;) {
+    {
+      std::unique_lock<std::mutex> lock(jobSystem.mutex);
+      jobSystem.wakeUp.wait(lock, [&seenBatch] { return jobSystem.quit || jobSystem.batchCounter != seenBatch; });
+
+      if(jobSystem.quit)
+        return;
+
+      seenBatch = jobSystem.batchCounter;
+    }
+
+    processChunks(queueIndex);
+  }
+}
+
+void initializeJobSystem(unsigned int threadCount) {
+
+  finalizeJobSystem();
+
+  jobSystem.quit = false;
+  jobSystem.batchCounter = 0;
+
+  if(threadCount < 1)
+    threadCount = 1;
+
+  for(unsigned int i = 0; i < threadCount; i++)
+    jobSystem.queues.push_back(new JobQueue);
+
+  for(unsigned int i = 1; i < threadCount; i++)
+    jobSystem.workers.push_back(std::thread(workerThread, i));
+}
+
+void finalizeJobSystem(void) {
+
+  {
+    std::lock_guard<std::mutex> lock(jobSystem.mutex);
+    jobSystem.quit = true;
+  }
+  jobSystem.wakeUp.notify_all();
+
+  for(size_t i = 0; i < jobSystem.workers.size(); i++)
+    jobSystem.workers[i].join();
+  jobSystem.workers.clear();
+
+  for(size_t i = 0; i < jobSystem.queues.size(); i++)
+    delete jobSystem.queues[i];
+  jobSystem.queues.clear();
+}
+
+unsigned int jobSystemThreadCount(void) {
+  return (unsigned int)jobSystem.workers.size() + 1;
+}
+
+void parallelFor(unsigned int count, unsigned int grainSize, JobRangeFunction function, void *data) {
+
+  if(count == 0)
+    return;
+
+  if(grainSize < 1)
+    grainSize = 1;
+
+  const unsigned int threadCount = jobSystemThreadCount();
+
+  // single-threaded fallback - no workers or not enough items to be worth splitting
+  if(threadCount == 1 || jobSystem.queues.empty() || count < 2 * grainSize) {
+    function(0, count, data);
+    return;
+  }
+
+  unsigned int chunkSize = (count + threadCount * JOB_CHUNKS_PER_THREAD - 1) / (threadCount * JOB_CHUNKS_PER_THREAD);
+  if(chunkSize < grainSize)
+    chunkSize = grainSize;
+
+  const unsigned int chunkCount = (count + chunkSize - 1) / chunkSize;
+
+  JobBatch batch;
+  batch.function = function;
+  batch.data = data;
+  batch.pendingChunks = chunkCount;
+
+  // consecutive chunks are dealt to the queues in contiguous blocks -> each thread works on a compact range
+  for(unsigned int c = 0; c < chunkCount; c++) {
+    JobChunk chunk;
+    chunk.begin = c * chunkSize;
+    chunk.end = (chunk.begin + chunkSize < count) ? chunk.begin + chunkSize : count;
+    chunk.batch = &batch;
+
+    JobQueue *queue = jobSystem.queues[(unsigned long long)c * threadCount / chunkCount];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->chunks.push_back(chunk);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(jobSystem.mutex);
+    jobSystem.batchCounter++;
+  }
+  jobSystem.wakeUp.notify_all();
+
+  // calling thread works too
+  processChunks(0);
+
+  // wait for chunks still processed by the workers
+  std::unique_lock<std::mutex> lock(jobSystem.mutex);
+  jobSystem.batchDone.wait(lock, [&batch] { return batch.pendingChunks.load() == 0; });
+}
@@ -0,0 +1,55 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    job_system.h
+ * \brief   Small work-stealing job system for data parallel loops.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __JOB_SYSTEM_H
+#define __JOB_SYSTEM_H
+
+// function processing items begin...end-1 of a parallel loop, data is passed from parallelFor()
+typedef void (*JobRangeFunction)(unsigned int begin, unsigned int end, void *data);
+
+//**************************************************************************************************
+/// Starts the worker threads.
+/**
+ The thread calling parallelFor() takes part in the work, therefore threadCount-1 workers are created.
+ With threadCount 0 or 1 no thread is created and all loops run on the calling thread.
+
+ \param[in]  threadCount  Total number of threads processing the loops.
+*/
+void initializeJobSystem(unsigned int threadCount);
+
+/// Stops and joins all worker threads.
+void finalizeJobSystem(void);
+
+/// Number of threads processing the loops, including the calling thread.
+unsigned int jobSystemThreadCount(void);
+
+//**************************************************************************************************
+/// Splits range 0...count-1 into chunks and processes them in parallel.
+/**
+ Chunks are distributed among per-thread queues, idle threads steal chunks from the other queues.
+ The call returns when all chunks are processed. Results are deterministic as long as the function
+ modifies only the items of its own chunk.
+
+ \param[in]  count      Number of items.
+ \param[in]  grainSize  Minimum number of items in one chunk.
+ \param[in]  function   Function called for each chunk.
+ \param[in]  data       User data passed to the function.
+*/
+void parallelFor(unsigned int count, unsigned int grainSize, JobRangeFunction function, void *data);
+
+// calls function object f(begin, end) for each chunk
+template <class Function>
+void invokeJobRange(unsigned int begin, unsigned int end, void *data) {
+  (*static_cast<const Function*>(data))(begin, end);
+}
+
+template <class Function>
+void parallelFor(unsigned int count, unsigned int grainSize, const Function &function) {
+  parallelFor(count, grainSize, invokeJobRange<Function>, const_cast<Function*>(&function));
+}
+
+#endif // __JOB_SYSTEM_H
@@ -0,0 +1,395 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    kinetic_collisions.cpp
+ * \brief   Event driven collisions of objects moving along straight lines - exact contact
+ *          times are kept in a priority queue instead of testing all pairs in each step.
+ *
+ * Follows the kinetic data structures of Basch, Guibas and Hershberger, "Data structures
+ * for mobile data", 1997 - a contact stays valid until one of its objects changes its motion.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include "kinetic_collisions.h"
+#include "data.h"
+
+// time of events that never happen
+#define KINETIC_NEVER 1e30f
+
+// predicted and real position of the space ship differing more than this mean a teleport
+#define KINETIC_POSITION_TOLERANCE 1e-4f
+
+// handle of the space ship in the events
+#define KINETIC_SPACESHIP_HANDLE 0
+
+static const float sceneHalfSize[3] = { SCENE_WIDTH, SCENE_HEIGHT, SCENE_DEPTH };
+
+static inline glm::vec3 trajectoryPosition(const KineticTrajectory &trajectory, float time) {
+  return trajectory.position + (time - trajectory.anchorTime) * trajectory.velocity;
+}
+
+// the segment ends when the object center crosses the border of the scene enlarged by the object size, see checkBounds()
+static void findSegmentEnd(KineticTrajectory &trajectory) {
+
+  trajectory.endTime = trajectory.lifeEnd;
+  trajectory.wrapAxis = -1;
+
+  for(int axis = 0; axis < 3; axis++) {
+    const float velocity = trajectory.velocity[axis];
+    if(velocity == 0.0f)
+      continue;
+
+    const float bound = sceneHalfSize[axis] + trajectory.size;
+    const float border = (velocity > 0.0f) ? bound : -bound;
+    const float time = trajectory.anchorTime + std::max(0.0f, (border - trajectory.position[axis]) / velocity);
+
+    if(time < trajectory.endTime) {
+      trajectory.endTime = time;
+      trajectory.wrapAxis = axis;
+    }
+  }
+}
+
+// starts following the object, it moved along a straight line since beginTime
+static void followObject(KineticTrajectory &trajectory, ObjectHandle handle, const glm::vec3 &position, const glm::vec3 &velocity,
+                         float size, float anchorTime, float beginTime, float lifeEnd) {
+
+  trajectory.handle = handle;
+  trajectory.version++;
+  trajectory.position = position;
+  trajectory.velocity = velocity;
+  trajectory.size = size;
+  trajectory.anchorTime = anchorTime;
+  trajectory.beginTime = std::min(beginTime, anchorTime);
+  trajectory.lifeEnd = lifeEnd;
+  trajectory.contactTime = KINETIC_NEVER;
+
+  findSegmentEnd(trajectory);
+}
+
+static KineticTrajectory& slotTrajectory(std::vector<KineticTrajectory> &trajectories, ObjectHandle handle) {
+
+  const unsigned int slot = handle & HANDLE_SLOT_MASK;
+
+  if(slot >= trajectories.size()) {
+    KineticTrajectory unused;
+    unused.handle = INVALID_OBJECT_HANDLE;
+    unused.version = 0;
+    trajectories.resize(slot + 1, unused);
+  }
+
+  return trajectories[slot];
+}
+
+// trajectory of the object or NULL if the object is not followed
+static KineticTrajectory* findTrajectory(std::vector<KineticTrajectory> &trajectories, ObjectHandle handle) {
+
+  const unsigned int slot = handle & HANDLE_SLOT_MASK;
+
+  if(slot >= trajectories.size() || trajectories[slot].handle != handle)
+    return NULL;
+
+  return &trajectories[slot];
+}
+
+static bool objectAlive(const ObjectPool &pool, ObjectHandle handle) {
+
+  const unsigned int index = objectIndex(pool, handle);
+  return index != INVALID_OBJECT_INDEX && pool.destroyed[index] == false;
+}
+
+// earliest time after from within both segments at which the centers are closer than the radius, KINETIC_NEVER if there is none
+static float contactTime(const KineticTrajectory &first, const KineticTrajectory &second, float radius, float from) {
+
+  const float begin = std::max(from, std::max(first.beginTime, second.beginTime));
+  const float end = std::min(first.endTime, second.endTime);
+  if(begin > end)
+    return KINETIC_NEVER;
+
+  const glm::vec3 offset = trajectoryPosition(first, begin) - trajectoryPosition(second, begin);
+  const glm::vec3 velocity = first.velocity - second.velocity;
+
+  // |offset + t * velocity| = radius, the smaller root is the contact
+  const float c = glm::dot(offset, offset) - radius * radius;
+  if(c <= 0.0f)
+    return begin;
+
+  const float b = glm::dot(offset, velocity);
+  if(b >= 0.0f)
+    return KINETIC_NEVER; // moving apart
+
+  const float a = glm::dot(velocity, velocity);
+  const float discriminant = b * b - a * c;
+  if(discriminant < 0.0f)
+    return KINETIC_NEVER; // passing by
+
+  const float time = begin + (-b - sqrt(discriminant)) / a;
+
+  return (time <= end) ? time : KINETIC_NEVER;
+}
+
+// missile hits the asteroid when it gets into its sphere (see pointInSphere()),
+// space ship when their spheres intersect (see spheresIntersection())
+static inline float contactRadius(int kind, const KineticTrajectory &object, const KineticTrajectory &asteroid) {
+  return (kind == KINETIC_SPACESHIP) ? object.size + asteroid.size : asteroid.size;
+}
+
+// the heap keeps the earliest event on top, contacts go before wraps of the same time
+static bool kineticEventLater(const KineticEvent &a, const KineticEvent &b) {
+
+  if(a.time != b.time)
+    return a.time > b.time;
+  if(a.contact != b.contact)
+    return b.contact;
+  if(a.kind != b.kind)
+    return a.kind > b.kind;
+  if(a.first != b.first)
+    return a.first > b.first;
+  return a.second > b.second;
+}
+
+static void pushEvent(KineticCollisions &kinetic, float time, int kind, bool contact,
+                      const KineticTrajectory &first, const KineticTrajectory *second) {
+
+  KineticEvent event;
+  event.time = time;
+  event.kind = kind;
+  event.contact = contact;
+  event.first = first.handle;
+  event.firstVersion = first.version;
+  event.second = (second != NULL) ? second->handle : INVALID_OBJECT_HANDLE;
+  event.secondVersion = (second != NULL) ? second->version : 0;
+
+  kinetic.events.push_back(event);
+  std::push_heap(kinetic.events.begin(), kinetic.events.end(), kineticEventLater);
+}
+
+static void scheduleWrap(KineticCollisions &kinetic, int kind, const KineticTrajectory &trajectory) {
+
+  if(trajectory.wrapAxis >= 0)
+    pushEvent(kinetic, trajectory.endTime, kind, false, trajectory, NULL);
+}
+
+// queues the contact of the missile or the space ship with the asteroid if it comes before its earliest one
+static void offerContact(KineticCollisions &kinetic, int kind, KineticTrajectory &object, const KineticTrajectory &asteroid) {
+
+  if(object.handle == INVALID_OBJECT_HANDLE)
+    return;
+
+  const float time = contactTime(object, asteroid, contactRadius(kind, object, asteroid), asteroid.beginTime);
+  if(time < object.contactTime) {
+    object.contactTime = time;
+    pushEvent(kinetic, time, kind, true, object, &asteroid);
+  }
+}
+
+// searches the earliest contact of the missile or the space ship with the followed asteroids (except the skipped one)
+// - trajectories are visited in the order of their slots, only a candidate for the earliest contact is looked up in the pool
+static void scheduleEarliestContact(KineticCollisions &kinetic, int kind, KineticTrajectory &object, const AsteroidPool &asteroids,
+                                    float from, ObjectHandle skipped) {
+
+  object.contactTime = KINETIC_NEVER;
+  const KineticTrajectory *earliest = NULL;
+
+  for(size_t slot = 0; slot < kinetic.asteroids.size(); slot++) {
+    const KineticTrajectory &asteroid = kinetic.asteroids[slot];
+    if(asteroid.handle == INVALID_OBJECT_HANDLE || asteroid.handle == skipped)
+      continue;
+
+    const float time = contactTime(object, asteroid, contactRadius(kind, object, asteroid), from);
+    if(time < object.contactTime && objectAlive(asteroids, asteroid.handle) == true) {
+      object.contactTime = time;
+      earliest = &asteroid;
+    }
+  }
+
+  if(earliest != NULL)
+    pushEvent(kinetic, object.contactTime, kind, true, object, earliest);
+}
+
+// contacts of the asteroid with the followed missiles and the space ship
+static void scheduleAsteroidContacts(KineticCollisions &kinetic, const KineticTrajectory &asteroid, const MissilePool &missiles) {
+
+  for(unsigned int m = 0; m < objectCount(missiles); m++) {
+    KineticTrajectory *missile = findTrajectory(kinetic.missiles, missiles.handle[m]);
+    if(missile != NULL && missiles.destroyed[m] == false)
+      offerContact(kinetic, KINETIC_MISSILE, *missile, asteroid);
+  }
+
+  offerContact(kinetic, KINETIC_SPACESHIP, kinetic.spaceShip, asteroid);
+}
+
+// position wrapped the same way as by checkBounds() called in each step
+static glm::vec3 wrappedPosition(const glm::vec3 &position, float size) {
+
+  glm::vec3 result = position;
+  for(int axis = 0; axis < 3; axis++) {
+    const float bound = sceneHalfSize[axis] + size;
+    result[axis] -= 2.0f * bound * floor((result[axis] + bound) / (2.0f * bound));
+  }
+
+  return result;
+}
+
+void resetKineticCollisions(KineticCollisions &kinetic) {
+
+  kinetic.active = false;
+
+  kinetic.asteroids.clear();
+  kinetic.missiles.clear();
+  kinetic.events.clear();
+
+  kinetic.spaceShip.handle = INVALID_OBJECT_HANDLE;
+  kinetic.spaceShip.version = 0;
+}
+
+void syncKineticCollisions(KineticCollisions &kinetic, const AsteroidPool &asteroids, const MissilePool &missiles,
+                           const SpaceShipObject &spaceShip, float time) {
+
+  // everything is taken from the current state, nothing happened before
+  if(kinetic.active == false) {
+    resetKineticCollisions(kinetic);
+    kinetic.active = true;
+    kinetic.syncTime = time;
+    kinetic.asteroidsInserted = asteroids.stats.inserted - 1;
+    kinetic.missilesInserted = missiles.stats.inserted - 1;
+  }
+
+  // steering changes the velocity, a teleport the position of the space ship
+  KineticTrajectory &ship = kinetic.spaceShip;
+  const glm::vec3 shipVelocity = spaceShip.speed * spaceShip.direction;
+
+  bool shipChanged = (ship.handle == INVALID_OBJECT_HANDLE || ship.velocity != shipVelocity);
+  if(shipChanged == false) {
+    const glm::vec3 offset = wrappedPosition(trajectoryPosition(ship, time), ship.size) - spaceShip.position;
+    shipChanged = glm::dot(offset, offset) > KINETIC_POSITION_TOLERANCE * KINETIC_POSITION_TOLERANCE;
+  }
+
+  if(shipChanged == true) {
+    followObject(ship, KINETIC_SPACESHIP_HANDLE, spaceShip.position, shipVelocity, spaceShip.size, time, kinetic.syncTime, KINETIC_NEVER);
+    scheduleWrap(kinetic, KINETIC_SPACESHIP, ship);
+    scheduleEarliestContact(kinetic, KINETIC_SPACESHIP, ship, asteroids, ship.beginTime, INVALID_OBJECT_HANDLE);
+  }
+
+  // pools without insertions have no new objects, removed objects are recognized by their events
+  if(asteroids.stats.inserted != kinetic.asteroidsInserted) {
+    kinetic.asteroidsInserted = asteroids.stats.inserted;
+
+    for(unsigned int a = 0; a < objectCount(asteroids); a++) {
+      KineticTrajectory &asteroid = slotTrajectory(kinetic.asteroids, asteroids.handle[a]);
+      if(asteroid.handle == asteroids.handle[a] || asteroids.destroyed[a] == true)
+        continue;
+
+      followObject(asteroid, asteroids.handle[a], asteroids.position[a], asteroids.speed[a] * asteroids.direction[a], asteroids.size[a],
+                   asteroids.currentTime[a], std::max(asteroids.startTime[a], kinetic.syncTime), KINETIC_NEVER);
+      scheduleWrap(kinetic, KINETIC_ASTEROID, asteroid);
+      scheduleAsteroidContacts(kinetic, asteroid, missiles);
+    }
+  }
+
+  if(missiles.stats.inserted != kinetic.missilesInserted) {
+    kinetic.missilesInserted = missiles.stats.inserted;
+
+    for(unsigned int m = 0; m < objectCount(missiles); m++) {
+      KineticTrajectory &missile = slotTrajectory(kinetic.missiles, missiles.handle[m]);
+      if(missile.handle == missiles.handle[m] || missiles.destroyed[m] == true)
+        continue;
+
+      // missile flies MISSILE_MAX_DISTANCE at most, see updateObjects()
+      const float lifeEnd = (missiles.speed[m] > 0.0f) ? missiles.startTime[m] + MISSILE_MAX_DISTANCE / missiles.speed[m] : KINETIC_NEVER;
+
+      followObject(missile, missiles.handle[m], missiles.position[m], missiles.speed[m] * missiles.direction[m], missiles.size[m],
+                   missiles.currentTime[m], std::max(missiles.startTime[m], kinetic.syncTime), lifeEnd);
+      scheduleWrap(kinetic, KINETIC_MISSILE, missile);
+      scheduleEarliestContact(kinetic, KINETIC_MISSILE, missile, asteroids, missile.beginTime, INVALID_OBJECT_HANDLE);
+    }
+  }
+
+  kinetic.syncTime = time;
+}
+
+// continues the motion on the other side of the scene
+static void wrapTrajectory(KineticTrajectory &trajectory, float time) {
+
+  const int axis = trajectory.wrapAxis;
+  const float bound = sceneHalfSize[axis] + trajectory.size;
+
+  glm::vec3 position = trajectoryPosition(trajectory, time);
+  position[axis] = (trajectory.velocity[axis] > 0.0f) ? -bound : bound;
+
+  followObject(trajectory, trajectory.handle, position, trajectory.velocity, trajectory.size, time, time, trajectory.lifeEnd);
+}
+
+bool nextKineticContact(KineticCollisions &kinetic, const AsteroidPool &asteroids, const MissilePool &missiles,
+                        float time, KineticContact &contact) {
+
+  while(kinetic.events.empty() == false && kinetic.events.front().time <= time) {
+
+    std::pop_heap(kinetic.events.begin(), kinetic.events.end(), kineticEventLater);
+    const KineticEvent event = kinetic.events.back();
+    kinetic.events.pop_back();
+
+    // the first object - space ship, asteroid or missile
+    KineticTrajectory *first = NULL;
+    if(event.kind == KINETIC_SPACESHIP)
+      first = &kinetic.spaceShip;
+    else if(event.kind == KINETIC_ASTEROID && objectAlive(asteroids, event.first) == true)
+      first = findTrajectory(kinetic.asteroids, event.first);
+    else if(event.kind == KINETIC_MISSILE && objectAlive(missiles, event.first) == true)
+      first = findTrajectory(kinetic.missiles, event.first);
+
+    // event of an older segment or of an object destroyed meanwhile
+    if(first == NULL || first->version != event.firstVersion)
+      continue;
+
+    if(event.contact == false) {
+      wrapTrajectory(*first, event.time);
+      scheduleWrap(kinetic, event.kind, *first);
+
+      if(event.kind == KINETIC_ASTEROID)
+        scheduleAsteroidContacts(kinetic, *first, missiles);
+      else
+        scheduleEarliestContact(kinetic, event.kind, *first, asteroids, event.time, INVALID_OBJECT_HANDLE);
+
+      continue;
+    }
+
+    // contacts are always with an asteroid, it may have been destroyed before the earliest contact of the object
+    const KineticTrajectory *asteroid = findTrajectory(kinetic.asteroids, event.second);
+    if(asteroid == NULL || asteroid->version != event.secondVersion || objectAlive(asteroids, event.second) == false) {
+      if(event.time == first->contactTime)
+        scheduleEarliestContact(kinetic, event.kind, *first, asteroids, event.time, INVALID_OBJECT_HANDLE);
+      continue;
+    }
+
+    contact.time = event.time;
+    contact.kind = event.kind;
+    contact.object = event.first;
+    contact.asteroid = event.second;
+    contact.objectPosition = trajectoryPosition(*first, event.time);
+    contact.asteroidPosition = trajectoryPosition(*asteroid, event.time);
+
+    // the space ship flies on, the asteroid is destroyed by the contact
+    if(event.kind == KINETIC_SPACESHIP)
+      scheduleEarliestContact(kinetic, KINETIC_SPACESHIP, *first, asteroids, event.time, event.second);
+
+    return true;
+  }
+
+  return false;
+}
+
+void insertKineticAsteroid(KineticCollisions &kinetic, const AsteroidPool &asteroids, const MissilePool &missiles,
+                           ObjectHandle handle, const glm::vec3 &position, float time) {
+
+  const unsigned int index = objectIndex(asteroids, handle);
+  if(index == INVALID_OBJECT_INDEX)
+    return;
+
+  KineticTrajectory &asteroid = slotTrajectory(kinetic.asteroids, handle);
+
+  followObject(asteroid, handle, position, asteroids.speed[index] * asteroids.direction[index], asteroids.size[index], time, time, KINETIC_NEVER);
+  scheduleWrap(kinetic, KINETIC_ASTEROID, asteroid);
+  scheduleAsteroidContacts(kinetic, asteroid, missiles);
+}
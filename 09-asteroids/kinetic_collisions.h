@@ -0,0 +1,119 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    kinetic_collisions.h
+ * \brief   Event driven collisions of objects moving along straight lines - exact contact
+ *          times are kept in a priority queue instead of testing all pairs in each step.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __KINETIC_COLLISIONS_H
+#define __KINETIC_COLLISIONS_H
+
+#include <vector>
+#include "pgr.h" // glm
+#include "object_pool.h"
+
+// objects followed by the kinetic collisions, ufos move along a curve and are tested in each step
+enum KineticObjectKind {
+  KINETIC_SPACESHIP,
+  KINETIC_ASTEROID,
+  KINETIC_MISSILE
+};
+
+// straight motion of one object between two changes of its trajectory
+// - position at time t is position + (t - anchorTime) * velocity
+// - the segment ends when the object wraps around the scene (see checkBounds()) or the missile expires
+typedef struct _KineticTrajectory {
+  ObjectHandle handle;      // object of the pool, INVALID_OBJECT_HANDLE for an unused slot
+  unsigned int version;     // incremented with each new segment, events of older segments are stale
+  glm::vec3    position;
+  glm::vec3    velocity;
+  float        size;
+  float        anchorTime;
+  float        beginTime;   // contacts are searched from this time
+  float        endTime;     // end of the segment
+  float        lifeEnd;     // missile expires at this time, the segments of other objects end by wraps only
+  int          wrapAxis;    // axis crossing the scene border at endTime, -1 if the segment does not end by a wrap
+  float        contactTime; // earliest contact of the missile or the space ship in the queue
+} KineticTrajectory;
+
+// wrap of an object or a contact of a pair, valid while the segments it was computed from last
+// - only the earliest contact of each missile and of the space ship is queued, the missile is gone after it
+//   and the next contact of the space ship is searched when it happens
+typedef struct _KineticEvent {
+  float        time;
+  int          kind;          // KineticObjectKind of the first object, a contact is always with an asteroid
+  bool         contact;       // false -> the first object wraps around the scene
+  ObjectHandle first;
+  ObjectHandle second;
+  unsigned int firstVersion;
+  unsigned int secondVersion;
+} KineticEvent;
+
+// contact returned by nextKineticContact(), positions are taken at the contact time
+typedef struct _KineticContact {
+  float        time;
+  int          kind;          // KINETIC_MISSILE or KINETIC_SPACESHIP
+  ObjectHandle object;        // handle of the missile, unused for the space ship
+  ObjectHandle asteroid;
+  glm::vec3    objectPosition;
+  glm::vec3    asteroidPosition;
+} KineticContact;
+
+typedef struct _KineticCollisions {
+  bool               active;            // false until the first synchronization after a reset
+
+  std::vector<KineticTrajectory> asteroids;  // handle slot -> trajectory
+  std::vector<KineticTrajectory> missiles;   // handle slot -> trajectory
+  KineticTrajectory  spaceShip;
+
+  std::vector<KineticEvent> events;     // binary heap, the earliest event on top
+
+  float              syncTime;          // time of the last synchronization
+  unsigned long long asteroidsInserted; // pool insertions seen by the last synchronization
+  unsigned long long missilesInserted;
+} KineticCollisions;
+
+// forgets all trajectories and events, the next synchronization takes all objects again
+void resetKineticCollisions(KineticCollisions &kinetic);
+
+//**************************************************************************************************
+/// Takes objects inserted to the pools and the changed space ship trajectory.
+/**
+ Objects are recognized by their handles, so only the pools with insertions since the last call are
+ scanned. Objects inserted or steered since the last call are followed from that time - they moved
+ along a straight line since then. Asteroids and missiles never change their motion otherwise,
+ their trajectories are followed without looking at the pools again.
+
+ \param[in,out] kinetic    Trajectories and events.
+ \param[in]     asteroids  Asteroids of the scene.
+ \param[in]     missiles   Missiles of the scene.
+ \param[in]     spaceShip  Space ship of the scene.
+ \param[in]     time       Current time of the simulation, objects are at their positions of this time.
+*/
+void syncKineticCollisions(KineticCollisions &kinetic, const AsteroidPool &asteroids, const MissilePool &missiles,
+                           const SpaceShipObject &spaceShip, float time);
+
+//**************************************************************************************************
+/// Processes events up to the given time until the next contact.
+/**
+ Wraps around the scene start new segments and compute the contacts of their objects again. Contacts
+ of objects destroyed or removed meanwhile are skipped. The caller applies the contact (and marks
+ the objects destroyed) before asking for the next one, contacts are returned in the order of time.
+
+ \param[in,out] kinetic    Trajectories and events.
+ \param[in]     asteroids  Asteroids of the scene.
+ \param[in]     missiles   Missiles of the scene.
+ \param[in]     time       Events after this time stay in the queue.
+ \param[out]    contact    The earliest contact.
+ \return                   False when there is no other contact up to the given time.
+*/
+bool nextKineticContact(KineticCollisions &kinetic, const AsteroidPool &asteroids, const MissilePool &missiles,
+                        float time, KineticContact &contact);
+
+// follows an asteroid inserted while the contacts are processed (a part of a broken asteroid),
+// it is at the given position at the contact time and moves with its pool speed and direction
+void insertKineticAsteroid(KineticCollisions &kinetic, const AsteroidPool &asteroids, const MissilePool &missiles,
+                           ObjectHandle handle, const glm::vec3 &position, float time);
+
+#endif // __KINETIC_COLLISIONS_H
@@ -0,0 +1,296 @@
+#version 140
+
+// IMPORTANT: !!! lighting is evaluated in camera space !!!
+
+// instanced variant of lightingPerVertex.vert
+// - per-instance transforms and material tints are fetched from a buffer texture,
+//   each instance occupies INSTANCE_TEXELS consecutive texels:
+//   0..3 model matrix columns, 4..6 normal matrix columns, 7 material tints
+// - or the transforms are evaluated from the spawn state of the objects (MOTION_TEXELS per
+//   instance, see gpu_motion.h) at the frame time, the same way as updateObjects() moves them
+
+struct Material {      // structure that describes currently used material
+  vec3  ambient;       // ambient component
+  vec3  diffuse;       // diffuse component
+  vec3  specular;      // specular component
+  float shininess;     // sharpness of specular reflection
+
+  bool  useTexture;    // defines whether the texture is used or not
+};
+
+// warning: sampler inside the Material struct can cause problems -> so its outside
+uniform sampler2D texSampler;  // sampler for the texture access
+
+struct Light {         // structure describing light parameters
+  vec3  ambient;       // intensity & color of the ambient component
+  vec3  diffuse;       // intensity & color of the diffuse component
+  vec3  specular;      // intensity & color of the specular component
+  vec3  position;      // light position
+  vec3  spotDirection; // spotlight direction
+  float spotCosCutOff; // cosine of the spotlight's half angle
+  float spotExponent;  // distribution of the light energy within the reflector's cone (center->cone's edge)
+};
+
+// per-frame data shared by the programs, filled once per frame by setFrameUniforms()
+layout(std140) uniform FrameData {
+  mat4  Vmatrix;            // View              --> world to eye coordinates
+  mat4  Pmatrix;            // Projection        --> eye to clip coordinates
+  mat4  PVmatrix;           // Projection * View --> world to clip coordinates
+  vec4  sunDirection;       // direction to the sun (eye coordinates)
+  vec4  reflectorPosition;  // space ship reflector position (eye coordinates)
+  vec4  reflectorDirection; // space ship reflector direction (eye coordinates, normalized)
+  vec4  clusterScale;       // light clusters per pixel (xy), depth slice scale and bias (zw)
+  float time;               // elapsed time in seconds
+  float clusterLogDepth;    // 1 -> depth slices are logarithmic, 0 -> linear
+};
+
+in vec3 position;           // vertex position in world space
+in vec3 normal;             // vertex normal
+in vec2 texCoord;           // incoming texture coordinates
+
+uniform Material material;  // current material
+
+const int INSTANCE_TEXELS = 8;
+const int MOTION_TEXELS = 3;
+
+// source of the instance transforms
+const int INSTANCE_MOTION_NONE  = 0; // matrices in instanceData
+const int INSTANCE_MOTION_LINE  = 1; // asteroid records, straight line with wrap-around
+const int INSTANCE_MOTION_CURVE = 2; // ufo records, ufo curve followed from the initial position
+
+uniform samplerBuffer instanceData; // per-instance data of all objects drawn in the frame
+uniform int instanceBase;           // index of the first instance of the current draw call
+uniform int instanceTint;           // which tint (component of the tint texel) scales the material
+uniform int instanceMotion;         // INSTANCE_MOTION_*
+
+uniform vec3 sceneSize;             // positions wrap at sceneSize + object size, see checkBounds()
+uniform samplerBuffer ufoCurve;     // 3 texels of coefficients per segment, then 4 arc-length table entries per texel
+uniform vec4 ufoCurveShape;         // segments, table intervals, table intervals per unit of distance, total length
+
+smooth out vec2 texCoord_v;  // outgoing texture coordinates
+smooth out vec4 color_v;     // outgoing fragment color
+smooth out vec3 position_v;  // eye space position and normal for the point lights
+smooth out vec3 normal_v;
+smooth out vec3 diffuse_v;   // material lit by the point lights
+smooth out vec3 specular_v;
+
+
+vec4 spotLight(Light light, Material material, vec3 vertexPosition, vec3 vertexNormal) {
+
+  vec3 ret = vec3(0.0);
+
+  // use the material and light structures to obtain the surface and light properties
+  // the vertexPosition and vertexNormal variables contain transformed surface position and normal
+  // store the ambient, diffuse and specular terms to the ret variable
+  // for spot lights, light.position contains the light position
+  // everything is expressed in the view coordinate system -> eye/camera is in the origin
+
+  vec3 L = normalize(light.position - vertexPosition);
+  vec3 R = reflect(-L, vertexNormal);
+  vec3 V = normalize(-vertexPosition);
+  float NdotL = max(0.0, dot(vertexNormal, L));
+  float RdotV = max(0.0, dot(R, V));
+  float spotCoef = max(0.0, dot(-L, light.spotDirection));
+
+  ret += material.ambient * light.ambient;
+  ret += material.diffuse * light.diffuse * NdotL;
+  ret += material.specular * light.specular * pow(RdotV, material.shininess);
+
+  if(spotCoef < light.spotCosCutOff)
+    ret *= 0.0;
+  else
+    ret *= pow(spotCoef, light.spotExponent);
+
+  return vec4(ret, 1.0);
+}
+
+vec4 directionalLight(Light light, Material material, vec3 vertexPosition, vec3 vertexNormal) {
+
+  vec3 ret = vec3(0.0);
+
+  // use the material and light structures to obtain the surface and light properties
+  // the vertexPosition and vertexNormal variables contain transformed surface position and normal
+  // store the ambient, diffuse and specular terms to the ret variable
+  // glsl provides some built-in functions, for example: reflect, normalize, pow, dot
+  // for directional lights, light.position contains the direction
+  // everything is expressed in the view coordinate system -> eye/camera is in the origin
+
+  vec3 L = normalize(light.position);
+  vec3 R = reflect(-L, vertexNormal);
+  vec3 V = normalize(-vertexPosition);
+  float NdotL = max(0.0, dot(vertexNormal, L));
+  float RdotV = max(0.0, dot(R, V));
+
+  ret += material.ambient * light.ambient;
+  ret += material.diffuse * light.diffuse * NdotL;
+  ret += material.specular * light.specular * pow(RdotV, material.shininess);
+
+  return vec4(ret, 1.0);
+}
+
+// position wrapped into the scene like checkBounds() does
+vec3 wrapPosition(vec3 position, float size) {
+
+  vec3 bounds = sceneSize + vec3(size);
+  return mod(position + bounds, 2.0 * bounds) - bounds;
+}
+
+// asteroid - straight line from the anchor position, rotation around z, see asteroidModelMatrix()
+void lineMotion(int texel, out mat4 Mmatrix, out mat3 normalMatrix) {
+
+  vec4 anchor    = texelFetch(instanceData, texel + 0);  // position, size
+  vec4 direction = texelFetch(instanceData, texel + 1);  // direction, speed
+  vec4 times     = texelFetch(instanceData, texel + 2);  // rotation speed, start time, anchor time
+
+  vec3 position = wrapPosition(anchor.xyz + (time - times.z) * direction.w * direction.xyz, anchor.w);
+
+  float angle = times.x * (time - times.y);
+  float c = cos(angle);
+  float s = sin(angle);
+
+  normalMatrix = mat3(vec3(c, s, 0.0), vec3(-s, c, 0.0), vec3(0.0, 0.0, 1.0));
+  Mmatrix = mat4(
+    vec4(anchor.w * normalMatrix[0], 0.0),
+    vec4(anchor.w * normalMatrix[1], 0.0),
+    vec4(anchor.w * normalMatrix[2], 0.0),
+    vec4(position, 1.0)
+  );
+}
+
+float curveTableEntry(int index) {
+
+  return texelFetch(ufoCurve, 3 * int(ufoCurveShape.x) + index / 4)[index % 4];
+}
+
+// curve parameter of the distance along the ufo curve, see curveArcLengthToParameter()
+float curveParameter(float distance) {
+
+  if(ufoCurveShape.w <= 0.0)
+    return 0.0;
+
+  float position = mod(distance, ufoCurveShape.w) * ufoCurveShape.z;
+  int index = min(int(position), int(ufoCurveShape.y) - 1);
+
+  return mix(curveTableEntry(index), curveTableEntry(index + 1), position - float(index));
+}
+
+// ufo - ufo curve with constant speed from the initial position, see updateObjects() and ufoModelMatrix()
+void curveMotion(int texel, out mat4 Mmatrix, out mat3 normalMatrix, out float blink) {
+
+  vec4 anchor    = texelFetch(instanceData, texel + 0);  // initial position, size
+  vec4 direction = texelFetch(instanceData, texel + 1);  // unused, speed
+  vec4 times     = texelFetch(instanceData, texel + 2);  // rotation speed, start time
+
+  float age = time - times.y;
+
+  // speed is given in curve parameter units per second -> the same average speed in distance units
+  float distance = ufoCurveShape.w / ufoCurveShape.x * direction.w * age;
+  float parameter = mod(curveParameter(distance), ufoCurveShape.x);
+
+  int segment = min(int(parameter), int(ufoCurveShape.x) - 1);
+  float t = parameter - float(segment);
+
+  vec4 powers = vec4(t * t * t, t * t, t, 1.0);
+  vec4 derivativePowers = vec4(3.0 * t * t, 2.0 * t, 1.0, 0.0);
+  mat4x3 coefficients = transpose(mat3x4(
+    texelFetch(ufoCurve, 3 * segment + 0),
+    texelFetch(ufoCurve, 3 * segment + 1),
+    texelFetch(ufoCurve, 3 * segment + 2)
+  ));
+
+  vec3 position = wrapPosition(anchor.xyz + coefficients * powers, anchor.w);
+  vec3 tangent = coefficients * derivativePowers;
+
+  // alignObject() with the up vector +z
+  vec3 zAxis = (dot(tangent, tangent) > 0.0) ? -normalize(tangent) : vec3(-1.0, 0.0, 0.0);
+  vec3 xAxis = cross(vec3(0.0, 0.0, 1.0), zAxis);
+  xAxis = (dot(xAxis, xAxis) > 0.0) ? normalize(xAxis) : vec3(1.0, 0.0, 0.0);
+  vec3 yAxis = cross(zAxis, xAxis);
+
+  normalMatrix = mat3(xAxis, yAxis, zAxis);
+  Mmatrix = mat4(
+    vec4(anchor.w * xAxis, 0.0),
+    vec4(anchor.w * yAxis, 0.0),
+    vec4(anchor.w * zAxis, 0.0),
+    vec4(position, 1.0)
+  );
+
+  // see ufoBlinkFactor()
+  blink = 0.5 * (cos(6.28 * 0.33 * age) + 1.0);
+}
+
+void main() {
+
+  // hardcoded lights, their positions and directions are prepared once per frame in the FrameData block
+  Light sun = Light(
+    vec3(0.0), vec3(1.0, 1.0, 0.5f), vec3(1.0),  // ambient, diffuse, specular
+    sunDirection.xyz, vec3(0.0), 0.0, 0.0
+  );
+  Light spaceShipReflector = Light(
+    vec3(0.2f), vec3(1.0), vec3(1.0),            // ambient, diffuse, specular
+    reflectorPosition.xyz, reflectorDirection.xyz,
+    0.95f, 0.0                                   // spotCosCutOff, spotExponent
+  );
+
+  mat4 Mmatrix;
+  mat3 normalMatrix;
+  vec4 tints = vec4(1.0);
+
+  if(instanceMotion == INSTANCE_MOTION_LINE) {
+    lineMotion((instanceBase + gl_InstanceID) * MOTION_TEXELS, Mmatrix, normalMatrix);
+  }
+  else if(instanceMotion == INSTANCE_MOTION_CURVE) {
+    float blink;
+    curveMotion((instanceBase + gl_InstanceID) * MOTION_TEXELS, Mmatrix, normalMatrix, blink);
+    tints = vec4(blink, 1.0 - blink, 1.0, 1.0);
+  }
+  else {
+    int texel = (instanceBase + gl_InstanceID) * INSTANCE_TEXELS;
+
+    Mmatrix = mat4(
+      texelFetch(instanceData, texel + 0),
+      texelFetch(instanceData, texel + 1),
+      texelFetch(instanceData, texel + 2),
+      texelFetch(instanceData, texel + 3)
+    );
+    normalMatrix = mat3(
+      texelFetch(instanceData, texel + 4).xyz,
+      texelFetch(instanceData, texel + 5).xyz,
+      texelFetch(instanceData, texel + 6).xyz
+    );
+    tints = texelFetch(instanceData, texel + 7);
+  }
+  float tint = tints[instanceTint];
+
+  Material instanceMaterial = material;
+  instanceMaterial.ambient  *= tint;
+  instanceMaterial.diffuse  *= tint;
+  instanceMaterial.specular *= tint;
+
+  // eye-coordinates position and normal of vertex
+  vec4 worldPosition  = Mmatrix * vec4(position, 1.0);
+  vec4 eyePosition    = Vmatrix * worldPosition;
+  vec3 vertexPosition = eyePosition.xyz;                                                 // vertex in eye coordinates
+  vec3 vertexNormal   = normalize( (Vmatrix * vec4(normalMatrix * normal, 0.0) ).xyz);   // normal in eye coordinates by NormalMatrix
+
+  // initialize the output color with the global ambient term
+  vec3 globalAmbientLight = vec3(0.4f);
+  vec4 outputColor = vec4(instanceMaterial.ambient * globalAmbientLight, 0.0);
+
+  // accumulate contributions from all lights
+  outputColor += directionalLight(sun, instanceMaterial, vertexPosition, vertexNormal);
+  outputColor += spotLight(spaceShipReflector, instanceMaterial, vertexPosition, vertexNormal);
+
+  // vertex position after the projection (gl_Position is built-in output variable)
+  gl_Position = Pmatrix * eyePosition;   // out:v vertex in clip coordinates
+
+  // outputs entering the fragment shader
+  color_v = outputColor;
+  texCoord_v = texCoord;
+
+  // point lights are evaluated per fragment, only the ones of the fragment's cluster
+  position_v = vertexPosition;
+  normal_v = vertexNormal;
+  diffuse_v = instanceMaterial.diffuse;
+  specular_v = instanceMaterial.specular;
+}
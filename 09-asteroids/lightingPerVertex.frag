@@ -9,19 +9,81 @@ struct Material {           // structure that describes currently used material
   bool  useTexture;         // defines whether the texture is used or not
 };
 
+// per-frame data shared by the programs, filled once per frame by setFrameUniforms()
+layout(std140) uniform FrameData {
+  mat4  Vmatrix;            // View              --> world to eye coordinates
+  mat4  Pmatrix;            // Projection        --> eye to clip coordinates
+  mat4  PVmatrix;           // Projection * View --> world to clip coordinates
+  vec4  sunDirection;       // direction to the sun (eye coordinates)
+  vec4  reflectorPosition;  // space ship reflector position (eye coordinates)
+  vec4  reflectorDirection; // space ship reflector direction (eye coordinates, normalized)
+  vec4  clusterScale;       // light clusters per pixel (xy), depth slice scale and bias (zw)
+  float time;               // elapsed time in seconds
+  float clusterLogDepth;    // 1 -> depth slices are logarithmic, 0 -> linear
+};
+
+// cells of the light grid, must match CLUSTER_GRID_* in clustered_lights.h
+const int CLUSTER_GRID_X = 16;
+const int CLUSTER_GRID_Y = 9;
+const int CLUSTER_GRID_Z = 24;
+
 uniform sampler2D texSampler;  // sampler for the texture access
 
+uniform samplerBuffer  pointLights;    // 2 texels per light: eye position and radius, color
+uniform usamplerBuffer lightClusters;  // offset and number of the light indices of each cluster
+uniform usamplerBuffer lightIndices;   // light indices of all clusters
+
 uniform Material material;     // current material
 
 smooth in vec4 color_v;        // incoming fragment color (includes lighting)
 smooth in vec2 texCoord_v;     // fragment texture coordinates
+smooth in vec3 position_v;     // eye space position and normal for the point lights
+smooth in vec3 normal_v;
+smooth in vec3 diffuse_v;      // material lit by the point lights
+smooth in vec3 specular_v;
 out vec4       color_f;        // outgoing fragment color
 
+// diffuse and specular terms of the point lights of the fragment's cluster
+vec3 clusteredPointLights(vec3 vertexPosition, vec3 vertexNormal) {
+
+  float depth = -vertexPosition.z;
+  float slice = (clusterLogDepth > 0.5) ? log(max(depth, 1.0e-4)) : depth;
+
+  ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * clusterScale.xy), int(floor(slice * clusterScale.z + clusterScale.w)));
+  cluster = clamp(cluster, ivec3(0), ivec3(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1, CLUSTER_GRID_Z - 1));
+
+  uvec2 range = texelFetch(lightClusters, cluster.x + CLUSTER_GRID_X * (cluster.y + CLUSTER_GRID_Y * cluster.z)).rg;
+
+  vec3 V = normalize(-vertexPosition);
+  vec3 ret = vec3(0.0);
+
+  for(uint i = 0u; i < range.y; i++) {
+    int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+    vec4 positionRadius = texelFetch(pointLights, 2 * light);
+    vec3 color = texelFetch(pointLights, 2 * light + 1).rgb;
+
+    vec3 L = positionRadius.xyz - vertexPosition;
+    float distance2 = dot(L, L);
+
+    // smooth falloff reaching zero at the radius, the clusters do not contain the light further away
+    float attenuation = max(0.0, 1.0 - distance2 / (positionRadius.w * positionRadius.w));
+    attenuation *= attenuation;
+
+    L *= inversesqrt(max(distance2, 1.0e-8));
+    float NdotL = max(0.0, dot(vertexNormal, L));
+    float RdotV = max(0.0, dot(reflect(-L, vertexNormal), V));
+
+    ret += attenuation * color * (diffuse_v * NdotL + specular_v * pow(RdotV, material.shininess));
+  }
+
+  return ret;
+}
+
 void main() {
 
-  color_f = color_v;
+  color_f = color_v + vec4(clusteredPointLights(position_v, normalize(normal_v)), 0.0);
 
   // if material has a texture -> apply it
   if(material.useTexture)
-    color_f =  color_v * texture(texSampler, texCoord_v);
+    color_f =  color_f * texture(texSampler, texCoord_v);
 }
@@ -24,23 +24,34 @@ struct Light {         // structure describing light parameters
   float spotExponent;  // distribution of the light energy within the reflector's cone (center->cone's edge)
 };
 
+// per-frame data shared by the programs, filled once per frame by setFrameUniforms()
+layout(std140) uniform FrameData {
+  mat4  Vmatrix;            // View              --> world to eye coordinates
+  mat4  Pmatrix;            // Projection        --> eye to clip coordinates
+  mat4  PVmatrix;           // Projection * View --> world to clip coordinates
+  vec4  sunDirection;       // direction to the sun (eye coordinates)
+  vec4  reflectorPosition;  // space ship reflector position (eye coordinates)
+  vec4  reflectorDirection; // space ship reflector direction (eye coordinates, normalized)
+  vec4  clusterScale;       // light clusters per pixel (xy), depth slice scale and bias (zw)
+  float time;               // elapsed time in seconds
+  float clusterLogDepth;    // 1 -> depth slices are logarithmic, 0 -> linear
+};
+
 in vec3 position;           // vertex position in world space
 in vec3 normal;             // vertex normal
 in vec2 texCoord;           // incoming texture coordinates
 
-uniform float time;         // time used for simulation of moving lights (such as sun)
 uniform Material material;  // current material
 
-uniform mat4 PVMmatrix;     // Projection * View * Model  --> model to clip coordinates
-uniform mat4 Vmatrix;       // View                       --> world to eye coordinates
 uniform mat4 Mmatrix;       // Model                      --> model to world coordinates
 uniform mat4 normalMatrix;  // inverse transposed Mmatrix
 
-uniform vec3 reflectorPosition;   // reflector position (world coordinates)
-uniform vec3 reflectorDirection;  // reflector direction (world coordinates)
-
 smooth out vec2 texCoord_v;  // outgoing texture coordinates
 smooth out vec4 color_v;     // outgoing fragment color
+smooth out vec3 position_v;  // eye space position and normal for the point lights
+smooth out vec3 normal_v;
+smooth out vec3 diffuse_v;   // material lit by the point lights
+smooth out vec3 specular_v;
 
 
 vec4 spotLight(Light light, Material material, vec3 vertexPosition, vec3 vertexNormal) {
@@ -96,38 +107,22 @@ vec4 directionalLight(Light light, Material material, vec3 vertexPosition, vec3
   return vec4(ret, 1.0);
 }
 
-// hardcoded lights
-Light sun;
-float sunSpeed = 0.5f;
-Light spaceShipReflector;
-
-void setupLights() {
-
-  // set up sun parameters
-  sun.ambient  = vec3(0.0);
-  sun.diffuse  = vec3(1.0, 1.0, 0.5f);
-  sun.specular = vec3(1.0);
-
-  sun.position = (Vmatrix * vec4(cos(time * sunSpeed), 0.0, sin(time * sunSpeed), 0.0)).xyz;
-  //sun.position = (Vmatrix * vec4(1.0, 1.0, 1.0, 0.0)).xyz;
-
-  // set up reflector parameters
-  spaceShipReflector.ambient       = vec3(0.2f);
-  spaceShipReflector.diffuse       = vec3(1.0);
-  spaceShipReflector.specular      = vec3(1.0);
-  spaceShipReflector.spotCosCutOff = 0.95f;
-  spaceShipReflector.spotExponent  = 0.0;
-
-  spaceShipReflector.position = (Vmatrix * vec4(reflectorPosition, 1.0)).xyz;
-  spaceShipReflector.spotDirection = normalize((Vmatrix * vec4(reflectorDirection, 0.0)).xyz);
-}
-
 void main() {
 
-  setupLights();
+  // hardcoded lights, their positions and directions are prepared once per frame in the FrameData block
+  Light sun = Light(
+    vec3(0.0), vec3(1.0, 1.0, 0.5f), vec3(1.0),  // ambient, diffuse, specular
+    sunDirection.xyz, vec3(0.0), 0.0, 0.0
+  );
+  Light spaceShipReflector = Light(
+    vec3(0.2f), vec3(1.0), vec3(1.0),            // ambient, diffuse, specular
+    reflectorPosition.xyz, reflectorDirection.xyz,
+    0.95f, 0.0                                   // spotCosCutOff, spotExponent
+  );
 
   // eye-coordinates position and normal of vertex
-  vec3 vertexPosition = (Vmatrix * Mmatrix * vec4(position, 1.0)).xyz;         // vertex in eye coordinates
+  vec4 eyePosition    = Vmatrix * Mmatrix * vec4(position, 1.0);
+  vec3 vertexPosition = eyePosition.xyz;                                                 // vertex in eye coordinates
   vec3 vertexNormal   = normalize( (Vmatrix * normalMatrix * vec4(normal, 0.0) ).xyz);   // normal in eye coordinates by NormalMatrix
 
   // initialize the output color with the global ambient term
@@ -139,9 +134,15 @@ void main() {
   outputColor += spotLight(spaceShipReflector, material, vertexPosition, vertexNormal);
 
   // vertex position after the projection (gl_Position is built-in output variable)
-  gl_Position = PVMmatrix * vec4(position, 1);   // out:v vertex in clip coordinates
+  gl_Position = Pmatrix * eyePosition;   // out:v vertex in clip coordinates
 
   // outputs entering the fragment shader
   color_v = outputColor;
   texCoord_v = texCoord;
+
+  // point lights are evaluated per fragment, only the ones of the fragment's cluster
+  position_v = vertexPosition;
+  normal_v = vertexNormal;
+  diffuse_v = material.diffuse;
+  specular_v = material.specular;
 }
@@ -0,0 +1,619 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    mesh_cache.cpp
+ * \brief   Binary cache of meshes imported by Assimp, read through a memory mapped file.
+ *
+ * Cache file layout (native byte order):
+ *   MeshCacheHeader | texture name | padding to 16 bytes | vertex data | index data of all levels of detail
+ *
+ * Vertex cache optimization follows Tom Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "mesh_cache.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME        1099511628211ULL
+
+// size of the cache simulated by the vertex cache optimization, scores of vertices beyond it are not tracked
+#define VERTEX_CACHE_SIZE 32
+
+static const char MESH_CACHE_MAGIC[4] = { 'M', 'S', 'H', 'C' };
+
+typedef struct _MeshCacheHeader {
+  char               magic[4];
+  unsigned int       version;
+  unsigned long long sourceHash;
+  unsigned int       vertexCount;
+  unsigned int       triangleCount;
+  unsigned long long vertexDataSize;
+  unsigned long long indexDataSize;
+  float              ambient[3];
+  float              diffuse[3];
+  float              specular[3];
+  float              shininess;
+  unsigned int       indexType;
+  unsigned int       normalType;
+  unsigned int       textureNameLength;
+  unsigned int       lodCount;
+  unsigned int       lodTriangleCount[MESH_LODS_MAX];
+  unsigned int       headerSize;  // sizeof(MeshCacheHeader) of the writer, catches differently packed builds
+} MeshCacheHeader;
+
+// offset of the vertex data in the cache file, buffers start 16 bytes aligned
+static size_t vertexDataOffset(unsigned int textureNameLength) {
+  return (sizeof(MeshCacheHeader) + textureNameLength + 15) & ~(size_t)15;
+}
+
+bool mapFile(const std::string &fileName, MappedFile &file) {
+
+  file.data = NULL;
+  file.size = 0;
+
+#ifdef _WIN32
+  file.mappingHandle = NULL;
+  file.fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file.fileHandle == INVALID_HANDLE_VALUE) {
+    file.fileHandle = NULL;
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if(GetFileSizeEx(file.fileHandle, &size) == FALSE || size.QuadPart == 0) {
+    unmapFile(file);
+    return false;
+  }
+
+  file.mappingHandle = CreateFileMappingA(file.fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(file.mappingHandle == NULL) {
+    unmapFile(file);
+    return false;
+  }
+
+  file.data = (const unsigned char*)MapViewOfFile(file.mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if(file.data == NULL) {
+    unmapFile(file);
+    return false;
+  }
+  file.size = (size_t)size.QuadPart;
+#else
+  file.fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if(file.fileDescriptor < 0)
+    return false;
+
+  struct stat status;
+  if(fstat(file.fileDescriptor, &status) != 0 || status.st_size == 0) {
+    unmapFile(file);
+    return false;
+  }
+
+  void *data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file.fileDescriptor, 0);
+  if(data == MAP_FAILED) {
+    unmapFile(file);
+    return false;
+  }
+  file.data = (const unsigned char*)data;
+  file.size = (size_t)status.st_size;
+#endif
+
+  return true;
+}
+
+void unmapFile(MappedFile &file) {
+
+#ifdef _WIN32
+  if(file.data != NULL)
+    UnmapViewOfFile(file.data);
+  if(file.mappingHandle != NULL)
+    CloseHandle(file.mappingHandle);
+  if(file.fileHandle != NULL)
+    CloseHandle(file.fileHandle);
+  file.mappingHandle = NULL;
+  file.fileHandle = NULL;
+#else
+  if(file.data != NULL)
+    munmap((void*)file.data, file.size);
+  if(file.fileDescriptor >= 0)
+    close(file.fileDescriptor);
+  file.fileDescriptor = -1;
+#endif
+
+  file.data = NULL;
+  file.size = 0;
+}
+
+void releaseMeshData(MeshData &mesh) {
+
+  if(mesh.mapping.data != NULL)
+    unmapFile(mesh.mapping);
+
+  std::vector<unsigned char>().swap(mesh.vertexStorage);
+  std::vector<unsigned char>().swap(mesh.indexStorage);
+
+  mesh.vertexData = NULL;
+  mesh.indexData = NULL;
+  mesh.vertexDataSize = 0;
+  mesh.indexDataSize = 0;
+}
+
+static unsigned long long hashBytes(unsigned long long hash, const unsigned char *data, size_t size) {
+
+  for(size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// hashes the whole file, a missing file changes the hash as well
+static bool hashFile(const std::string &fileName, unsigned long long &hash) {
+
+  MappedFile file;
+  if(mapFile(fileName, file) == false) {
+    const unsigned char missing = 0xff;
+    hash = hashBytes(hash, &missing, 1);
+    return false;
+  }
+
+  hash = hashBytes(hash, file.data, file.size);
+  unmapFile(file);
+  return true;
+}
+
+unsigned long long hashMeshSource(const std::string &fileName, bool &found) {
+
+  unsigned long long hash = FNV_OFFSET_BASIS;
+
+  MappedFile file;
+  found = mapFile(fileName, file);
+  if(found == false)
+    return hash;
+
+  hash = hashBytes(hash, file.data, file.size);
+
+  // material libraries are resolved relative to the OBJ file
+  const size_t slash = fileName.find_last_of("/\\");
+  const std::string directory = (slash != std::string::npos) ? fileName.substr(0, slash + 1) : "";
+
+  const char *text = (const char*)file.data;
+  const char *end = text + file.size;
+
+  while(text < end) {
+    const char *lineEnd = (const char*)memchr(text, '\n', end - text);
+    if(lineEnd == NULL)
+      lineEnd = end;
+
+    if(lineEnd - text > 7 && strncmp(text, "mtllib", 6) == 0 && (text[6] == ' ' || text[6] == '\t')) {
+      const char *nameBegin = text + 7;
+      const char *nameEnd = lineEnd;
+      while(nameBegin < nameEnd && (*nameBegin == ' ' || *nameBegin == '\t'))
+        nameBegin++;
+      while(nameEnd > nameBegin && (nameEnd[-1] == '\r' || nameEnd[-1] == ' ' || nameEnd[-1] == '\t'))
+        nameEnd--;
+
+      if(nameBegin < nameEnd)
+        hashFile(directory + std::string(nameBegin, nameEnd), hash);
+    }
+
+    text = lineEnd + 1;
+  }
+
+  unmapFile(file);
+
+  return hash;
+}
+
+bool loadMeshCache(const std::string &cacheName, unsigned long long sourceHash, MeshData &mesh) {
+
+  releaseMeshData(mesh);
+
+  if(mapFile(cacheName, mesh.mapping) == false)
+    return false;
+
+  const unsigned char *data = mesh.mapping.data;
+  const size_t size = mesh.mapping.size;
+
+  MeshCacheHeader header;
+  if(size < sizeof(header)) {
+    unmapFile(mesh.mapping);
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if(memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != MESH_CACHE_VERSION ||
+     header.headerSize != sizeof(MeshCacheHeader) ||
+     header.sourceHash != sourceHash) {
+    unmapFile(mesh.mapping);
+    return false;
+  }
+
+  const size_t offset = vertexDataOffset(header.textureNameLength);
+  if(offset > size || header.vertexDataSize > size - offset || header.indexDataSize > size - offset - header.vertexDataSize) {
+    std::fprintf(stderr, "loadMeshCache(): truncated cache file %s\n", cacheName.c_str());
+    unmapFile(mesh.mapping);
+    return false;
+  }
+
+  // the levels of detail have to cover the index data exactly
+  const size_t indexSize = (header.indexType == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int);
+  unsigned long long lodIndexDataSize = 0;
+  for(unsigned int i = 0; i < header.lodCount && i < MESH_LODS_MAX; i++)
+    lodIndexDataSize += 3ULL * header.lodTriangleCount[i] * indexSize;
+
+  if(header.lodCount == 0 || header.lodCount > MESH_LODS_MAX || header.lodTriangleCount[0] != header.triangleCount ||
+     lodIndexDataSize != header.indexDataSize) {
+    std::fprintf(stderr, "loadMeshCache(): invalid levels of detail in cache file %s\n", cacheName.c_str());
+    unmapFile(mesh.mapping);
+    return false;
+  }
+
+  mesh.vertexCount = header.vertexCount;
+  mesh.triangleCount = header.triangleCount;
+  mesh.lodCount = header.lodCount;
+  for(unsigned int i = 0; i < MESH_LODS_MAX; i++)
+    mesh.lodTriangleCount[i] = (i < header.lodCount) ? header.lodTriangleCount[i] : 0;
+  mesh.indexType = header.indexType;
+  mesh.normalType = header.normalType;
+
+  mesh.vertexData = data + offset;
+  mesh.vertexDataSize = (size_t)header.vertexDataSize;
+  mesh.indexData = data + offset + mesh.vertexDataSize;
+  mesh.indexDataSize = (size_t)header.indexDataSize;
+
+  mesh.ambient = glm::vec3(header.ambient[0], header.ambient[1], header.ambient[2]);
+  mesh.diffuse = glm::vec3(header.diffuse[0], header.diffuse[1], header.diffuse[2]);
+  mesh.specular = glm::vec3(header.specular[0], header.specular[1], header.specular[2]);
+  mesh.shininess = header.shininess;
+  mesh.textureName.assign((const char*)data + sizeof(header), header.textureNameLength);
+
+  return true;
+}
+
+bool saveMeshCache(const std::string &cacheName, unsigned long long sourceHash, const MeshData &mesh) {
+
+  MeshCacheHeader header;
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+  header.version = MESH_CACHE_VERSION;
+  header.sourceHash = sourceHash;
+  header.vertexCount = mesh.vertexCount;
+  header.triangleCount = mesh.triangleCount;
+  header.lodCount = mesh.lodCount;
+  for(unsigned int i = 0; i < mesh.lodCount; i++)
+    header.lodTriangleCount[i] = mesh.lodTriangleCount[i];
+  header.vertexDataSize = mesh.vertexDataSize;
+  header.indexDataSize = mesh.indexDataSize;
+  header.indexType = mesh.indexType;
+  header.normalType = mesh.normalType;
+  for(int i = 0; i < 3; i++) {
+    header.ambient[i] = mesh.ambient[i];
+    header.diffuse[i] = mesh.diffuse[i];
+    header.specular[i] = mesh.specular[i];
+  }
+  header.shininess = mesh.shininess;
+  header.textureNameLength = (unsigned int)mesh.textureName.size();
+  header.headerSize = sizeof(MeshCacheHeader);
+
+  // written to a temporary file first -> an interrupted write never leaves a valid looking cache behind
+  const std::string temporaryName = cacheName + ".tmp";
+  FILE *file = std::fopen(temporaryName.c_str(), "wb");
+  if(file == NULL)
+    return false;
+
+  static const unsigned char padding[16] = { 0 };
+  const size_t paddingSize = vertexDataOffset(header.textureNameLength) - sizeof(header) - header.textureNameLength;
+
+  bool written =
+    std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+    std::fwrite(mesh.textureName.data(), 1, mesh.textureName.size(), file) == mesh.textureName.size() &&
+    std::fwrite(padding, 1, paddingSize, file) == paddingSize &&
+    std::fwrite(mesh.vertexData, 1, mesh.vertexDataSize, file) == mesh.vertexDataSize &&
+    std::fwrite(mesh.indexData, 1, mesh.indexDataSize, file) == mesh.indexDataSize;
+
+  written = (std::fclose(file) == 0) && written;
+
+  if(written) {
+    std::remove(cacheName.c_str());  // rename does not replace existing files on Windows
+    written = (std::rename(temporaryName.c_str(), cacheName.c_str()) == 0);
+  }
+
+  if(written == false)
+    std::remove(temporaryName.c_str());
+
+  return written;
+}
+
+static float vertexScore(int cachePosition, unsigned int remainingTriangles) {
+
+  // vertex not used by any remaining triangle
+  if(remainingTriangles == 0)
+    return -1.0f;
+
+  float score = 0.0f;
+
+  if(cachePosition >= 0) {
+    // vertices of the last triangle get a fixed score - they should not be preferred over the rest of the cache
+    if(cachePosition < 3)
+      score = 0.75f;
+    else
+      score = powf(1.0f - (cachePosition - 3) / (float)(VERTEX_CACHE_SIZE - 3), 1.5f);
+  }
+
+  // boost vertices with few remaining triangles -> lone triangles are not left behind
+  return score + 2.0f * powf((float)remainingTriangles, -0.5f);
+}
+
+void optimizeVertexCache(unsigned int *indices, unsigned int triangleCount, unsigned int vertexCount) {
+
+  if(triangleCount == 0)
+    return;
+
+  // triangles using each vertex, the first remaining[v] entries of the vertex are not emitted yet
+  std::vector<unsigned int> remaining(vertexCount, 0);
+  for(unsigned int i = 0; i < 3 * triangleCount; i++)
+    remaining[indices[i]]++;
+
+  std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+  for(unsigned int v = 0; v < vertexCount; v++)
+    firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+
+  std::vector<unsigned int> vertexTriangles(3 * triangleCount);
+  std::vector<unsigned int> filled(vertexCount, 0);
+  for(unsigned int i = 0; i < 3 * triangleCount; i++) {
+    const unsigned int v = indices[i];
+    vertexTriangles[firstTriangle[v] + filled[v]++] = i / 3;
+  }
+
+  std::vector<int> cachePosition(vertexCount, -1);
+  std::vector<float> score(vertexCount);
+  for(unsigned int v = 0; v < vertexCount; v++)
+    score[v] = vertexScore(-1, remaining[v]);
+
+  std::vector<float> triangleScore(triangleCount);
+  std::vector<bool> emitted(triangleCount, false);
+  for(unsigned int t = 0; t < triangleCount; t++)
+    triangleScore[t] = score[indices[3*t]] + score[indices[3*t + 1]] + score[indices[3*t + 2]];
+
+  std::vector<unsigned int> output;
+  output.reserve(3 * triangleCount);
+
+  std::vector<unsigned int> cache, newCache;
+  cache.reserve(VERTEX_CACHE_SIZE + 3);
+  newCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+  long long best = -1;
+
+  for(unsigned int emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+
+    // nothing in the cache references a remaining triangle -> full search (once per disconnected part of the mesh)
+    if(best < 0) {
+      float bestScore = -1.0f;
+      for(unsigned int t = 0; t < triangleCount; t++) {
+        if(emitted[t] == false && triangleScore[t] > bestScore) {
+          bestScore = triangleScore[t];
+          best = t;
+        }
+      }
+    }
+
+    const unsigned int *triangle = indices + 3 * best;
+    output.insert(output.end(), triangle, triangle + 3);
+    emitted[best] = true;
+
+    // remove the triangle from the lists of its vertices
+    for(int k = 0; k < 3; k++) {
+      const unsigned int v = triangle[k];
+      unsigned int *list = &vertexTriangles[firstTriangle[v]];
+      for(unsigned int i = 0; i < remaining[v]; i++) {
+        if(list[i] == best) {
+          std::swap(list[i], list[remaining[v] - 1]);
+          break;
+        }
+      }
+      remaining[v]--;
+    }
+
+    // vertices of the triangle move to the front of the cache
+    newCache.assign(triangle, triangle + 3);
+    for(size_t i = 0; i < cache.size(); i++) {
+      if(cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+        newCache.push_back(cache[i]);
+    }
+    cache.swap(newCache);
+
+    for(size_t i = 0; i < cache.size(); i++) {
+      const unsigned int v = cache[i];
+      cachePosition[v] = (i < VERTEX_CACHE_SIZE) ? (int)i : -1;
+      score[v] = vertexScore(cachePosition[v], remaining[v]);
+    }
+
+    // rescore triangles touching the cache, the best of them is emitted next
+    best = -1;
+    float bestScore = -1.0f;
+
+    for(size_t i = 0; i < cache.size(); i++) {
+      const unsigned int v = cache[i];
+      for(unsigned int j = 0; j < remaining[v]; j++) {
+        const unsigned int t = vertexTriangles[firstTriangle[v] + j];
+        triangleScore[t] = score[indices[3*t]] + score[indices[3*t + 1]] + score[indices[3*t + 2]];
+
+        if(triangleScore[t] > bestScore) {
+          bestScore = triangleScore[t];
+          best = t;
+        }
+      }
+    }
+
+    if(cache.size() > VERTEX_CACHE_SIZE)
+      cache.resize(VERTEX_CACHE_SIZE);
+  }
+
+  std::copy(output.begin(), output.end(), indices);
+}
+
+// float to IEEE half, rounded to nearest even, overflows to infinity
+static unsigned short floatToHalf(float value) {
+
+  unsigned int bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  const unsigned int sign = (bits >> 16) & 0x8000;
+  const int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+  unsigned int mantissa = bits & 0x7fffff;
+
+  // NaN and infinity
+  if(((bits >> 23) & 0xff) == 0xff)
+    return (unsigned short)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+  if(exponent >= 31)
+    return (unsigned short)(sign | 0x7c00);
+
+  // denormals and zero
+  if(exponent <= 0) {
+    if(exponent < -10)
+      return (unsigned short)sign;
+
+    mantissa |= 0x800000;
+    const int shift = 14 - exponent;
+    unsigned int half = mantissa >> shift;
+    const unsigned int rest = mantissa & ((1u << shift) - 1);
+    const unsigned int halfway = 1u << (shift - 1);
+    if(rest > halfway || (rest == halfway && (half & 1)))
+      half++;
+    return (unsigned short)(sign | half);
+  }
+
+  unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+  const unsigned int rest = mantissa & 0x1fff;
+  if(rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+    half++;  // may carry into the exponent, which is the correct rounding
+  return (unsigned short)(sign | half);
+}
+
+static int snorm(float value, float scale) {
+  return (int)floorf(std::min(1.0f, std::max(-1.0f, value)) * scale + 0.5f);
+}
+
+static unsigned int packNormal(const float *normal, unsigned int normalType) {
+
+  if(normalType == GL_INT_2_10_10_10_REV) {
+    return ((unsigned int)snorm(normal[0], 511.0f) & 0x3ff)
+         | (((unsigned int)snorm(normal[1], 511.0f) & 0x3ff) << 10)
+         | (((unsigned int)snorm(normal[2], 511.0f) & 0x3ff) << 20);
+  }
+
+  // 4x GL_BYTE in memory order x, y, z, w
+  unsigned char bytes[4] = {
+    (unsigned char)snorm(normal[0], 127.0f),
+    (unsigned char)snorm(normal[1], 127.0f),
+    (unsigned char)snorm(normal[2], 127.0f),
+    0
+  };
+  unsigned int packed;
+  memcpy(&packed, bytes, sizeof(packed));
+  return packed;
+}
+
+bool buildMeshData(const float *positions, const float *normals, const float *texCoords, unsigned int vertexCount,
+                   const unsigned int *indices, unsigned int triangleCount, unsigned int normalType, MeshData &mesh) {
+
+  // nothing to draw, the storage vectors below would stay empty
+  if(vertexCount == 0 || triangleCount == 0)
+    return false;
+
+  std::vector<unsigned int> optimizedIndices(indices, indices + 3 * triangleCount);
+  optimizeVertexCache(optimizedIndices.data(), triangleCount, vertexCount);
+
+  mesh.lodCount = 1;
+  mesh.lodTriangleCount[0] = triangleCount;
+
+  // each level is simplified from the full mesh, a level that does not save enough triangles ends the chain
+  std::vector<unsigned int> lodIndices;
+  while(mesh.lodCount < MESH_LODS_MAX) {
+    const unsigned int previousCount = mesh.lodTriangleCount[mesh.lodCount - 1];
+    simplifyMesh(positions, vertexCount, indices, triangleCount, previousCount / 2, lodIndices);
+
+    const unsigned int lodTriangleCount = (unsigned int)(lodIndices.size() / 3);
+    if(lodTriangleCount < MESH_LOD_MIN_TRIANGLES || lodTriangleCount > previousCount * 3 / 4)
+      break;
+
+    optimizeVertexCache(lodIndices.data(), lodTriangleCount, vertexCount);
+    optimizedIndices.insert(optimizedIndices.end(), lodIndices.begin(), lodIndices.end());
+    mesh.lodTriangleCount[mesh.lodCount++] = lodTriangleCount;
+  }
+  for(unsigned int i = mesh.lodCount; i < MESH_LODS_MAX; i++)
+    mesh.lodTriangleCount[i] = 0;
+
+  // vertices in the order of their first use, unused vertices are dropped - the coarser levels use a subset of the vertices of level 0
+  std::vector<unsigned int> remap(vertexCount, ~0u);
+  std::vector<unsigned int> order;
+  order.reserve(vertexCount);
+
+  for(size_t i = 0; i < optimizedIndices.size(); i++) {
+    unsigned int &index = optimizedIndices[i];
+    if(remap[index] == ~0u) {
+      remap[index] = (unsigned int)order.size();
+      order.push_back(index);
+    }
+    index = remap[index];
+  }
+
+  mesh.vertexCount = (unsigned int)order.size();
+  mesh.triangleCount = triangleCount;
+  mesh.normalType = normalType;
+
+  mesh.vertexStorage.assign(mesh.vertexCount * sizeof(PackedVertex), 0);
+  PackedVertex *vertices = (PackedVertex*)mesh.vertexStorage.data();
+
+  for(unsigned int i = 0; i < mesh.vertexCount; i++) {
+    const unsigned int v = order[i];
+    PackedVertex &vertex = vertices[i];
+
+    memcpy(vertex.position, positions + 3*v, sizeof(vertex.position));
+    vertex.normal = packNormal(normals + 3*v, normalType);
+    vertex.texCoord[0] = floatToHalf(texCoords ? texCoords[2*v] : 0.0f);
+    vertex.texCoord[1] = floatToHalf(texCoords ? texCoords[2*v + 1] : 0.0f);
+  }
+
+  // 16-bit indices whenever the vertex count allows
+  if(mesh.vertexCount <= 0x10000) {
+    mesh.indexType = GL_UNSIGNED_SHORT;
+    mesh.indexStorage.resize(optimizedIndices.size() * sizeof(unsigned short));
+    unsigned short *shortIndices = (unsigned short*)mesh.indexStorage.data();
+    for(size_t i = 0; i < optimizedIndices.size(); i++)
+      shortIndices[i] = (unsigned short)optimizedIndices[i];
+  }
+  else {
+    mesh.indexType = GL_UNSIGNED_INT;
+    mesh.indexStorage.resize(optimizedIndices.size() * sizeof(unsigned int));
+    memcpy(mesh.indexStorage.data(), optimizedIndices.data(), mesh.indexStorage.size());
+  }
+
+  mesh.vertexData = mesh.vertexStorage.data();
+  mesh.vertexDataSize = mesh.vertexStorage.size();
+  mesh.indexData = mesh.indexStorage.data();
+  mesh.indexDataSize = mesh.indexStorage.size();
+
+  return true;
+}
@@ -0,0 +1,126 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    mesh_cache.h
+ * \brief   Binary cache of meshes imported by Assimp, read through a memory mapped file.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __MESH_CACHE_H
+#define __MESH_CACHE_H
+
+#include <string>
+#include <vector>
+#include "pgr.h" // glm
+#include "mesh_lod.h"
+
+// version of the cache file layout - increase whenever the layout or the content of the buffers changes
+#define MESH_CACHE_VERSION 3
+
+// cache of file "data/x.obj" is stored as "data/x.obj.meshcache"
+#define MESH_CACHE_SUFFIX ".meshcache"
+
+// read-only memory mapped file
+typedef struct _MappedFile {
+  const unsigned char *data;  // NULL if the file is not mapped
+  size_t size;
+#ifdef _WIN32
+  void *fileHandle;
+  void *mappingHandle;
+#else
+  int fileDescriptor;
+#endif
+} MappedFile;
+
+bool mapFile(const std::string &fileName, MappedFile &file);
+void unmapFile(MappedFile &file);
+
+// interleaved vertex of the loaded meshes (20 bytes instead of 32 bytes of the planar float layout)
+typedef struct _PackedVertex {
+  float          position[3];
+  unsigned int   normal;       // signed normalized GL_INT_2_10_10_10_REV, or 4x GL_BYTE if packed normals are not supported
+  unsigned short texCoord[2];  // GL_HALF_FLOAT
+} PackedVertex;
+
+// mesh in the exact layout of the vertex and element buffers of MeshGeometry
+// - data point either to the storage vectors (imported mesh) or into the mapped cache file
+typedef struct _MeshData {
+  unsigned int vertexCount;
+  unsigned int triangleCount;                     // of the full mesh, level of detail 0
+
+  unsigned int lodCount;                          // levels of detail, 1 = full mesh only
+  unsigned int lodTriangleCount[MESH_LODS_MAX];   // the levels follow each other in the index data
+
+  const void *vertexData;   // array of PackedVertex, shared by all levels of detail
+  size_t vertexDataSize;
+  const void *indexData;    // 3 indices per triangle
+  size_t indexDataSize;
+
+  unsigned int indexType;   // GL_UNSIGNED_SHORT if all indices fit into 16 bits, GL_UNSIGNED_INT otherwise
+  unsigned int normalType;  // GL_INT_2_10_10_10_REV or GL_BYTE
+
+  // material
+  glm::vec3 ambient;
+  glm::vec3 diffuse;
+  glm::vec3 specular;
+  float shininess;
+  std::string textureName;  // as stored in the material, relative to the mesh file ("" = no texture)
+
+  std::vector<unsigned char> vertexStorage;
+  std::vector<unsigned char> indexStorage;
+  MappedFile mapping;
+
+} MeshData;
+
+// releases the storage and unmaps the cache file
+void releaseMeshData(MeshData &mesh);
+
+//**************************************************************************************************
+/// Converts an indexed triangle mesh to the MeshData layout.
+/**
+ Coarser levels of detail are built by simplifyMesh(), each with about half of the triangles
+ of the previous one, and appended to the index data. Triangles of each level are reordered for
+ the post-transform vertex cache (Forsyth's linear-speed algorithm), vertices are then reordered
+ by their first use so that vertex fetches stay sequential. The data are stored to the storage
+ vectors of the mesh.
+
+ \param[in]  positions      3 floats per vertex.
+ \param[in]  normals        3 floats per vertex.
+ \param[in]  texCoords      2 floats per vertex, NULL if the mesh has no texture coordinates.
+ \param[in]  vertexCount    Number of vertices.
+ \param[in]  indices        3 indices per triangle.
+ \param[in]  triangleCount  Number of triangles.
+ \param[in]  normalType     GL_INT_2_10_10_10_REV or GL_BYTE.
+ \param[out] mesh           Converted mesh, material is not touched.
+ \return                    False if the mesh has no vertices or no triangles, mesh is not touched then.
+*/
+bool buildMeshData(const float *positions, const float *normals, const float *texCoords, unsigned int vertexCount,
+                   const unsigned int *indices, unsigned int triangleCount, unsigned int normalType, MeshData &mesh);
+
+// reorders triangles to reduce post-transform vertex cache misses
+void optimizeVertexCache(unsigned int *indices, unsigned int triangleCount, unsigned int vertexCount);
+
+//**************************************************************************************************
+/// Computes the hash of a mesh source.
+/**
+ 64-bit FNV-1a hash of the OBJ file and all material libraries it references (mtllib).
+
+ \param[in]  fileName  OBJ file name.
+ \param[out] found     False if the OBJ file cannot be read.
+ \return               Hash of the source files.
+*/
+unsigned long long hashMeshSource(const std::string &fileName, bool &found);
+
+//**************************************************************************************************
+/// Maps the cache file and points the mesh data into it.
+/**
+ \param[in]  cacheName   Cache file name.
+ \param[in]  sourceHash  Hash of the current source files, see hashMeshSource().
+ \param[out] mesh        Mesh data valid until releaseMeshData() is called.
+ \return                 False if the file is missing, has a different version or was built from different sources.
+*/
+bool loadMeshCache(const std::string &cacheName, unsigned long long sourceHash, MeshData &mesh);
+
+// stores the mesh to the cache file, returns false if the file cannot be written
+bool saveMeshCache(const std::string &cacheName, unsigned long long sourceHash, const MeshData &mesh);
+
+#endif // __MESH_CACHE_H
@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    mesh_lod.cpp
+ * \brief   Mesh levels of detail - simplified index buffers built at load time and their
+ *          selection by the projected size of the objects.
+ *
+ * Vertex clustering follows Rossignac and Borrel, "Multi-resolution 3D approximations
+ * for rendering complex scenes", 1993.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include "mesh_lod.h"
+
+// finest grid tried by simplifyMesh(), cells per the longest side of the bounding box
+#define CLUSTER_GRID_MAX 1024
+
+typedef struct _ClusterVertex {
+  unsigned int cell;
+  unsigned int vertex;
+} ClusterVertex;
+
+static bool clusterVertexLess(const ClusterVertex &a, const ClusterVertex &b) {
+  return (a.cell != b.cell) ? (a.cell < b.cell) : (a.vertex < b.vertex);
+}
+
+// triangles with the same vertices in the same winding are equal, the rotation starts with the smallest index
+static void canonicalTriangle(unsigned int *triangle) {
+
+  while(triangle[0] > triangle[1] || triangle[0] > triangle[2]) {
+    const unsigned int first = triangle[0];
+    triangle[0] = triangle[1];
+    triangle[1] = triangle[2];
+    triangle[2] = first;
+  }
+}
+
+typedef struct _Triangle {
+  unsigned int v[3];
+} Triangle;
+
+static bool triangleLess(const Triangle &a, const Triangle &b) {
+  if(a.v[0] != b.v[0]) return a.v[0] < b.v[0];
+  if(a.v[1] != b.v[1]) return a.v[1] < b.v[1];
+  return a.v[2] < b.v[2];
+}
+
+static bool triangleEqual(const Triangle &a, const Triangle &b) {
+  return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2];
+}
+
+// clusters the used vertices in a grid of gridSize cells per the longest side, returns the number of triangles
+static unsigned int clusterVertices(const float *positions, const std::vector<unsigned int> &usedVertices, const unsigned int *indices,
+                                    unsigned int triangleCount, const glm::vec3 &boxMin, float boxSize, unsigned int gridSize,
+                                    std::vector<unsigned int> &representative, std::vector<Triangle> &triangles) {
+
+  const float scale = gridSize / boxSize;
+
+  std::vector<ClusterVertex> cells(usedVertices.size());
+  for(size_t i = 0; i < usedVertices.size(); i++) {
+    const unsigned int v = usedVertices[i];
+    unsigned int cell[3];
+    for(int axis = 0; axis < 3; axis++)
+      cell[axis] = std::min((unsigned int)((positions[3*v + axis] - boxMin[axis]) * scale), gridSize - 1);
+
+    cells[i].cell = cell[0] + gridSize * (cell[1] + gridSize * cell[2]);
+    cells[i].vertex = v;
+  }
+  std::sort(cells.begin(), cells.end(), clusterVertexLess);
+
+  // representative of a cell is its vertex nearest to the average position
+  for(size_t begin = 0; begin < cells.size(); ) {
+    size_t end = begin;
+    glm::vec3 average = glm::vec3(0.0f);
+    while(end < cells.size() && cells[end].cell == cells[begin].cell) {
+      average += glm::vec3(positions[3*cells[end].vertex], positions[3*cells[end].vertex + 1], positions[3*cells[end].vertex + 2]);
+      end++;
+    }
+    average /= (float)(end - begin);
+
+    unsigned int nearest = cells[begin].vertex;
+    float nearestDistance = -1.0f;
+    for(size_t i = begin; i < end; i++) {
+      const unsigned int v = cells[i].vertex;
+      const glm::vec3 offset = glm::vec3(positions[3*v], positions[3*v + 1], positions[3*v + 2]) - average;
+      const float distance = glm::dot(offset, offset);
+      if(nearestDistance < 0.0f || distance < nearestDistance) {
+        nearest = v;
+        nearestDistance = distance;
+      }
+    }
+
+    for(size_t i = begin; i < end; i++)
+      representative[cells[i].vertex] = nearest;
+
+    begin = end;
+  }
+
+  // triangles with two corners in the same cell collapse
+  triangles.clear();
+  for(unsigned int t = 0; t < triangleCount; t++) {
+    Triangle triangle;
+    for(int corner = 0; corner < 3; corner++)
+      triangle.v[corner] = representative[indices[3*t + corner]];
+
+    if(triangle.v[0] == triangle.v[1] || triangle.v[1] == triangle.v[2] || triangle.v[0] == triangle.v[2])
+      continue;
+
+    canonicalTriangle(triangle.v);
+    triangles.push_back(triangle);
+  }
+
+  std::sort(triangles.begin(), triangles.end(), triangleLess);
+  triangles.erase(std::unique(triangles.begin(), triangles.end(), triangleEqual), triangles.end());
+
+  return (unsigned int)triangles.size();
+}
+
+void simplifyMesh(const float *positions, unsigned int vertexCount, const unsigned int *indices, unsigned int triangleCount,
+                  unsigned int targetTriangles, std::vector<unsigned int> &result) {
+
+  result.clear();
+  if(triangleCount == 0)
+    return;
+
+  // only vertices referenced by the triangles are clustered and can become representatives
+  std::vector<unsigned char> used(vertexCount, 0);
+  for(unsigned int i = 0; i < 3 * triangleCount; i++)
+    used[indices[i]] = 1;
+
+  std::vector<unsigned int> usedVertices;
+  glm::vec3 boxMin = glm::vec3(positions[3*indices[0]], positions[3*indices[0] + 1], positions[3*indices[0] + 2]);
+  glm::vec3 boxMax = boxMin;
+  for(unsigned int v = 0; v < vertexCount; v++) {
+    if(used[v] == 0)
+      continue;
+    usedVertices.push_back(v);
+    const glm::vec3 position = glm::vec3(positions[3*v], positions[3*v + 1], positions[3*v + 2]);
+    boxMin = glm::min(boxMin, position);
+    boxMax = glm::max(boxMax, position);
+  }
+
+  const glm::vec3 extent = boxMax - boxMin;
+  const float boxSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+
+  std::vector<unsigned int> representative(vertexCount);
+  std::vector<Triangle> triangles, bestTriangles;
+
+  // the number of triangles grows with the grid resolution -> binary search of the finest grid within the target
+  unsigned int low = 1, high = CLUSTER_GRID_MAX;
+  while(low <= high) {
+    const unsigned int gridSize = (low + high) / 2;
+    const unsigned int count = clusterVertices(positions, usedVertices, indices, triangleCount, boxMin, boxSize, gridSize, representative, triangles);
+
+    if(count <= targetTriangles) {
+      bestTriangles.swap(triangles);
+      low = gridSize + 1;
+    }
+    else {
+      high = gridSize - 1;
+    }
+  }
+
+  result.resize(3 * bestTriangles.size());
+  for(size_t t = 0; t < bestTriangles.size(); t++)
+    for(int corner = 0; corner < 3; corner++)
+      result[3*t + corner] = bestTriangles[t].v[corner];
+}
+
+float projectedRadius(const glm::mat4 &projectionMatrix, const glm::mat4 &projectionViewMatrix, int viewportHeight,
+                      const glm::vec3 &center, float radius) {
+
+  // clip w is the eye space depth for a perspective projection and 1 for an orthographic one
+  const float w = projectionViewMatrix[0][3] * center.x + projectionViewMatrix[1][3] * center.y +
+                  projectionViewMatrix[2][3] * center.z + projectionViewMatrix[3][3];
+
+  return radius * projectionMatrix[1][1] * 0.5f * viewportHeight / std::max(w, 1e-3f);
+}
+
+unsigned int selectMeshLod(float screenRadius, unsigned int currentLod, unsigned int lodCount) {
+
+  unsigned int lod = std::min(currentLod, lodCount - 1);
+
+  // a finer level is taken only well above its radius, a coarser one only well below the radius of the current one
+  while(lod > 0 && screenRadius >= meshLodScreenRadius[lod - 1] * (1.0f + MESH_LOD_HYSTERESIS))
+    lod--;
+  while(lod + 1 < lodCount && screenRadius < meshLodScreenRadius[lod] * (1.0f - MESH_LOD_HYSTERESIS))
+    lod++;
+
+  return lod;
+}
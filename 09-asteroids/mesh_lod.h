@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    mesh_lod.h
+ * \brief   Mesh levels of detail - simplified index buffers built at load time and their
+ *          selection by the projected size of the objects.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __MESH_LOD_H
+#define __MESH_LOD_H
+
+#include <vector>
+#include "pgr.h" // glm
+
+// level 0 is the full mesh, each further level has about half of the triangles of the previous one
+#define MESH_LODS_MAX 4
+
+// levels below this number of triangles are not built
+#define MESH_LOD_MIN_TRIANGLES 16
+
+// level l is drawn while the projected radius of the object is at least meshLodScreenRadius[l] pixels
+static const float meshLodScreenRadius[MESH_LODS_MAX - 1] = { 48.0f, 24.0f, 12.0f };
+
+// relative margin around the radii above - an object at the boundary does not switch levels every frame
+#define MESH_LOD_HYSTERESIS 0.15f
+
+//**************************************************************************************************
+/// Simplifies the mesh by vertex clustering.
+/**
+ Vertices are snapped to a uniform grid, all vertices of a cell are replaced by the one nearest
+ to the average position of the cell, collapsed and duplicate triangles are dropped. The finest
+ grid giving at most targetTriangles triangles is searched. The simplified triangles reference
+ the vertices of the input mesh, so a level of detail needs only its own index buffer.
+
+ \param[in]  positions        3 floats per vertex.
+ \param[in]  vertexCount      Number of vertices.
+ \param[in]  indices          3 indices per triangle.
+ \param[in]  triangleCount    Number of triangles.
+ \param[in]  targetTriangles  Maximal number of triangles of the result.
+ \param[out] result           3 indices per triangle of the simplified mesh, may be empty.
+*/
+void simplifyMesh(const float *positions, unsigned int vertexCount, const unsigned int *indices, unsigned int triangleCount,
+                  unsigned int targetTriangles, std::vector<unsigned int> &result);
+
+// radius in pixels of the sphere projected to the viewport, the sphere has to be in front of the camera
+float projectedRadius(const glm::mat4 &projectionMatrix, const glm::mat4 &projectionViewMatrix, int viewportHeight,
+                      const glm::vec3 &center, float radius);
+
+// level of detail for the projected radius, starting from the level drawn in the last frame
+unsigned int selectMeshLod(float screenRadius, unsigned int currentLod, unsigned int lodCount);
+
+#endif // __MESH_LOD_H
@@ -0,0 +1,290 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    object_pool.cpp
+ * \brief   Game objects stored in structure-of-arrays pools addressed by handles.
+ *          The pools do not use OpenGL, the simulation and the benchmarks link without it.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include "object_pool.h"
+#include "data.h"
+
+glm::vec3 checkBounds(const glm::vec3 &position, float objectSize) {
+ glm::vec3 newPosition = position;
+
+// ======== BEGIN OF SOLUTION - TASK 6_1-1 ======== //
+  // wrap a given position (object center) to be inside a scene
+  // you have to take into account the objectSize parameter
+ if (position.x < -(SCENE_WIDTH + objectSize))
+     newPosition.x += 2.0f * (SCENE_WIDTH + objectSize);
+ if (position.x > (SCENE_WIDTH + objectSize))
+     newPosition.x -= 2.0f * (SCENE_WIDTH + objectSize);
+ if (position.y < -(SCENE_HEIGHT + objectSize))
+     newPosition.y += 2.0f * (SCENE_HEIGHT + objectSize);
+ if (position.y > (SCENE_HEIGHT + objectSize))
+     newPosition.y -= 2.0f * (SCENE_HEIGHT + objectSize);
+ if (position.z < -(SCENE_DEPTH + objectSize))
+     newPosition.z += 2.0f * (SCENE_DEPTH + objectSize);
+ if (position.z > (SCENE_DEPTH + objectSize))
+     newPosition.z -= 2.0f * (SCENE_DEPTH + objectSize);
+// ========  END OF SOLUTION - TASK 6_1-1  ======== //
+   if( abs(newPosition.x) > (SCENE_WIDTH+objectSize) || abs(newPosition.y) > (SCENE_HEIGHT+objectSize) ) {
+     printf("Coordinates out of the window, [x, y, z] = [%f, %f, %f]\n", newPosition.x, newPosition.y, newPosition.z);
+   }
+     return newPosition;
+}
+
+unsigned int objectIndex(const ObjectPool &pool, ObjectHandle handle) {
+
+  const unsigned int slot = handle & HANDLE_SLOT_MASK;
+
+  if(handle == INVALID_OBJECT_HANDLE || slot >= pool.slotIndex.size())
+    return INVALID_OBJECT_INDEX;
+
+  // stale handle - the slot has been reused by another object in the meantime
+  if(pool.slotGeneration[slot] != (handle >> HANDLE_SLOT_BITS))
+    return INVALID_OBJECT_INDEX;
+
+  return pool.slotIndex[slot];
+}
+
+// allocate common object parameters and the handle table, sets the capacity of the pool
+static void reserveCommonObjects(ObjectPool &pool, unsigned int capacity) {
+
+  // handles cannot address more slots
+  capacity = std::min(capacity, HANDLE_SLOT_MASK + 1);
+  pool.capacity = std::max(capacity, objectCount(pool));
+
+  pool.position.reserve(pool.capacity);
+  pool.direction.reserve(pool.capacity);
+  pool.speed.reserve(pool.capacity);
+  pool.size.reserve(pool.capacity);
+  pool.destroyed.reserve(pool.capacity);
+  pool.startTime.reserve(pool.capacity);
+  pool.currentTime.reserve(pool.capacity);
+  pool.handle.reserve(pool.capacity);
+
+  // each live object holds one slot -> there are never more slots than objects that fit into the pool
+  pool.slotIndex.reserve(pool.capacity);
+  pool.slotGeneration.reserve(pool.capacity);
+  pool.freeSlots.reserve(pool.capacity);
+}
+
+// true if there is space for another object, a refused insertion is counted otherwise
+static bool poolHasSpace(ObjectPool &pool) {
+
+  if(objectCount(pool) < pool.capacity)
+    return true;
+
+  pool.stats.rejected++;
+  return false;
+}
+
+// append common object parameters and assign a handle to the new object
+static ObjectHandle pushObject(ObjectPool &pool, const Object &object) {
+
+  unsigned int slot;
+
+  if(pool.freeSlots.empty()) {
+    slot = (unsigned int)pool.slotIndex.size();
+    pool.slotIndex.push_back(INVALID_OBJECT_INDEX);
+    pool.slotGeneration.push_back(0);
+  }
+  else {
+    slot = pool.freeSlots.back();
+    pool.freeSlots.pop_back();
+  }
+
+  const ObjectHandle handle = ((ObjectHandle)pool.slotGeneration[slot] << HANDLE_SLOT_BITS) | slot;
+  pool.slotIndex[slot] = objectCount(pool);
+
+  pool.position.push_back(object.position);
+  pool.direction.push_back(object.direction);
+  pool.speed.push_back(object.speed);
+  pool.size.push_back(object.size);
+  pool.destroyed.push_back(object.destroyed);
+  pool.startTime.push_back(object.startTime);
+  pool.currentTime.push_back(object.currentTime);
+  pool.handle.push_back(handle);
+
+  pool.stats.inserted++;
+  pool.stats.peak = std::max(pool.stats.peak, objectCount(pool));
+
+  return handle;
+}
+
+// move the last element of the array to the given index and shrink the array
+template <typename T>
+static void swapAndPop(std::vector<T> &array, unsigned int index) {
+
+  array[index] = array.back();
+  array.pop_back();
+}
+
+// remove common object parameters and release the handle of the removed object
+static void popObject(ObjectPool &pool, unsigned int index) {
+
+  const unsigned int slot = pool.handle[index] & HANDLE_SLOT_MASK;
+
+  // invalidate all handles referring to the removed object
+  pool.slotGeneration[slot]++;
+  pool.slotIndex[slot] = INVALID_OBJECT_INDEX;
+  pool.freeSlots.push_back(slot);
+
+  pool.stats.removed++;
+
+  // the last object is moved to the freed place -> update its slot
+  const unsigned int lastIndex = objectCount(pool) - 1;
+  if(index != lastIndex)
+    pool.slotIndex[pool.handle[lastIndex] & HANDLE_SLOT_MASK] = index;
+
+  swapAndPop(pool.position, index);
+  swapAndPop(pool.direction, index);
+  swapAndPop(pool.speed, index);
+  swapAndPop(pool.size, index);
+  swapAndPop(pool.destroyed, index);
+  swapAndPop(pool.startTime, index);
+  swapAndPop(pool.currentTime, index);
+  swapAndPop(pool.handle, index);
+}
+
+static void clearCommonObjects(ObjectPool &pool) {
+
+  // bump generation of all used slots -> all issued handles become stale
+  for(unsigned int i = 0; i < objectCount(pool); i++) {
+    const unsigned int slot = pool.handle[i] & HANDLE_SLOT_MASK;
+    pool.slotGeneration[slot]++;
+    pool.slotIndex[slot] = INVALID_OBJECT_INDEX;
+    pool.freeSlots.push_back(slot);
+  }
+
+  pool.stats.removed += objectCount(pool);
+
+  pool.position.clear();
+  pool.direction.clear();
+  pool.speed.clear();
+  pool.size.clear();
+  pool.destroyed.clear();
+  pool.startTime.clear();
+  pool.currentTime.clear();
+  pool.handle.clear();
+}
+
+void reserveObjects(AsteroidPool &pool, unsigned int capacity) {
+
+  reserveCommonObjects(pool, capacity);
+  pool.rotationSpeed.reserve(pool.capacity);
+  pool.lod.reserve(pool.capacity);
+}
+
+void reserveObjects(MissilePool &pool, unsigned int capacity) {
+
+  reserveCommonObjects(pool, capacity);
+}
+
+void reserveObjects(UfoPool &pool, unsigned int capacity) {
+
+  reserveCommonObjects(pool, capacity);
+  pool.rotationSpeed.reserve(pool.capacity);
+  pool.initPosition.reserve(pool.capacity);
+}
+
+void reserveObjects(ExplosionPool &pool, unsigned int capacity) {
+
+  reserveCommonObjects(pool, capacity);
+  pool.textureFrames.reserve(pool.capacity);
+  pool.frameDuration.reserve(pool.capacity);
+}
+
+ObjectHandle insertObject(AsteroidPool &pool, const AsteroidObject &asteroid) {
+
+  if(poolHasSpace(pool) == false)
+    return INVALID_OBJECT_HANDLE;
+
+  pool.rotationSpeed.push_back(asteroid.rotationSpeed);
+  pool.lod.push_back(0);
+  return pushObject(pool, asteroid);
+}
+
+ObjectHandle insertObject(MissilePool &pool, const MissileObject &missile) {
+
+  if(poolHasSpace(pool) == false)
+    return INVALID_OBJECT_HANDLE;
+
+  return pushObject(pool, missile);
+}
+
+ObjectHandle insertObject(UfoPool &pool, const UfoObject &ufo) {
+
+  if(poolHasSpace(pool) == false)
+    return INVALID_OBJECT_HANDLE;
+
+  pool.rotationSpeed.push_back(ufo.rotationSpeed);
+  pool.initPosition.push_back(ufo.initPosition);
+  return pushObject(pool, ufo);
+}
+
+ObjectHandle insertObject(ExplosionPool &pool, const ExplosionObject &explosion) {
+
+  if(poolHasSpace(pool) == false)
+    return INVALID_OBJECT_HANDLE;
+
+  pool.textureFrames.push_back(explosion.textureFrames);
+  pool.frameDuration.push_back(explosion.frameDuration);
+  return pushObject(pool, explosion);
+}
+
+void removeObject(AsteroidPool &pool, unsigned int index) {
+
+  swapAndPop(pool.rotationSpeed, index);
+  swapAndPop(pool.lod, index);
+  popObject(pool, index);
+}
+
+void removeObject(MissilePool &pool, unsigned int index) {
+
+  popObject(pool, index);
+}
+
+void removeObject(UfoPool &pool, unsigned int index) {
+
+  swapAndPop(pool.rotationSpeed, index);
+  swapAndPop(pool.initPosition, index);
+  popObject(pool, index);
+}
+
+void removeObject(ExplosionPool &pool, unsigned int index) {
+
+  swapAndPop(pool.textureFrames, index);
+  swapAndPop(pool.frameDuration, index);
+  popObject(pool, index);
+}
+
+void clearObjects(AsteroidPool &pool) {
+
+  pool.rotationSpeed.clear();
+  pool.lod.clear();
+  clearCommonObjects(pool);
+}
+
+void clearObjects(MissilePool &pool) {
+
+  clearCommonObjects(pool);
+}
+
+void clearObjects(UfoPool &pool) {
+
+  pool.rotationSpeed.clear();
+  pool.initPosition.clear();
+  clearCommonObjects(pool);
+}
+
+void clearObjects(ExplosionPool &pool) {
+
+  pool.textureFrames.clear();
+  pool.frameDuration.clear();
+  clearCommonObjects(pool);
+}
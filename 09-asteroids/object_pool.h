@@ -0,0 +1,191 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    object_pool.h
+ * \brief   Game objects stored in structure-of-arrays pools addressed by handles.
+ *          The pools do not use OpenGL, the simulation and the benchmarks link without it.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __OBJECT_POOL_H
+#define __OBJECT_POOL_H
+
+#include <vector>
+#include "pgr.h" // glm
+
+// parameters of individual objects in the scene (e.g. position, size, speed, etc.)
+typedef struct _Object {
+  glm::vec3 position;
+  glm::vec3 direction;
+  float     speed;
+  float     size;
+
+  bool destroyed;
+
+  float startTime;
+  float currentTime;
+
+} Object;
+
+typedef struct _SpaceShipObject : public Object {
+
+  float viewAngle; // in degrees
+
+} SpaceShipObject;
+
+typedef struct _AsteroidObject : public Object {
+
+  float rotationSpeed;
+
+} AsteroidObject;
+
+typedef struct _MissileObject : public Object {
+
+} MissileObject;
+
+typedef struct _UfoObject : public Object {
+
+  float     rotationSpeed;
+  glm::vec3 initPosition;
+
+} UfoObject;
+
+typedef struct _ExplosionObject : public Object {
+
+  int    textureFrames;
+  float  frameDuration;
+
+} ExplosionObject;
+
+typedef struct _BannerObject : public Object {
+
+} BannerObject;
+
+// handle of an object stored in an object pool
+// - lower 24 bits select a slot in the pool's handle table, upper 8 bits hold the generation of the slot
+// - a handle keeps referring to the same object until the object is removed from the pool
+typedef unsigned int ObjectHandle;
+
+#define INVALID_OBJECT_HANDLE  0xffffffffu
+#define INVALID_OBJECT_INDEX   0xffffffffu
+
+#define HANDLE_SLOT_BITS  24
+#define HANDLE_SLOT_MASK  ((1u << HANDLE_SLOT_BITS) - 1)
+
+// usage statistics of an object pool, the number of live objects is objectCount()
+typedef struct _ObjectPoolStats {
+  unsigned int       peak;      // maximum number of objects stored at once
+  unsigned long long inserted;  // number of objects inserted so far
+  unsigned long long removed;   // number of objects removed so far (including clearObjects())
+  unsigned long long rejected;  // insertions refused because the pool was full
+} ObjectPoolStats;
+
+// structure-of-arrays storage for all objects of the same kind
+// - parameters of the i-th object are stored at index i of each array, arrays are always dense
+// - object is removed by moving the last object into its place (swap and pop), therefore
+//   the dense index of an object may change, its handle does not
+// - the pool holds at most capacity objects, all arrays are allocated by reserveObjects() and
+//   inserting or removing objects never allocates memory afterwards
+typedef struct _ObjectPool {
+  std::vector<glm::vec3>     position;
+  std::vector<glm::vec3>     direction;
+  std::vector<float>         speed;
+  std::vector<float>         size;
+  std::vector<unsigned char> destroyed;      // bytes rather than std::vector<bool> bit fields
+
+  std::vector<float>         startTime;
+  std::vector<float>         currentTime;
+
+  std::vector<ObjectHandle>  handle;         // dense index -> handle of the object
+  std::vector<unsigned int>  slotIndex;      // handle slot -> dense index of the object
+  std::vector<unsigned char> slotGeneration; // handle slot -> generation of the slot
+  std::vector<unsigned int>  freeSlots;      // handle slots available for reuse
+
+  unsigned int               capacity;       // maximum number of objects, 0 until reserveObjects() is called
+  ObjectPoolStats            stats;
+
+} ObjectPool;
+
+typedef struct _AsteroidPool : public ObjectPool {
+
+  std::vector<float> rotationSpeed;
+  std::vector<unsigned char> lod;  // level of detail drawn in the last frame, see selectMeshLods()
+
+} AsteroidPool;
+
+typedef struct _MissilePool : public ObjectPool {
+
+} MissilePool;
+
+typedef struct _UfoPool : public ObjectPool {
+
+  std::vector<float>     rotationSpeed;
+  std::vector<glm::vec3> initPosition;
+
+} UfoPool;
+
+typedef struct _ExplosionPool : public ObjectPool {
+
+  std::vector<int>   textureFrames;
+  std::vector<float> frameDuration;
+
+} ExplosionPool;
+
+// number of objects stored in the pool
+inline unsigned int objectCount(const ObjectPool &pool) {
+  return (unsigned int)pool.position.size();
+}
+
+// dense index of the object referred by the handle or INVALID_OBJECT_INDEX if the object does not exist anymore
+unsigned int objectIndex(const ObjectPool &pool, ObjectHandle handle);
+
+// allocate storage for capacity objects, the capacity is never lowered below the current number of objects
+void reserveObjects(AsteroidPool &pool, unsigned int capacity);
+void reserveObjects(MissilePool &pool, unsigned int capacity);
+void reserveObjects(UfoPool &pool, unsigned int capacity);
+void reserveObjects(ExplosionPool &pool, unsigned int capacity);
+
+// append a new object to the end of the pool, returns handle of the inserted object
+// or INVALID_OBJECT_HANDLE if the pool is full (the object is not inserted)
+ObjectHandle insertObject(AsteroidPool &pool, const AsteroidObject &asteroid);
+ObjectHandle insertObject(MissilePool &pool, const MissileObject &missile);
+ObjectHandle insertObject(UfoPool &pool, const UfoObject &ufo);
+ObjectHandle insertObject(ExplosionPool &pool, const ExplosionObject &explosion);
+
+// remove object stored at the given dense index (the last object is moved to its place)
+void removeObject(AsteroidPool &pool, unsigned int index);
+void removeObject(MissilePool &pool, unsigned int index);
+void removeObject(UfoPool &pool, unsigned int index);
+void removeObject(ExplosionPool &pool, unsigned int index);
+
+// remove all objects marked as destroyed, relative order of the remaining objects is not preserved
+template <class Pool>
+void removeDestroyedObjects(Pool &pool) {
+
+  unsigned int i = 0;
+  while(i < objectCount(pool)) {
+    if(pool.destroyed[i])
+      removeObject(pool, i);  // the last object moved to index i is checked in the next iteration
+    else
+      i++;
+  }
+}
+
+// remove all objects, all handles issued so far become invalid
+void clearObjects(AsteroidPool &pool);
+void clearObjects(MissilePool &pool);
+void clearObjects(UfoPool &pool);
+void clearObjects(ExplosionPool &pool);
+
+//**************************************************************************************************
+/// Makes a given location to be valid position inside a scene.
+/**
+ Checks whether a given location \a position is valid position inside a scene.
+ Valid position coordinates are always in range -(SCENE_WIDTH+objectSize)...SCENE_WIDTH+objectSize,
+ -(SCENE_HEIGHT+objectSize)...SCENE_HEIGHT+objectSize, and -(SCENE_DEPTH+objectSize)...SCENE_DEPTH+objectSize.
+ \param[in]  position       Position (object center) to be checked and corrected.
+ \param[in]  objectSize     Size of the object which position is tested.
+ \return                    Valid position inside a scene.
+*/
+glm::vec3 checkBounds(const glm::vec3 & position, float objectSize = 1.0f);
+
+#endif // __OBJECT_POOL_H
@@ -0,0 +1,20 @@
+#version 140
+
+smooth in float age;        // 0 at the emission, 1 at the end of the particle life
+flat in float kind;         // 0 = debris, 1 = spark
+
+out vec4 color_f;           // outgoing fragment color
+
+void main() {
+
+  // round particle with a soft edge
+  vec2 offset = 2.0 * gl_PointCoord - 1.0;
+  float falloff = max(0.0, 1.0 - dot(offset, offset));
+
+  // debris glows orange and cools down to dark red, sparks burn white to yellow
+  vec3 hotColor  = mix(vec3(1.0, 0.55, 0.15), vec3(1.0, 0.95, 0.7), kind);
+  vec3 coldColor = mix(vec3(0.35, 0.05, 0.0), vec3(1.0, 0.6, 0.1), kind);
+
+  // additive blending -> fading to black fades the particle out
+  color_f = vec4(mix(hotColor, coldColor, age) * falloff * (1.0 - age), 1.0);
+}
@@ -0,0 +1,25 @@
+#version 140
+
+uniform mat4 PVmatrix;      // Projection * View --> world to clip coordinates
+uniform float time;         // current time in seconds
+uniform float pointScale;   // size in pixels of a unit at distance one
+
+in vec3 position;           // particle position in world space
+in vec4 params;             // start time, lifetime, size, kind (0 = debris, 1 = spark)
+
+smooth out float age;       // 0 at the emission, 1 at the end of the particle life
+flat out float kind;
+
+void main() {
+
+  age = (time - params.x) / params.y;
+  kind = params.w;
+
+  gl_Position = PVmatrix * vec4(position, 1);
+
+  // dead particles are moved out of the view volume
+  if(age < 0.0 || age > 1.0)
+    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+
+  gl_PointSize = params.z * pointScale / gl_Position.w;
+}
@@ -0,0 +1,23 @@
+#version 140
+
+// advances particles by one time step, the outputs are captured by transform feedback
+
+uniform float timeDelta;    // time step in seconds
+
+in vec3 position;           // particle position in world space
+in vec3 velocity;           // world units per second
+in vec4 params;             // start time, lifetime, size, kind (0 = debris, 1 = spark)
+
+out vec3 outPosition;
+out vec3 outVelocity;
+out vec4 outParams;
+
+void main() {
+
+  // sparks slow down faster than debris
+  float drag = mix(1.5, 4.0, params.w);
+
+  outVelocity = velocity * exp(-drag * timeDelta);
+  outPosition = position + outVelocity * timeDelta;
+  outParams = params;
+}
@@ -0,0 +1,293 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    particles.cpp
+ * \brief   GPU particle system of the explosions - particle state lives in buffer objects
+ *          and is advanced by transform feedback, all particles are drawn by one call.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "particles.h"
+
+// particle kinds, stored in the last particle parameter
+#define PARTICLE_DEBRIS 0.0f
+#define PARTICLE_SPARK  1.0f
+
+// longest time step of one update -> a stalled frame does not throw the particles away
+#define PARTICLES_MAX_TIME_STEP 0.1f
+
+// state of one particle, the same layout is used by both buffers and by the transform feedback output
+typedef struct _Particle {
+  glm::vec3 position;
+  glm::vec3 velocity;
+  float     startTime;  // time of emission in seconds
+  float     lifetime;   // in seconds
+  float     size;       // diameter in world units
+  float     kind;       // PARTICLE_DEBRIS or PARTICLE_SPARK
+} Particle;
+
+// attribute locations are bound before linking -> both programs read the same vertex array objects
+enum { PARTICLE_POSITION_LOCATION, PARTICLE_VELOCITY_LOCATION, PARTICLE_PARAMS_LOCATION };
+
+bool useParticles = true;
+
+struct ParticleSystem {
+
+  GLuint buffers[2];              // particle state, transform feedback reads one and writes the other
+  GLuint vertexArrayObjects[2];   // vertexArrayObjects[i] reads buffers[i]
+  unsigned int current;           // buffer holding the latest state
+
+  unsigned int nextParticle;      // ring position of the next emitted particle
+  unsigned int firstEmitted;      // ring position of emitted[0]
+  std::vector<Particle> emitted;  // particles waiting for the upload
+
+  float updateTime;               // time of the latest state
+  float aliveUntil;               // no particle is alive after this time
+
+  // particles have their own generator -> simulationRandom() is left untouched,
+  // so replays and state hashes stay bit-exact
+  unsigned int random;
+
+  // update program - transform feedback only, rasterization is discarded
+  GLuint updateProgram;
+  GLint  timeDeltaLocation;
+
+  // drawing program
+  GLuint drawProgram;
+  GLint  PVmatrixLocation;
+  GLint  timeLocation;
+  GLint  pointScaleLocation;
+
+} particleSystem;
+
+// xorshift generator, returns value in range minimum ... maximum
+static float randomFloat(float minimum, float maximum) {
+
+  unsigned int &x = particleSystem.random;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+
+  return minimum + (maximum - minimum) * (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+// random direction flattened towards the plane of the game
+static glm::vec3 randomDirection(void) {
+
+  const float z = randomFloat(-1.0f, 1.0f);
+  const float angle = randomFloat(0.0f, 2.0f * 3.14159265f);
+  const float radius = std::sqrt(std::max(0.0f, 1.0f - z * z));
+
+  return glm::vec3(radius * std::cos(angle), radius * std::sin(angle), 0.35f * z);
+}
+
+static void emitParticle(const glm::vec3 &position, float time, float kind, float speed, float lifetime, float size) {
+
+  // the whole ring is overwritten in this frame already
+  if(particleSystem.emitted.size() >= PARTICLES_CAPACITY)
+    return;
+
+  if(particleSystem.emitted.empty())
+    particleSystem.firstEmitted = particleSystem.nextParticle;
+
+  Particle particle;
+  particle.position  = position;
+  particle.velocity  = speed * randomDirection();
+  particle.startTime = time;
+  particle.lifetime  = lifetime;
+  particle.size      = size;
+  particle.kind      = kind;
+
+  particleSystem.emitted.push_back(particle);
+  particleSystem.nextParticle = (particleSystem.nextParticle + 1) % PARTICLES_CAPACITY;
+  particleSystem.aliveUntil = std::max(particleSystem.aliveUntil, time + lifetime);
+}
+
+void emitImpactParticles(const glm::vec3 &position, float time) {
+
+  // slow glowing debris
+  for(int i = 0; i < PARTICLES_DEBRIS_PER_IMPACT; i++)
+    emitParticle(position, time, PARTICLE_DEBRIS, randomFloat(0.15f, 0.5f), randomFloat(0.8f, 1.6f), randomFloat(0.015f, 0.035f));
+
+  // fast short-lived sparks
+  for(int i = 0; i < PARTICLES_SPARKS_PER_IMPACT; i++)
+    emitParticle(position, time, PARTICLE_SPARK, randomFloat(0.6f, 1.6f), randomFloat(0.25f, 0.6f), randomFloat(0.006f, 0.012f));
+}
+
+// copies the emitted particles to their ring positions in the current buffer
+static void uploadEmittedParticles(void) {
+
+  if(particleSystem.emitted.empty())
+    return;
+
+  const unsigned int count = (unsigned int)particleSystem.emitted.size();
+  const unsigned int first = particleSystem.firstEmitted;
+  // particles stored before the ring wraps around
+  const unsigned int tail = std::min(count, PARTICLES_CAPACITY - first);
+
+  glBindBuffer(GL_ARRAY_BUFFER, particleSystem.buffers[particleSystem.current]);
+  glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Particle), tail * sizeof(Particle), &particleSystem.emitted[0]);
+  if(tail < count)
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (count - tail) * sizeof(Particle), &particleSystem.emitted[tail]);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  particleSystem.emitted.clear();
+}
+
+void updateParticles(float time) {
+
+  uploadEmittedParticles();
+
+  const float timeDelta = std::min(std::max(time - particleSystem.updateTime, 0.0f), PARTICLES_MAX_TIME_STEP);
+  particleSystem.updateTime = time;
+
+  if(time > particleSystem.aliveUntil || timeDelta == 0.0f)
+    return;
+
+  const unsigned int next = 1 - particleSystem.current;
+
+  glUseProgram(particleSystem.updateProgram);
+  glUniform1f(particleSystem.timeDeltaLocation, timeDelta);
+
+  // all particles are processed, dead ones are just carried over
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBindVertexArray(particleSystem.vertexArrayObjects[particleSystem.current]);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, particleSystem.buffers[next]);
+
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, PARTICLES_CAPACITY);
+  glEndTransformFeedback();
+
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glBindVertexArray(0);
+  glDisable(GL_RASTERIZER_DISCARD);
+  glUseProgram(0);
+
+  particleSystem.current = next;
+}
+
+void drawParticles(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, int viewportHeight, float time) {
+
+  if(time > particleSystem.aliveUntil)
+    return;
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+  glEnable(GL_PROGRAM_POINT_SIZE);
+
+  glUseProgram(particleSystem.drawProgram);
+
+  const glm::mat4 PVmatrix = projectionMatrix * viewMatrix;
+  glUniformMatrix4fv(particleSystem.PVmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVmatrix));
+  glUniform1f(particleSystem.timeLocation, time);
+  // pixels covered by a unit at distance one, the same for perspective and orthographic projection
+  glUniform1f(particleSystem.pointScaleLocation, 0.5f * viewportHeight * projectionMatrix[1][1]);
+
+  glBindVertexArray(particleSystem.vertexArrayObjects[particleSystem.current]);
+  glDrawArrays(GL_POINTS, 0, PARTICLES_CAPACITY);
+  glBindVertexArray(0);
+
+  glUseProgram(0);
+
+  glDisable(GL_PROGRAM_POINT_SIZE);
+  glDisable(GL_BLEND);
+}
+
+// binds the particle attributes to the shared locations and links the program again
+static bool relinkParticleProgram(GLuint program) {
+
+  glBindAttribLocation(program, PARTICLE_POSITION_LOCATION, "position");
+  glBindAttribLocation(program, PARTICLE_VELOCITY_LOCATION, "velocity");
+  glBindAttribLocation(program, PARTICLE_PARAMS_LOCATION, "params");
+  glLinkProgram(program);
+
+  GLint linkStatus = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+
+  return linkStatus == GL_TRUE;
+}
+
+void initializeParticles(void) {
+
+  // update program - outputs are captured into the other buffer in the same layout as Particle
+  std::vector<GLuint> shaderList;
+  shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "particleUpdate.vert"));
+
+  particleSystem.updateProgram = pgr::createProgram(shaderList);
+
+  static const char* feedbackVaryings[] = { "outPosition", "outVelocity", "outParams" };
+  glTransformFeedbackVaryings(particleSystem.updateProgram, 3, feedbackVaryings, GL_INTERLEAVED_ATTRIBS);
+
+  if(relinkParticleProgram(particleSystem.updateProgram) == false)
+    pgr::dieWithError("Particle update program relinking failed!");
+
+  particleSystem.timeDeltaLocation = glGetUniformLocation(particleSystem.updateProgram, "timeDelta");
+
+  // drawing program
+  shaderList.clear();
+  shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "particle.vert"));
+  shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "particle.frag"));
+
+  particleSystem.drawProgram = pgr::createProgram(shaderList);
+
+  if(relinkParticleProgram(particleSystem.drawProgram) == false)
+    pgr::dieWithError("Particle program relinking failed!");
+
+  particleSystem.PVmatrixLocation   = glGetUniformLocation(particleSystem.drawProgram, "PVmatrix");
+  particleSystem.timeLocation       = glGetUniformLocation(particleSystem.drawProgram, "time");
+  particleSystem.pointScaleLocation = glGetUniformLocation(particleSystem.drawProgram, "pointScale");
+
+  // buffers start with dead particles only
+  Particle deadParticle;
+  deadParticle.position  = glm::vec3(0.0f);
+  deadParticle.velocity  = glm::vec3(0.0f);
+  deadParticle.startTime = -1.0e6f;
+  deadParticle.lifetime  = 1.0f;
+  deadParticle.size      = 0.0f;
+  deadParticle.kind      = PARTICLE_DEBRIS;
+
+  const std::vector<Particle> deadParticles(PARTICLES_CAPACITY, deadParticle);
+
+  glGenBuffers(2, particleSystem.buffers);
+  glGenVertexArrays(2, particleSystem.vertexArrayObjects);
+
+  for(int i = 0; i < 2; i++) {
+    glBindVertexArray(particleSystem.vertexArrayObjects[i]);
+
+    glBindBuffer(GL_ARRAY_BUFFER, particleSystem.buffers[i]);
+    glBufferData(GL_ARRAY_BUFFER, PARTICLES_CAPACITY * sizeof(Particle), &deadParticles[0], GL_DYNAMIC_COPY);
+
+    glEnableVertexAttribArray(PARTICLE_POSITION_LOCATION);
+    glVertexAttribPointer(PARTICLE_POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, position));
+    glEnableVertexAttribArray(PARTICLE_VELOCITY_LOCATION);
+    glVertexAttribPointer(PARTICLE_VELOCITY_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, velocity));
+    // start time, lifetime, size and kind
+    glEnableVertexAttribArray(PARTICLE_PARAMS_LOCATION);
+    glVertexAttribPointer(PARTICLE_PARAMS_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, startTime));
+  }
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  particleSystem.current = 0;
+  particleSystem.nextParticle = 0;
+  particleSystem.firstEmitted = 0;
+  particleSystem.emitted.reserve(PARTICLES_CAPACITY);
+  particleSystem.updateTime = 0.0f;
+  particleSystem.aliveUntil = -1.0e6f;
+  particleSystem.random = 0x9e3779b9u;
+
+  CHECK_GL_ERROR();
+}
+
+void cleanupParticles(void) {
+
+  pgr::deleteProgramAndShaders(particleSystem.updateProgram);
+  pgr::deleteProgramAndShaders(particleSystem.drawProgram);
+
+  glDeleteVertexArrays(2, particleSystem.vertexArrayObjects);
+  glDeleteBuffers(2, particleSystem.buffers);
+}
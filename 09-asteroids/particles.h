@@ -0,0 +1,58 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    particles.h
+ * \brief   GPU particle system of the explosions - particle state lives in buffer objects
+ *          and is advanced by transform feedback, all particles are drawn by one call.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __PARTICLES_H
+#define __PARTICLES_H
+
+#include "pgr.h"
+
+// maximum number of particles, the oldest particles are overwritten when more are emitted
+#define PARTICLES_CAPACITY 16384
+
+// particles emitted by one impact
+#define PARTICLES_DEBRIS_PER_IMPACT 24
+#define PARTICLES_SPARKS_PER_IMPACT 40
+
+extern bool useParticles;
+
+// creates the particle buffers and the update and drawing programs
+void initializeParticles(void);
+void cleanupParticles(void);
+
+//**************************************************************************************************
+/// Emits debris and sparks flying out of an impact.
+/**
+ The particles are only stored on the CPU, they are uploaded by the next updateParticles() call.
+ Does not call GL, therefore it may be used as the explosion listener of the simulation.
+
+ \param[in]  position  Position of the impact in world space.
+ \param[in]  time      Time of the impact in seconds.
+*/
+void emitImpactParticles(const glm::vec3 &position, float time);
+
+//**************************************************************************************************
+/// Uploads the emitted particles and advances all particles to the given time.
+/**
+ The whole particle buffer is processed by one transform feedback pass, nothing is done
+ when no particle is alive.
+
+ \param[in]  time  Current time in seconds.
+*/
+void updateParticles(float time);
+
+//**************************************************************************************************
+/// Draws all live particles by one additive draw call.
+/**
+ \param[in]  viewMatrix        View transform.
+ \param[in]  projectionMatrix  Projection transform.
+ \param[in]  viewportHeight    Height of the viewport in pixels, particle sizes are given in world units.
+ \param[in]  time              Current time in seconds.
+*/
+void drawParticles(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, int viewportHeight, float time);
+
+#endif // __PARTICLES_H
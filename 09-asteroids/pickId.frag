@@ -0,0 +1,10 @@
+#version 140
+
+flat in uint objectId_v;
+
+out uint objectId_f;        // written into the R32UI ID buffer
+
+void main() {
+
+  objectId_f = objectId_v;
+}
@@ -0,0 +1,38 @@
+#version 140
+
+// ID pass of the picking - handles of the instances are written into the ID buffer
+
+// per-frame data shared by the programs, filled once per frame by setFrameUniforms()
+layout(std140) uniform FrameData {
+  mat4  Vmatrix;            // View              --> world to eye coordinates
+  mat4  Pmatrix;            // Projection        --> eye to clip coordinates
+  mat4  PVmatrix;           // Projection * View --> world to clip coordinates
+  vec4  sunDirection;       // direction to the sun (eye coordinates)
+  vec4  reflectorPosition;  // space ship reflector position (eye coordinates)
+  vec4  reflectorDirection; // space ship reflector direction (eye coordinates, normalized)
+  vec4  clusterScale;       // light clusters per pixel (xy), depth slice scale and bias (zw)
+  float time;               // elapsed time in seconds
+  float clusterLogDepth;    // 1 -> depth slices are logarithmic, 0 -> linear
+};
+
+uniform samplerBuffer transforms;   // model matrix columns, 4 texels per instance
+uniform usamplerBuffer handles;     // handle of the object, 1 texel per instance
+
+in vec3 position;                   // vertex position in model space
+
+flat out uint objectId_v;
+
+void main() {
+
+  int base = 4 * gl_InstanceID;
+  mat4 modelMatrix = mat4(
+    texelFetch(transforms, base),
+    texelFetch(transforms, base + 1),
+    texelFetch(transforms, base + 2),
+    texelFetch(transforms, base + 3)
+  );
+
+  gl_Position = PVmatrix * modelMatrix * vec4(position, 1);
+
+  objectId_v = texelFetch(handles, gl_InstanceID).r;
+}
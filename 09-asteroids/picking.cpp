@@ -0,0 +1,181 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    picking.cpp
+ * \brief   Object picking by an integer ID buffer - object handles are drawn into an
+ *          R32UI render target and read back asynchronously through pixel buffer objects.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include "picking.h"
+
+// one pixel buffer receives the ID of one pick
+#define PICK_READBACKS (PICK_READBACK_DELAY + 1)
+
+typedef struct _PickReadback {
+  GLuint       pixelBuffer;
+  bool         pending;     // read was issued, the pixel buffer has not been mapped yet
+  unsigned int frame;       // frame of the read
+} PickReadback;
+
+struct Picking {
+
+  GLuint framebuffer;
+  GLuint idRenderbuffer;      // GL_R32UI, object handles
+  GLuint depthRenderbuffer;
+  int width;
+  int height;
+
+  PickReadback readbacks[PICK_READBACKS];
+  unsigned int nextReadback;  // ring position of the next read, the oldest pending read is the first after it
+
+  int requestX[PICK_REQUESTS_MAX];
+  int requestY[PICK_REQUESTS_MAX];
+  unsigned int requestCount;
+
+  int passX;                  // pixel drawn by the current ID pass
+  int passY;
+
+  unsigned int frame;         // incremented by resolvePicks()
+
+} picking;
+
+void initializePicking(void) {
+
+  glGenFramebuffers(1, &picking.framebuffer);
+  glGenRenderbuffers(1, &picking.idRenderbuffer);
+  glGenRenderbuffers(1, &picking.depthRenderbuffer);
+  picking.width = 0;
+  picking.height = 0;
+
+  for(int i = 0; i < PICK_READBACKS; i++) {
+    glGenBuffers(1, &picking.readbacks[i].pixelBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, picking.readbacks[i].pixelBuffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLuint), NULL, GL_STREAM_READ);
+    picking.readbacks[i].pending = false;
+    picking.readbacks[i].frame = 0;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  picking.nextReadback = 0;
+  picking.requestCount = 0;
+  picking.frame = 0;
+
+  CHECK_GL_ERROR();
+}
+
+void cleanupPicking(void) {
+
+  for(int i = 0; i < PICK_READBACKS; i++)
+    glDeleteBuffers(1, &picking.readbacks[i].pixelBuffer);
+
+  glDeleteRenderbuffers(1, &picking.idRenderbuffer);
+  glDeleteRenderbuffers(1, &picking.depthRenderbuffer);
+  glDeleteFramebuffers(1, &picking.framebuffer);
+}
+
+void resizePicking(int width, int height) {
+
+  if(width == picking.width && height == picking.height)
+    return;
+
+  picking.width = width;
+  picking.height = height;
+
+  glBindRenderbuffer(GL_RENDERBUFFER, picking.idRenderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, picking.depthRenderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, picking.framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, picking.idRenderbuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, picking.depthRenderbuffer);
+
+  if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    std::cerr << "resizePicking(): ID framebuffer is not complete, picking will not work" << std::endl;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  CHECK_GL_ERROR();
+}
+
+void requestPick(int x, int y) {
+
+  if(picking.requestCount >= PICK_REQUESTS_MAX)
+    return;
+
+  picking.requestX[picking.requestCount] = x;
+  picking.requestY[picking.requestCount] = y;
+  picking.requestCount++;
+}
+
+bool beginPickPass(void) {
+
+  if(picking.requestCount == 0 || picking.readbacks[picking.nextReadback].pending == true)
+    return false;
+
+  picking.passX = picking.requestX[0];
+  picking.passY = picking.requestY[0];
+
+  picking.requestCount--;
+  for(unsigned int i = 0; i < picking.requestCount; i++) {
+    picking.requestX[i] = picking.requestX[i + 1];
+    picking.requestY[i] = picking.requestY[i + 1];
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, picking.framebuffer);
+
+  // only the picked pixel is cleared and drawn
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(picking.passX, picking.passY, 1, 1);
+
+  const GLuint background[4] = { INVALID_OBJECT_HANDLE, 0, 0, 0 };
+  glClearBufferuiv(GL_COLOR, 0, background);
+  glClear(GL_DEPTH_BUFFER_BIT);
+
+  return true;
+}
+
+void endPickPass(void) {
+
+  PickReadback &readback = picking.readbacks[picking.nextReadback];
+
+  // the pixel is copied into the pixel buffer by the GPU, glReadPixels() returns immediately
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+  glReadPixels(picking.passX, picking.passY, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  readback.pending = true;
+  readback.frame = picking.frame;
+  picking.nextReadback = (picking.nextReadback + 1) % PICK_READBACKS;
+
+  glDisable(GL_SCISSOR_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  CHECK_GL_ERROR();
+}
+
+unsigned int resolvePicks(ObjectHandle *handles, unsigned int maxHandles) {
+
+  unsigned int count = 0;
+
+  // from the oldest read to the newest one
+  for(int i = 0; i < PICK_READBACKS && count < maxHandles; i++) {
+    PickReadback &readback = picking.readbacks[(picking.nextReadback + i) % PICK_READBACKS];
+
+    if(readback.pending == false || picking.frame - readback.frame < PICK_READBACK_DELAY)
+      continue;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+    const GLuint *id = (const GLuint*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    handles[count++] = (id != NULL) ? *id : INVALID_OBJECT_HANDLE;
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+    readback.pending = false;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  picking.frame++;
+
+  return count;
+}
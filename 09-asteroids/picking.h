@@ -0,0 +1,54 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    picking.h
+ * \brief   Object picking by an integer ID buffer - object handles are drawn into an
+ *          R32UI render target and read back asynchronously through pixel buffer objects.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __PICKING_H
+#define __PICKING_H
+
+#include "pgr.h"
+#include "render_stuff.h"
+
+// frames between reading the ID buffer into a pixel buffer and mapping the pixel buffer,
+// the GPU has finished the read by then and mapping does not wait
+#define PICK_READBACK_DELAY 2
+
+// clicks waiting for their ID pass, further clicks are ignored
+#define PICK_REQUESTS_MAX 4
+
+// creates the ID framebuffer and the pixel buffers, the ID buffer is sized by resizePicking()
+void initializePicking(void);
+void cleanupPicking(void);
+
+// resizes the ID buffer to the window size
+void resizePicking(int width, int height);
+
+// queues picking of a window pixel (OpenGL window coordinates, origin in the bottom left corner)
+void requestPick(int x, int y);
+
+//**************************************************************************************************
+/// Starts the ID pass of the oldest queued pick.
+/**
+ Binds the ID framebuffer limited to the picked pixel by the scissor test. The pickable objects
+ are then drawn with their handles as IDs, pixels not covered keep INVALID_OBJECT_HANDLE.
+
+ \return  False if there is no pick to be drawn or all pixel buffers wait for their readback.
+*/
+bool beginPickPass(void);
+
+// reads the picked pixel into a pixel buffer without waiting and restores the window framebuffer
+void endPickPass(void);
+
+//**************************************************************************************************
+/// Collects picks whose readback finished, call once per frame.
+/**
+ \param[out] handles     Handles of the picked objects in the order of clicks, INVALID_OBJECT_HANDLE for the background.
+ \param[in]  maxHandles  Size of the handles array.
+ \return                 Number of handles written.
+*/
+unsigned int resolvePicks(ObjectHandle *handles, unsigned int maxHandles);
+
+#endif // __PICKING_H
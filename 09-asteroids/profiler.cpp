@@ -0,0 +1,304 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    profiler.cpp
+ * \brief   Lightweight CPU/GPU profiler of the simulation and drawing phases.
+ *
+ * GL timer queries and the overlay live in profiler_gl.cpp, this part links without OpenGL.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include "profiler.h"
+
+// logarithmic histogram of all samples - four buckets per octave from 1 microsecond up
+#define PROFILE_HISTOGRAM_BUCKETS    128
+#define PROFILE_HISTOGRAM_PER_OCTAVE 4
+
+typedef std::chrono::steady_clock ProfileClock;
+
+typedef struct _ProfileStats {
+  float window[PROFILE_WINDOW];   // ring of the most recent samples (milliseconds)
+  unsigned int windowCount;
+  unsigned int windowNext;
+
+  unsigned long long samples;     // all samples since the start
+  double sum;
+  float minimum;
+  float maximum;
+  unsigned int histogram[PROFILE_HISTOGRAM_BUCKETS];
+} ProfileStats;
+
+typedef struct _ProfileSectionData {
+  ProfileStats cpu;
+  ProfileStats gpu;
+
+  ProfileClock::time_point start; // start of the running begin/end pair
+  double pending;                 // milliseconds summed since the last commit
+  bool used;                      // begin/end pair was seen since the last commit
+} ProfileSectionData;
+
+static const struct {
+  const char* name;
+  bool gpu;
+} profileSections[PROFILE_SECTIONS_COUNT] = {
+  { "tick",       false },
+  { "update",     false },
+  { "collisions", false },
+  { "spawn",      false },
+  { "draw",       false },
+  { "culling",    false },
+  { "lights",     false },
+  { "objects",    true  },
+  { "record",     false },
+  { "queue",      false },
+  { "skybox",     true  },
+  { "explosions", true  },
+  { "banner",     true  },
+};
+
+static const char* profileCounterNames[PROFILE_COUNTERS_COUNT] = {
+  "visible",
+  "culled",
+  "packets",
+  "binds",
+  "lights",
+  "triangles",
+  "motion",
+};
+
+static ProfileSectionData profileData[PROFILE_SECTIONS_COUNT];
+static ProfileStats       profileCounters[PROFILE_COUNTERS_COUNT];
+
+void (*beginGpuProfile)(int section) = NULL;
+void (*endGpuProfile)(int section) = NULL;
+
+const char* profileSectionName(int section) {
+  return profileSections[section].name;
+}
+
+bool profileSectionUsesGpu(int section) {
+  return profileSections[section].gpu;
+}
+
+static unsigned int histogramBucket(float milliseconds) {
+
+  const float microseconds = 1000.0f * milliseconds;
+  if(microseconds <= 1.0f)
+    return 0;
+
+  const int bucket = 1 + (int)(PROFILE_HISTOGRAM_PER_OCTAVE * log2(microseconds));
+  return (unsigned int)std::min(bucket, PROFILE_HISTOGRAM_BUCKETS - 1);
+}
+
+// upper bound of the bucket in milliseconds
+static float histogramBucketLimit(unsigned int bucket) {
+  return 0.001f * (float)pow(2.0, (double)bucket / PROFILE_HISTOGRAM_PER_OCTAVE);
+}
+
+static void addSample(ProfileStats &stats, float milliseconds) {
+
+  stats.window[stats.windowNext] = milliseconds;
+  stats.windowNext = (stats.windowNext + 1) % PROFILE_WINDOW;
+  stats.windowCount = std::min(stats.windowCount + 1, (unsigned int)PROFILE_WINDOW);
+
+  if(stats.samples == 0 || milliseconds < stats.minimum)
+    stats.minimum = milliseconds;
+  if(stats.samples == 0 || milliseconds > stats.maximum)
+    stats.maximum = milliseconds;
+
+  stats.samples++;
+  stats.sum += milliseconds;
+  stats.histogram[histogramBucket(milliseconds)]++;
+}
+
+void beginProfile(int section) {
+
+  ProfileSectionData &data = profileData[section];
+
+  if(beginGpuProfile != NULL && profileSections[section].gpu == true)
+    beginGpuProfile(section);
+
+  data.used = true;
+  data.start = ProfileClock::now();
+}
+
+void endProfile(int section) {
+
+  ProfileSectionData &data = profileData[section];
+
+  data.pending += std::chrono::duration<double, std::milli>(ProfileClock::now() - data.start).count();
+
+  if(endGpuProfile != NULL && profileSections[section].gpu == true)
+    endGpuProfile(section);
+}
+
+void profileCommit(int firstSection, int lastSection) {
+
+  for(int s = firstSection; s <= lastSection; s++) {
+    ProfileSectionData &data = profileData[s];
+
+    // sections skipped in this step/frame (e.g. no banner) do not get a zero sample
+    if(data.used == true)
+      addSample(data.cpu, (float)data.pending);
+
+    data.pending = 0.0;
+    data.used = false;
+  }
+}
+
+void addGpuProfileSample(int section, float milliseconds) {
+
+  addSample(profileData[section].gpu, milliseconds);
+}
+
+void profileCount(int counter, unsigned int value) {
+
+  addSample(profileCounters[counter], (float)value);
+}
+
+static ProfileSummary windowSummary(const ProfileStats &stats) {
+
+  ProfileSummary summary;
+  summary.samples = stats.windowCount;
+  summary.minimum = summary.average = summary.p99 = summary.maximum = 0.0f;
+
+  if(stats.windowCount == 0)
+    return summary;
+
+  float sorted[PROFILE_WINDOW];
+  std::copy(stats.window, stats.window + stats.windowCount, sorted);
+
+  const unsigned int p99Index = (unsigned int)ceil(0.99 * stats.windowCount) - 1;
+  std::nth_element(sorted, sorted + p99Index, sorted + stats.windowCount);
+  summary.p99 = sorted[p99Index];
+
+  double sum = 0.0;
+  summary.minimum = summary.maximum = sorted[0];
+  for(unsigned int i = 0; i < stats.windowCount; i++) {
+    sum += sorted[i];
+    summary.minimum = std::min(summary.minimum, sorted[i]);
+    summary.maximum = std::max(summary.maximum, sorted[i]);
+  }
+  summary.average = (float)(sum / stats.windowCount);
+
+  return summary;
+}
+
+ProfileSummary profileWindowSummary(int section, bool gpu) {
+
+  return windowSummary(gpu ? profileData[section].gpu : profileData[section].cpu);
+}
+
+ProfileSummary profileCounterSummary(int counter) {
+
+  return windowSummary(profileCounters[counter]);
+}
+
+ProfileSummary profileTotalSummary(int section, bool gpu) {
+
+  const ProfileStats &stats = gpu ? profileData[section].gpu : profileData[section].cpu;
+
+  ProfileSummary summary;
+  summary.samples = stats.samples;
+  summary.minimum = summary.average = summary.p99 = summary.maximum = 0.0f;
+
+  if(stats.samples == 0)
+    return summary;
+
+  summary.minimum = stats.minimum;
+  summary.maximum = stats.maximum;
+  summary.average = (float)(stats.sum / stats.samples);
+
+  // first bucket reaching 99 % of the samples, its upper bound is the estimate
+  const unsigned long long p99Samples = (unsigned long long)ceil(0.99 * stats.samples);
+  unsigned long long samples = 0;
+  for(unsigned int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+    samples += stats.histogram[b];
+    if(samples >= p99Samples) {
+      summary.p99 = std::min(histogramBucketLimit(b), stats.maximum);
+      break;
+    }
+  }
+
+  return summary;
+}
+
+std::string profileReport(void) {
+
+  std::string report = "section      cpu min    avg    p99   gpu min    avg    p99\n";
+  char line[128];
+
+  for(int s = 0; s < PROFILE_SECTIONS_COUNT; s++) {
+    const ProfileSummary cpu = profileWindowSummary(s, false);
+    if(cpu.samples == 0)
+      continue;
+
+    int length = snprintf(line, sizeof(line), "%-10s  %7.2f %6.2f %6.2f", profileSections[s].name, cpu.minimum, cpu.average, cpu.p99);
+
+    const ProfileSummary gpu = profileWindowSummary(s, true);
+    if(gpu.samples > 0)
+      snprintf(line + length, sizeof(line) - length, "   %7.2f %6.2f %6.2f", gpu.minimum, gpu.average, gpu.p99);
+
+    report += line;
+    report += "\n";
+  }
+
+  bool counterHeader = false;
+  for(int c = 0; c < PROFILE_COUNTERS_COUNT; c++) {
+    const ProfileSummary counter = profileCounterSummary(c);
+    if(counter.samples == 0)
+      continue;
+
+    if(counterHeader == false) {
+      report += "counter          min    avg    p99\n";
+      counterHeader = true;
+    }
+
+    snprintf(line, sizeof(line), "%-10s  %7.0f %6.0f %6.0f\n", profileCounterNames[c], counter.minimum, counter.average, counter.p99);
+    report += line;
+  }
+
+  return report;
+}
+
+bool writeProfileCsv(const std::string &fileName) {
+
+  std::ofstream file(fileName.c_str());
+  if(!file)
+    return false;
+
+  file << "section,source,samples,min_ms,avg_ms,p99_ms,max_ms,window_min_ms,window_avg_ms,window_p99_ms\n";
+
+  for(int s = 0; s < PROFILE_SECTIONS_COUNT; s++) {
+    for(int gpu = 0; gpu < 2; gpu++) {
+      const ProfileSummary total = profileTotalSummary(s, gpu != 0);
+      if(total.samples == 0)
+        continue;
+
+      const ProfileSummary window = profileWindowSummary(s, gpu != 0);
+
+      file << profileSections[s].name << "," << (gpu ? "gpu" : "cpu") << "," << total.samples << ","
+           << total.minimum << "," << total.average << "," << total.p99 << "," << total.maximum << ","
+           << window.minimum << "," << window.average << "," << window.p99 << "\n";
+    }
+  }
+
+  // counters are not times, their rows use the same columns
+  for(int c = 0; c < PROFILE_COUNTERS_COUNT; c++) {
+    const ProfileStats &stats = profileCounters[c];
+    if(stats.samples == 0)
+      continue;
+
+    const ProfileSummary window = profileCounterSummary(c);
+
+    file << profileCounterNames[c] << ",count," << stats.samples << ","
+         << stats.minimum << "," << stats.sum / stats.samples << ",," << stats.maximum << ","
+         << window.minimum << "," << window.average << "," << window.p99 << "\n";
+  }
+
+  return (bool)file;
+}
@@ -0,0 +1,117 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    profiler.h
+ * \brief   Lightweight CPU/GPU profiler of the simulation and drawing phases.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <string>
+
+// profiled phases
+// - simulation sections are committed once per simulation step, drawing sections once per frame
+// - drawing sections marked in profileSectionUsesGpu() are measured by GL timer queries as well,
+//   such sections must not be nested
+enum ProfileSection {
+  PROFILE_TICK,             // whole simulation step
+  PROFILE_UPDATE,           // updateObjects()
+  PROFILE_COLLISIONS,       // checkCollisions()
+  PROFILE_SPAWN,            // launching missiles, generating ufos and asteroids
+
+  PROFILE_DRAW,             // whole drawWindowContents()
+  PROFILE_DRAW_CULLING,     // view frustum culling of the objects
+  PROFILE_DRAW_LIGHTS,      // binning and upload of the point lights
+  PROFILE_DRAW_OBJECTS,     // space ship, asteroids, missiles and ufos
+  PROFILE_DRAW_RECORD,      // packets and instance data recorded by the job system
+  PROFILE_DRAW_QUEUE,       // sorting of the render queue
+  PROFILE_DRAW_SKYBOX,
+  PROFILE_DRAW_EXPLOSIONS,
+  PROFILE_DRAW_BANNER,
+
+  PROFILE_SECTIONS_COUNT
+};
+
+#define PROFILE_SIMULATION_FIRST PROFILE_TICK
+#define PROFILE_SIMULATION_LAST  PROFILE_SPAWN
+#define PROFILE_DRAW_FIRST       PROFILE_DRAW
+#define PROFILE_DRAW_LAST        PROFILE_DRAW_BANNER
+
+// values counted once per frame, their statistics are reported with the sections
+enum ProfileCounter {
+  PROFILE_COUNTER_VISIBLE,  // objects passing the view frustum culling
+  PROFILE_COUNTER_CULLED,   // objects skipped by the view frustum culling
+  PROFILE_COUNTER_PACKETS,  // packets drawn by the render queue
+  PROFILE_COUNTER_BINDS,    // programs, vertex arrays and textures bound by the render queue
+  PROFILE_COUNTER_LIGHTS,   // point lights binned into the light clusters
+  PROFILE_COUNTER_TRIANGLES,// triangles of the visible asteroids and the space ship at their levels of detail
+  PROFILE_COUNTER_MOTION,   // records of spawned or moved objects uploaded for the GPU resident motion
+
+  PROFILE_COUNTERS_COUNT
+};
+
+// number of the most recent samples used for the rolling statistics
+#define PROFILE_WINDOW 240
+
+extern bool showProfilerOverlay;
+
+const char* profileSectionName(int section);
+bool profileSectionUsesGpu(int section);
+
+// starts/stops measuring of the section, the time of all begin/end pairs is summed up until the commit
+void beginProfile(int section);
+void endProfile(int section);
+
+// stores the summed time of sections first...last as one sample of each section
+void profileCommit(int firstSection, int lastSection);
+
+// stores one GPU time sample of the section, called by the timer queries in profiler_gl.cpp
+void addGpuProfileSample(int section, float milliseconds);
+
+// GPU timing of the sections marked in profileSectionUsesGpu(), set by initializeGpuProfiler()
+// - NULL when there are no timer queries, e.g. in the headless runs and the benchmarks
+extern void (*beginGpuProfile)(int section);
+extern void (*endGpuProfile)(int section);
+
+// stores one sample of the counter
+void profileCount(int counter, unsigned int value);
+
+// measures the enclosing block
+struct ProfileScope {
+  ProfileScope(int section) : section(section) { beginProfile(section); }
+  ~ProfileScope() { endProfile(section); }
+
+  int section;
+};
+
+typedef struct _ProfileSummary {
+  unsigned long long samples;
+  float minimum;  // all values in milliseconds
+  float average;
+  float p99;
+  float maximum;
+} ProfileSummary;
+
+// statistics of the last PROFILE_WINDOW samples of the section (CPU or GPU time)
+ProfileSummary profileWindowSummary(int section, bool gpu);
+// statistics of all samples of the section, p99 is estimated from a logarithmic histogram
+ProfileSummary profileTotalSummary(int section, bool gpu);
+
+// statistics of the last PROFILE_WINDOW samples of the counter
+ProfileSummary profileCounterSummary(int counter);
+
+// table with rolling min/avg/p99 of all sections and counters that have some samples
+std::string profileReport(void);
+
+// writes statistics of all sections to a CSV file
+bool writeProfileCsv(const std::string &fileName);
+
+// GL timer queries and the text overlay (profiler_gl.cpp), GPU timing is used only if GL_ARB_timer_query is supported
+void initializeGpuProfiler(void);
+void cleanupGpuProfiler(void);
+
+// draws profileReport() into the top left corner of the window
+void drawProfilerOverlay(int windowWidth, int windowHeight);
+
+#endif // __PROFILER_H
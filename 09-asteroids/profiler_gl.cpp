@@ -0,0 +1,377 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    profiler_gl.cpp
+ * \brief   GL timer queries of the profiled drawing sections and the profiler text overlay.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "pgr.h"
+#include "profiler.h"
+
+// timer queries per section - results are read a few frames later, the CPU never waits for them
+#define PROFILE_GPU_QUERIES 4
+
+// overlay text is rebuilt every few frames only
+// rows of profileReport(): a header and a line per section, a header and a line per counter
+#define PROFILE_OVERLAY_REFRESH 15
+#define PROFILE_OVERLAY_COLUMNS 64
+#define PROFILE_OVERLAY_ROWS    (PROFILE_SECTIONS_COUNT + PROFILE_COUNTERS_COUNT + 2)
+
+// glyph cell of the built-in 5x7 font (one pixel of spacing around each glyph)
+#define PROFILE_GLYPH_WIDTH  6
+#define PROFILE_GLYPH_HEIGHT 9
+
+typedef struct _ProfileGpuQueries {
+  GLuint queries[PROFILE_GPU_QUERIES];
+  bool   queryIssued[PROFILE_GPU_QUERIES]; // waiting for its result
+  unsigned int nextQuery;
+  bool   queryActive;                      // query of this section is running
+} ProfileGpuQueries;
+
+// rows of the 5x7 glyphs of characters 32...95, bit 4 is the leftmost pixel
+// lowercase letters are drawn as uppercase, other characters are drawn as spaces
+static const unsigned char profileFont[64][7] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+  { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // !
+  { 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+  { 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a }, // #
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // $
+  { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // &
+  { 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 }, // apostrophe
+  { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+  { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+  { 0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00 }, // *
+  { 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 }, // +
+  { 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08 }, // ,
+  { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 }, // -
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c }, // .
+  { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+  { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e }, // 0
+  { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e }, // 1
+  { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f }, // 2
+  { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e }, // 3
+  { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 }, // 4
+  { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e }, // 5
+  { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e }, // 6
+  { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+  { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e }, // 8
+  { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c }, // 9
+  { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 }, // :
+  { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08 }, // ;
+  { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // <
+  { 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00 }, // =
+  { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // >
+  { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+  { 0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e }, // @
+  { 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 }, // A
+  { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e }, // B
+  { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e }, // C
+  { 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c }, // D
+  { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f }, // E
+  { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 }, // F
+  { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f }, // G
+  { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 }, // H
+  { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e }, // I
+  { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c }, // J
+  { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+  { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f }, // L
+  { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+  { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+  { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e }, // O
+  { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 }, // P
+  { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d }, // Q
+  { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 }, // R
+  { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e }, // S
+  { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+  { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e }, // U
+  { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 }, // V
+  { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a }, // W
+  { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 }, // X
+  { 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04 }, // Y
+  { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f }, // Z
+  { 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e }, // [
+  { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // backslash
+  { 0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e }, // ]
+  { 0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00 }, // ^
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f }, // _
+};
+
+const std::string profileOverlayVertexShaderSrc(
+  "#version 140\n"
+  "uniform vec2 screenSize;\n"
+  "uniform vec2 overlaySize;\n"
+  "in vec2 corner;\n"
+  "smooth out vec2 texCoord_v;\n"
+  "void main() {\n"
+  "  vec2 pixel = vec2(8.0) + corner * overlaySize;\n"
+  "  gl_Position = vec4(2.0 * pixel.x / screenSize.x - 1.0, 1.0 - 2.0 * pixel.y / screenSize.y, 0.0, 1.0);\n"
+  "  texCoord_v = corner;\n"
+  "}\n"
+);
+
+const std::string profileOverlayFragmentShaderSrc(
+  "#version 140\n"
+  "uniform sampler2D textSampler;\n"
+  "smooth in vec2 texCoord_v;\n"
+  "out vec4 color_f;\n"
+  "void main() {\n"
+  "  float ink = texture(textSampler, texCoord_v).r;\n"
+  "  color_f = mix(vec4(0.0, 0.0, 0.0, 0.6), vec4(1.0, 1.0, 0.6, 1.0), ink);\n"
+  "}\n"
+);
+
+struct ProfilerOverlay {
+  GLuint program;              // = 0;
+  GLint  cornerLocation;       // = -1;
+  GLint  screenSizeLocation;   // = -1;
+  GLint  overlaySizeLocation;  // = -1;
+  GLint  textSamplerLocation;  // = -1;
+
+  GLuint vertexArrayObject;
+  GLuint vertexBufferObject;
+  GLuint texture;              // R8 texture with the rasterized text
+
+  unsigned int framesToRefresh;
+  std::vector<unsigned char> pixels;
+} profilerOverlay;
+
+static ProfileGpuQueries profileQueries[PROFILE_SECTIONS_COUNT];
+
+static bool gpuProfiling = false;
+
+bool showProfilerOverlay = false;
+
+// reads results of finished timer queries of the section, oldest first
+static void collectGpuSamples(int section) {
+
+  ProfileGpuQueries &data = profileQueries[section];
+
+  for(unsigned int i = 0; i < PROFILE_GPU_QUERIES; i++) {
+    const unsigned int q = (data.nextQuery + i) % PROFILE_GPU_QUERIES;
+    if(data.queryIssued[q] == false)
+      continue;
+
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(data.queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(available == GL_FALSE)
+      break;
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(data.queries[q], GL_QUERY_RESULT, &nanoseconds);
+    addGpuProfileSample(section, (float)(nanoseconds * 1e-6));
+    data.queryIssued[q] = false;
+  }
+}
+
+static void beginGpuQuery(int section) {
+
+  ProfileGpuQueries &data = profileQueries[section];
+
+  collectGpuSamples(section);
+
+  // all queries still in flight -> this frame is not measured on the GPU
+  if(data.queryIssued[data.nextQuery] == false) {
+    glBeginQuery(GL_TIME_ELAPSED, data.queries[data.nextQuery]);
+    data.queryActive = true;
+  }
+}
+
+static void endGpuQuery(int section) {
+
+  ProfileGpuQueries &data = profileQueries[section];
+
+  if(data.queryActive == true) {
+    glEndQuery(GL_TIME_ELAPSED);
+    data.queryIssued[data.nextQuery] = true;
+    data.nextQuery = (data.nextQuery + 1) % PROFILE_GPU_QUERIES;
+    data.queryActive = false;
+  }
+}
+
+static bool timerQuerySupported(void) {
+
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+  // timer queries are core since OpenGL 3.3
+  if(major > 3 || (major == 3 && minor >= 3))
+    return true;
+
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+  for(GLint i = 0; i < extensionCount; i++) {
+    const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+    if(extension != NULL && strcmp(extension, "GL_ARB_timer_query") == 0)
+      return true;
+  }
+
+  return false;
+}
+
+void initializeGpuProfiler(void) {
+
+  gpuProfiling = timerQuerySupported();
+
+  if(gpuProfiling == true) {
+    for(int s = 0; s < PROFILE_SECTIONS_COUNT; s++) {
+      if(profileSectionUsesGpu(s) == true)
+        glGenQueries(PROFILE_GPU_QUERIES, profileQueries[s].queries);
+    }
+    beginGpuProfile = beginGpuQuery;
+    endGpuProfile = endGpuQuery;
+  }
+  else {
+    std::cerr << "GL timer queries not supported, GPU times will not be profiled" << std::endl;
+  }
+
+  // text overlay
+  std::vector<GLuint> shaderList;
+  shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, profileOverlayVertexShaderSrc));
+  shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, profileOverlayFragmentShaderSrc));
+
+  profilerOverlay.program = pgr::createProgram(shaderList);
+
+  profilerOverlay.cornerLocation      = glGetAttribLocation(profilerOverlay.program, "corner");
+  profilerOverlay.screenSizeLocation  = glGetUniformLocation(profilerOverlay.program, "screenSize");
+  profilerOverlay.overlaySizeLocation = glGetUniformLocation(profilerOverlay.program, "overlaySize");
+  profilerOverlay.textSamplerLocation = glGetUniformLocation(profilerOverlay.program, "textSampler");
+
+  static const float corners[] = {
+    0.0f, 0.0f,
+    1.0f, 0.0f,
+    0.0f, 1.0f,
+    1.0f, 1.0f
+  };
+
+  glGenVertexArrays(1, &profilerOverlay.vertexArrayObject);
+  glBindVertexArray(profilerOverlay.vertexArrayObject);
+
+  glGenBuffers(1, &profilerOverlay.vertexBufferObject);
+  glBindBuffer(GL_ARRAY_BUFFER, profilerOverlay.vertexBufferObject);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+  glEnableVertexAttribArray(profilerOverlay.cornerLocation);
+  glVertexAttribPointer(profilerOverlay.cornerLocation, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+  glBindVertexArray(0);
+
+  profilerOverlay.pixels.assign(PROFILE_OVERLAY_COLUMNS * PROFILE_GLYPH_WIDTH * PROFILE_OVERLAY_ROWS * PROFILE_GLYPH_HEIGHT, 0);
+
+  glGenTextures(1, &profilerOverlay.texture);
+  glBindTexture(GL_TEXTURE_2D, profilerOverlay.texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, PROFILE_OVERLAY_COLUMNS * PROFILE_GLYPH_WIDTH, PROFILE_OVERLAY_ROWS * PROFILE_GLYPH_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, &profilerOverlay.pixels[0]);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  profilerOverlay.framesToRefresh = 0;
+  CHECK_GL_ERROR();
+}
+
+void cleanupGpuProfiler(void) {
+
+  if(gpuProfiling == true) {
+    beginGpuProfile = NULL;
+    endGpuProfile = NULL;
+
+    for(int s = 0; s < PROFILE_SECTIONS_COUNT; s++) {
+      if(profileSectionUsesGpu(s) == true)
+        glDeleteQueries(PROFILE_GPU_QUERIES, profileQueries[s].queries);
+    }
+    gpuProfiling = false;
+  }
+
+  pgr::deleteProgramAndShaders(profilerOverlay.program);
+  glDeleteVertexArrays(1, &profilerOverlay.vertexArrayObject);
+  glDeleteBuffers(1, &profilerOverlay.vertexBufferObject);
+  glDeleteTextures(1, &profilerOverlay.texture);
+}
+
+// rasterizes the text into the overlay pixels using the built-in font
+static void rasterizeText(const std::string &text) {
+
+  const unsigned int width = PROFILE_OVERLAY_COLUMNS * PROFILE_GLYPH_WIDTH;
+
+  std::fill(profilerOverlay.pixels.begin(), profilerOverlay.pixels.end(), 0);
+
+  unsigned int row = 0, column = 0;
+
+  for(size_t i = 0; i < text.size() && row < PROFILE_OVERLAY_ROWS; i++) {
+    char c = text[i];
+
+    if(c == '\n') {
+      row++;
+      column = 0;
+      continue;
+    }
+    if(column >= PROFILE_OVERLAY_COLUMNS)
+      continue;
+
+    if(c >= 'a' && c <= 'z')
+      c = c - 'a' + 'A';
+
+    if(c >= 32 && c < 96) {
+      const unsigned char *glyph = profileFont[c - 32];
+
+      for(unsigned int y = 0; y < 7; y++) {
+        unsigned char *pixel = &profilerOverlay.pixels[(row * PROFILE_GLYPH_HEIGHT + y + 1) * width + column * PROFILE_GLYPH_WIDTH];
+        for(unsigned int x = 0; x < 5; x++)
+          pixel[x] = (glyph[y] & (0x10 >> x)) ? 255 : 0;
+      }
+    }
+    column++;
+  }
+}
+
+void drawProfilerOverlay(int windowWidth, int windowHeight) {
+
+  const int textureWidth  = PROFILE_OVERLAY_COLUMNS * PROFILE_GLYPH_WIDTH;
+  const int textureHeight = PROFILE_OVERLAY_ROWS * PROFILE_GLYPH_HEIGHT;
+
+  if(profilerOverlay.framesToRefresh == 0) {
+    rasterizeText(profileReport());
+
+    glBindTexture(GL_TEXTURE_2D, profilerOverlay.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureWidth, textureHeight, GL_RED, GL_UNSIGNED_BYTE, &profilerOverlay.pixels[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    profilerOverlay.framesToRefresh = PROFILE_OVERLAY_REFRESH;
+  }
+  profilerOverlay.framesToRefresh--;
+
+  // integer magnification keeps the font sharp
+  const int scale = std::max(1, std::min(2, (windowWidth - 16) / textureWidth));
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDisable(GL_DEPTH_TEST);
+
+  glUseProgram(profilerOverlay.program);
+  glUniform2f(profilerOverlay.screenSizeLocation, (float)windowWidth, (float)windowHeight);
+  glUniform2f(profilerOverlay.overlaySizeLocation, (float)(scale * textureWidth), (float)(scale * textureHeight));
+  glUniform1i(profilerOverlay.textSamplerLocation, 0);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, profilerOverlay.texture);
+  glBindVertexArray(profilerOverlay.vertexArrayObject);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+
+  glEnable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+}
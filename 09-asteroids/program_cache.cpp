@@ -0,0 +1,302 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    program_cache.cpp
+ * \brief   Binary cache of linked shader programs, skips GLSL compilation on warm starts.
+ *
+ * Cache file layout (native byte order):
+ *   ProgramCacheHeader | program binary
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "program_cache.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME        1099511628211ULL
+
+static const char PROGRAM_CACHE_MAGIC[4] = { 'P', 'R', 'G', 'C' };
+
+typedef struct _ProgramCacheHeader {
+  char               magic[4];
+  unsigned int       version;
+  unsigned long long key;           // hash of the sources and the driver, see programKey()
+  unsigned int       binaryFormat;  // format returned by glGetProgramBinary()
+  unsigned int       binarySize;
+  unsigned int       headerSize;    // sizeof(ProgramCacheHeader) of the writer, catches differently packed builds
+  unsigned int       reserved;
+} ProgramCacheHeader;
+
+struct ProgramCache {
+  bool              binarySupported;  // = false; glGetProgramBinary() and glProgramBinary() can be used
+  std::string       driver;           // vendor, renderer and version strings, binaries of other drivers are not loaded
+  ProgramCacheStats stats;
+} programCache;
+
+static bool programBinarySupported(void) {
+
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+  // program binaries are core since OpenGL 4.1
+  bool supported = (major > 4 || (major == 4 && minor >= 1));
+
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+  for(GLint i = 0; i < extensionCount && supported == false; i++) {
+    const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+    if(extension != NULL && strcmp(extension, "GL_ARB_get_program_binary") == 0)
+      supported = true;
+  }
+
+  // the driver may support the functions without offering any binary format
+  GLint formatCount = 0;
+  if(supported)
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+  return formatCount > 0;
+}
+
+static std::string glString(GLenum name) {
+
+  const char *value = (const char*)glGetString(name);
+  return (value != NULL) ? value : "";
+}
+
+void initializeProgramCache(void) {
+
+  programCache.binarySupported = programBinarySupported();
+  programCache.driver = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+  programCache.stats.loaded = 0;
+  programCache.stats.compiled = 0;
+
+  if(programCache.binarySupported == false)
+    std::cerr << "Program binaries not supported, shaders will be compiled on every start" << std::endl;
+}
+
+ProgramShader shaderFromFile(GLenum type, const std::string &fileName) {
+
+  ProgramShader shader;
+  shader.type = type;
+
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  if(!file) {
+    std::cerr << "shaderFromFile(): cannot read " << fileName << std::endl;
+    return shader;
+  }
+
+  std::ostringstream text;
+  text << file.rdbuf();
+  shader.source = text.str();
+
+  return shader;
+}
+
+ProgramShader shaderFromSource(GLenum type, const std::string &source) {
+
+  ProgramShader shader;
+  shader.type = type;
+  shader.source = source;
+  return shader;
+}
+
+static unsigned long long hashBytes(unsigned long long hash, const void *data, size_t size) {
+
+  const unsigned char *bytes = (const unsigned char*)data;
+  for(size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// strings are hashed with their terminating zero -> "ab" + "c" differs from "a" + "bc"
+static unsigned long long hashString(unsigned long long hash, const std::string &text) {
+
+  return hashBytes(hash, text.c_str(), text.size() + 1);
+}
+
+static unsigned long long programKey(const std::vector<ProgramShader> &shaders, const std::vector<AttributeBinding> &attributes) {
+
+  unsigned long long hash = hashString(FNV_OFFSET_BASIS, programCache.driver);
+
+  for(size_t i = 0; i < shaders.size(); i++) {
+    hash = hashBytes(hash, &shaders[i].type, sizeof(shaders[i].type));
+    hash = hashString(hash, shaders[i].source);
+  }
+
+  for(size_t i = 0; i < attributes.size(); i++) {
+    hash = hashBytes(hash, &attributes[i].location, sizeof(attributes[i].location));
+    hash = hashString(hash, attributes[i].name);
+  }
+
+  return hash;
+}
+
+static GLuint loadProgramBinary(const std::string &cacheName, unsigned long long key) {
+
+  FILE *file = std::fopen(cacheName.c_str(), "rb");
+  if(file == NULL)
+    return 0;
+
+  ProgramCacheHeader header;
+  std::vector<unsigned char> binary;
+
+  bool valid =
+    std::fread(&header, sizeof(header), 1, file) == 1 &&
+    memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+    header.version == PROGRAM_CACHE_VERSION &&
+    header.headerSize == sizeof(ProgramCacheHeader) &&
+    header.key == key &&
+    header.binarySize > 0;
+
+  if(valid) {
+    binary.resize(header.binarySize);
+    valid = (std::fread(&binary[0], 1, binary.size(), file) == binary.size());
+  }
+
+  std::fclose(file);
+
+  if(valid == false)
+    return 0;
+
+  GLuint program = glCreateProgram();
+  glProgramBinary(program, header.binaryFormat, &binary[0], (GLsizei)binary.size());
+
+  // the driver rejects binaries of its other versions or configurations even if the strings match
+  GLint linkStatus = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  if(linkStatus != GL_TRUE) {
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  return program;
+}
+
+static bool saveProgramBinary(const std::string &cacheName, unsigned long long key, GLuint program) {
+
+  GLint binarySize = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+  if(binarySize <= 0)
+    return false;
+
+  std::vector<unsigned char> binary(binarySize);
+  GLenum binaryFormat = 0;
+  GLsizei length = 0;
+  glGetProgramBinary(program, binarySize, &length, &binaryFormat, &binary[0]);
+  if(length <= 0)
+    return false;
+
+  ProgramCacheHeader header;
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+  header.version = PROGRAM_CACHE_VERSION;
+  header.key = key;
+  header.binaryFormat = binaryFormat;
+  header.binarySize = (unsigned int)length;
+  header.headerSize = sizeof(ProgramCacheHeader);
+
+  // written to a temporary file first -> an interrupted write never leaves a valid looking cache behind
+  const std::string temporaryName = cacheName + ".tmp";
+  FILE *file = std::fopen(temporaryName.c_str(), "wb");
+  if(file == NULL)
+    return false;
+
+  bool written =
+    std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+    std::fwrite(&binary[0], 1, header.binarySize, file) == header.binarySize;
+
+  written = (std::fclose(file) == 0) && written;
+
+  if(written) {
+    std::remove(cacheName.c_str());  // rename does not replace existing files on Windows
+    written = (std::rename(temporaryName.c_str(), cacheName.c_str()) == 0);
+  }
+
+  if(written == false)
+    std::remove(temporaryName.c_str());
+
+  return written;
+}
+
+static GLuint compileProgram(const std::string &name, const std::vector<ProgramShader> &shaders, const std::vector<AttributeBinding> &attributes) {
+
+  GLuint program = glCreateProgram();
+
+  bool compiled = true;
+  for(size_t i = 0; i < shaders.size(); i++) {
+    // compilation errors are reported by pgr
+    GLuint shader = pgr::createShaderFromSource(shaders[i].type, shaders[i].source);
+    if(shader == 0) {
+      compiled = false;
+      continue;
+    }
+    glAttachShader(program, shader);
+  }
+
+  if(compiled == false) {
+    pgr::deleteProgramAndShaders(program);
+    return 0;
+  }
+
+  for(size_t i = 0; i < attributes.size(); i++)
+    glBindAttribLocation(program, attributes[i].location, attributes[i].name.c_str());
+
+  // the hint has to be set before linking, otherwise the driver may not keep the binary
+  if(programCache.binarySupported)
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+  glLinkProgram(program);
+
+  GLint linkStatus = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  if(linkStatus != GL_TRUE) {
+    GLint logLength = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+    std::vector<char> log(logLength + 1, '\0');
+    glGetProgramInfoLog(program, logLength, NULL, &log[0]);
+    std::cerr << "createCachedProgram(): linking of " << name << " failed:" << std::endl << &log[0] << std::endl;
+
+    pgr::deleteProgramAndShaders(program);
+    return 0;
+  }
+
+  return program;
+}
+
+GLuint createCachedProgram(const std::string &name, const std::vector<ProgramShader> &shaders, const std::vector<AttributeBinding> &attributes) {
+
+  const std::string cacheName = name + PROGRAM_CACHE_SUFFIX;
+  const unsigned long long key = programKey(shaders, attributes);
+
+  if(programCache.binarySupported) {
+    GLuint program = loadProgramBinary(cacheName, key);
+    if(program != 0) {
+      programCache.stats.loaded++;
+      return program;
+    }
+  }
+
+  GLuint program = compileProgram(name, shaders, attributes);
+  if(program == 0)
+    return 0;
+
+  programCache.stats.compiled++;
+
+  if(programCache.binarySupported && saveProgramBinary(cacheName, key, program) == false)
+    std::cerr << "createCachedProgram(): cannot write program cache " << cacheName << std::endl;
+
+  return program;
+}
+
+ProgramCacheStats programCacheStats(void) {
+
+  return programCache.stats;
+}
@@ -0,0 +1,64 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    program_cache.h
+ * \brief   Binary cache of linked shader programs, skips GLSL compilation on warm starts.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __PROGRAM_CACHE_H
+#define __PROGRAM_CACHE_H
+
+#include <string>
+#include <vector>
+#include "pgr.h"
+
+// version of the cache file layout - increase whenever the layout changes
+#define PROGRAM_CACHE_VERSION 1
+
+// cache of program "lighting" is stored as "lighting.programcache" next to the shaders
+#define PROGRAM_CACHE_SUFFIX ".programcache"
+
+// shader stage of a program, the source is read from a file or given directly
+typedef struct _ProgramShader {
+  GLenum      type;
+  std::string source;
+} ProgramShader;
+
+// attribute bound to a fixed location before the program is linked
+typedef struct _AttributeBinding {
+  GLuint      location;
+  std::string name;
+} AttributeBinding;
+
+// number of programs created since initializeProgramCache()
+typedef struct _ProgramCacheStats {
+  unsigned int loaded;    // from the cache, without compilation
+  unsigned int compiled;  // from the sources, cache missing, outdated or rejected by the driver
+} ProgramCacheStats;
+
+// checks the binary program support and reads the strings identifying the driver, call before the first createCachedProgram()
+void initializeProgramCache(void);
+
+// reads the source of the shader, an unreadable file gives an empty source that fails to compile
+ProgramShader shaderFromFile(GLenum type, const std::string &fileName);
+ProgramShader shaderFromSource(GLenum type, const std::string &source);
+
+//**************************************************************************************************
+/// Creates the program from its cached binary, or compiles and links it and caches the binary.
+/**
+ The cache is keyed by the hash of the shader sources, the attribute bindings and the vendor,
+ renderer and version strings of the driver. Without binary program support (OpenGL 4.1 or
+ GL_ARB_get_program_binary) the program is always compiled. Uniform values and block bindings
+ are not part of the binary and have to be set after each creation.
+
+ \param[in]  name        Name of the program, used for the cache file.
+ \param[in]  shaders     Shader stages of the program.
+ \param[in]  attributes  Attribute locations set before linking.
+ \return                 Linked program (shaders stay attached), 0 if compilation or linking failed.
+*/
+GLuint createCachedProgram(const std::string &name, const std::vector<ProgramShader> &shaders,
+                           const std::vector<AttributeBinding> &attributes = std::vector<AttributeBinding>());
+
+ProgramCacheStats programCacheStats(void);
+
+#endif // __PROGRAM_CACHE_H
@@ -0,0 +1,169 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    render_queue.cpp
+ * \brief   Render queue - draw packets are collected during the frame, sorted by their
+ *          state and executed with redundant state changes skipped.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cstring>
+#include "render_queue.h"
+
+// no object has this name -> the first packet always binds
+#define RENDER_STATE_UNKNOWN 0xffffffffu
+
+struct RenderQueue {
+
+  std::vector<RenderPacket>   packets;
+  std::vector<RenderSortItem> items;
+  std::vector<RenderSortItem> scratch;
+
+  unsigned int passBegin[RENDER_PASSES_COUNT + 1];  // sorted items of pass p are passBegin[p] ... passBegin[p+1]-1
+
+  RenderQueueStats stats;
+
+} renderQueue;
+
+// depth of a non-negative float keeps its order when compared as an integer
+static unsigned long long depthBits(float depth) {
+
+  if(!(depth > 0.0f))
+    return 0;
+
+  unsigned int bits;
+  memcpy(&bits, &depth, sizeof(bits));
+
+  // sign bit is zero -> exponent and the upper 15 bits of the mantissa
+  return (bits >> 7) & 0xffffff;
+}
+
+static unsigned long long packetKey(RenderPass pass, float depth, const RenderPacket &packet) {
+
+  return ((unsigned long long)pass                              << 60) |
+         ((unsigned long long)(packet.program & 0xff)            << 52) |
+         ((unsigned long long)(packet.vertexArrayObject & 0xfff) << 40) |
+         ((unsigned long long)(packet.texture & 0xfff)           << 28) |
+         (depthBits(depth)                                       << 4);
+}
+
+void beginRenderQueue(void) {
+
+  renderQueue.packets.clear();
+  renderQueue.items.clear();
+
+  for(int p = 0; p <= RENDER_PASSES_COUNT; p++)
+    renderQueue.passBegin[p] = 0;
+
+  renderQueue.stats.packets = 0;
+  renderQueue.stats.binds = 0;
+}
+
+void submitPacket(RenderPass pass, float depth, const RenderPacket &packet) {
+
+  recordPacket(reservePackets(1), pass, depth, packet);
+}
+
+unsigned int reservePackets(unsigned int count) {
+
+  const unsigned int first = (unsigned int)renderQueue.packets.size();
+
+  renderQueue.packets.resize(first + count);
+  renderQueue.items.resize(first + count);
+
+  return first;
+}
+
+void recordPacket(unsigned int index, RenderPass pass, float depth, const RenderPacket &packet) {
+
+  // items are not moved before the sort -> item i refers to packet i
+  renderQueue.items[index].key = packetKey(pass, depth, packet);
+  renderQueue.items[index].packet = index;
+
+  renderQueue.packets[index] = packet;
+}
+
+void sortRenderQueue(void) {
+
+  radixSortKeys(renderQueue.items, renderQueue.scratch);
+
+  // the pass is in the highest bits -> passes are stored one after another
+  const unsigned int count = (unsigned int)renderQueue.items.size();
+  unsigned int i = 0;
+  for(int p = 0; p < RENDER_PASSES_COUNT; p++) {
+    renderQueue.passBegin[p] = i;
+    while(i < count && (int)(renderQueue.items[i].key >> 60) == p)
+      i++;
+  }
+  renderQueue.passBegin[RENDER_PASSES_COUNT] = count;
+}
+
+static void beginPass(RenderPass pass) {
+
+  if(pass == RENDER_PASS_EFFECTS) {
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+  }
+}
+
+static void endPass(RenderPass pass) {
+
+  if(pass == RENDER_PASS_EFFECTS) {
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+  }
+}
+
+void executeRenderQueue(RenderPass pass) {
+
+  const unsigned int begin = renderQueue.passBegin[pass];
+  const unsigned int end = renderQueue.passBegin[pass + 1];
+  if(begin == end)
+    return;
+
+  beginPass(pass);
+  glActiveTexture(GL_TEXTURE0 + 0);
+
+  GLuint program = RENDER_STATE_UNKNOWN;
+  GLuint vertexArrayObject = RENDER_STATE_UNKNOWN;
+  GLuint texture = RENDER_STATE_UNKNOWN;
+
+  for(unsigned int i = begin; i < end; i++) {
+
+    const RenderPacket &packet = renderQueue.packets[renderQueue.items[i].packet];
+
+    if(packet.program != program) {
+      program = packet.program;
+      glUseProgram(program);
+      renderQueue.stats.binds++;
+    }
+
+    if(packet.vertexArrayObject != vertexArrayObject) {
+      vertexArrayObject = packet.vertexArrayObject;
+      glBindVertexArray(vertexArrayObject);
+      renderQueue.stats.binds++;
+    }
+
+    // a packet without texture does not sample it -> the bound one can stay
+    if(packet.texture != 0 && packet.texture != texture) {
+      texture = packet.texture;
+      glBindTexture(GL_TEXTURE_2D, texture);
+      renderQueue.stats.binds++;
+    }
+
+    packet.draw(packet);
+  }
+
+  renderQueue.stats.packets += end - begin;
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+
+  endPass(pass);
+  CHECK_GL_ERROR();
+}
+
+RenderQueueStats renderQueueStats(void) {
+
+  return renderQueue.stats;
+}
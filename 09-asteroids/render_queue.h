@@ -0,0 +1,114 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    render_queue.h
+ * \brief   Render queue - draw packets are collected during the frame, sorted by their
+ *          state and executed with redundant state changes skipped.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __RENDER_QUEUE_H
+#define __RENDER_QUEUE_H
+
+#include <vector>
+#include "pgr.h"
+
+// passes are executed in this order, each one sets its own depth test and blending
+enum RenderPass {
+  RENDER_PASS_OPAQUE,   // depth tested, packets sorted front to back
+  RENDER_PASS_EFFECTS,  // additive blending without depth test, order independent
+
+  RENDER_PASSES_COUNT
+};
+
+struct _RenderPacket;
+
+// uploads the uniforms recorded in the packet and issues its draw calls,
+// the program, vertex array object and texture are already bound
+typedef void (*RenderCallback)(const struct _RenderPacket &packet);
+
+// one draw recorded for the GL thread - the packet holds everything the callback needs,
+// so it can be recorded by any thread and the objects may change before it is executed
+typedef struct _RenderPacket {
+  GLuint         program;
+  GLuint         vertexArrayObject;
+  GLuint         texture;       // GL_TEXTURE_2D bound to texturing unit 0, 0 = none
+  RenderCallback draw;
+
+  glm::mat4      PVMmatrix;
+  glm::mat4      modelMatrix;
+  glm::mat4      normalMatrix;
+  glm::vec4      parameters[2]; // values of the callback, e.g. blink factor or billboard of the object
+  unsigned int   lod;           // level of detail of the mesh
+} RenderPacket;
+
+// key of a packet - bits 63..60 pass, 59..52 program, 51..40 vertex array object,
+// 39..28 texture, 27..4 depth; only the low bits of the object names are used,
+// names sharing them cost a redundant bind, never a wrong one
+typedef struct _RenderSortItem {
+  unsigned long long key;
+  unsigned int       packet;    // index of the packet in the queue
+} RenderSortItem;
+
+// number of packets and executed binds of the last frame
+typedef struct _RenderQueueStats {
+  unsigned int packets;
+  unsigned int binds;           // programs, vertex array objects and textures actually bound
+} RenderQueueStats;
+
+// removes the packets of the previous frame, the storage is kept
+void beginRenderQueue(void);
+
+//**************************************************************************************************
+/// Appends a packet to the queue.
+/**
+ \param[in]  pass    Pass the packet is drawn in.
+ \param[in]  depth   Distance of the object from the camera, must not be negative.
+ \param[in]  packet  State and callback of the draw, copied into the queue.
+*/
+void submitPacket(RenderPass pass, float depth, const RenderPacket &packet);
+
+// appends count packets filled later by recordPacket(), returns the index of the first one
+unsigned int reservePackets(unsigned int count);
+
+//**************************************************************************************************
+/// Fills a packet appended by reservePackets().
+/**
+ Packets of different indices may be recorded by several threads at once, nothing else may touch
+ the queue meanwhile. Packets with equal keys are executed in the order of their indices, so the
+ result does not depend on the thread recording a packet.
+
+ \param[in]  index   Index of the packet returned by reservePackets() plus the offset within the range.
+ \param[in]  pass    Pass the packet is drawn in.
+ \param[in]  depth   Distance of the object from the camera, must not be negative.
+ \param[in]  packet  State, uniforms and callback of the draw, copied into the queue.
+*/
+void recordPacket(unsigned int index, RenderPass pass, float depth, const RenderPacket &packet);
+
+// sorts the submitted packets by their keys, called once after the last submitPacket() of the frame
+void sortRenderQueue(void);
+
+//**************************************************************************************************
+/// Draws the packets of one pass.
+/**
+ The pass state is set once for all packets. A program, vertex array object or texture is bound
+ only if it differs from the one bound by the previous packet. All bindings are reset at the end.
+
+ \param[in]  pass  Pass to be drawn, the queue has to be sorted.
+*/
+void executeRenderQueue(RenderPass pass);
+
+// statistics of the packets executed since beginRenderQueue()
+RenderQueueStats renderQueueStats(void);
+
+//**************************************************************************************************
+/// Sorts the items by their keys.
+/**
+ LSD radix sort by bytes, the sort is stable. Bytes equal in all keys are skipped, the common
+ case for the high bits of a queue with few programs.
+
+ \param[in,out]  items    Items to be sorted.
+ \param[in,out]  scratch  Temporary storage, resized to the size of items.
+*/
+void radixSortKeys(std::vector<RenderSortItem> &items, std::vector<RenderSortItem> &scratch);
+
+#endif // __RENDER_QUEUE_H
@@ -0,0 +1,56 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    render_queue_sort.cpp
+ * \brief   Radix sort of the render queue keys, kept apart from the queue so that it links without GL.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cstring>
+#include "render_queue.h"
+
+void radixSortKeys(std::vector<RenderSortItem> &items, std::vector<RenderSortItem> &scratch) {
+
+  const size_t count = items.size();
+  if(count < 2)
+    return;
+
+  scratch.resize(count);
+
+  // bytes of the keys that differ somewhere -> only these are sorted
+  unsigned long long differing = 0;
+  for(size_t i = 1; i < count; i++)
+    differing |= items[i].key ^ items[0].key;
+
+  RenderSortItem *source = &items[0];
+  RenderSortItem *target = &scratch[0];
+
+  for(int shift = 0; shift < 64; shift += 8) {
+
+    if(((differing >> shift) & 0xff) == 0)
+      continue;
+
+    size_t offsets[256];
+    memset(offsets, 0, sizeof(offsets));
+
+    for(size_t i = 0; i < count; i++)
+      offsets[(source[i].key >> shift) & 0xff]++;
+
+    size_t sum = 0;
+    for(int b = 0; b < 256; b++) {
+      const size_t bucketSize = offsets[b];
+      offsets[b] = sum;
+      sum += bucketSize;
+    }
+
+    for(size_t i = 0; i < count; i++)
+      target[offsets[(source[i].key >> shift) & 0xff]++] = source[i];
+
+    RenderSortItem *swap = source;
+    source = target;
+    target = swap;
+  }
+
+  // odd number of sorted bytes -> the result is in the scratch buffer
+  if(source != &items[0])
+    items.swap(scratch);
+}
@@ -8,10 +8,23 @@
 //----------------------------------------------------------------------------------------
 
 #include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
 #include "pgr.h"
 #include "render_stuff.h"
 #include "data.h"
 #include "spline.h"
+#include "mesh_cache.h"
+#include "clustered_lights.h"
+#include "culling.h"
+#include "program_cache.h"
+#include "asset_loader.h"
+#include "render_queue.h"
+#include "gpu_motion.h"
+#include "job_system.h"
+#include "profiler.h"
 
 MeshGeometry* asteroidGeometry = NULL;
 MeshGeometry* spaceShipGeometry = NULL;
@@ -31,6 +44,93 @@ const char* SKYBOX_CUBE_TEXTURE_FILE_PREFIX = "data/skybox";
 SCommonShaderProgram shaderProgram;
 
 bool useLighting = false;
+bool useInstancing = false;
+bool useGpuMotion = false;
+
+// lighting shader fetching transforms of the objects from the instance buffer
+struct InstancedShaderProgram {
+  // identifier for the shader program
+  GLuint program;                   // = 0;
+  // uniforms locations
+  // material
+  GLint diffuseLocation;            // = -1;
+  GLint ambientLocation;            // = -1;
+  GLint specularLocation;           // = -1;
+  GLint shininessLocation;          // = -1;
+  // texture
+  GLint useTextureLocation;         // = -1;
+  GLint texSamplerLocation;         // = -1;
+  // instance data
+  GLint instanceDataLocation;       // = -1;
+  GLint instanceBaseLocation;       // = -1;
+  GLint instanceTintLocation;       // = -1;
+  GLint instanceMotionLocation;     // = -1;
+  GLint ufoCurveShapeLocation;      // = -1;
+} instancedShaderProgram;
+
+// binding point of the FrameData uniform block in all programs
+#define FRAME_UNIFORMS_BINDING 0
+
+// per-frame data shared by the programs, must match the std140 layout of the FrameData block
+struct FrameUniforms {
+  glm::mat4 Vmatrix;
+  glm::mat4 Pmatrix;
+  glm::mat4 PVmatrix;
+  glm::vec4 sunDirection;       // eye space, w = 0
+  glm::vec4 reflectorPosition;  // eye space, w = 1
+  glm::vec4 reflectorDirection; // eye space, normalized, w = 0
+  glm::vec4 clusterScale;       // light clusters per pixel (xy), depth slice scale and bias (zw)
+  float     time;
+  float     clusterLogDepth;    // 1 = logarithmic depth slices
+  float     padding[2];         // std140 blocks are rounded up to a multiple of vec4
+};
+
+// uniform buffer bound to FRAME_UNIFORMS_BINDING, refilled at the beginning of each frame
+struct FrameUniformBuffer {
+  GLuint        bufferObject;   // = 0;
+  FrameUniforms data;           // CPU copy of the current frame
+} frameUniformBuffer;
+
+// must match INSTANCE_TEXELS in lightingInstanced.vert
+#define INSTANCE_TEXELS 8
+
+// tints selected by the instanceTint uniform (components of the 8th texel of an instance)
+enum { INSTANCE_TINT_BLINK, INSTANCE_TINT_BLINK_INVERSE, INSTANCE_TINT_NONE };
+
+// source of the instance transforms selected by the instanceMotion uniform, must match lightingInstanced.vert
+enum { INSTANCE_MOTION_NONE, INSTANCE_MOTION_LINE, INSTANCE_MOTION_CURVE };
+
+// minimum number of packets or instances recorded by one job
+#define RECORD_GRAIN_SIZE 256
+
+// per-instance data of asteroids, missiles and ufos, refilled and streamed to the GPU once per frame
+struct InstanceBuffer {
+  GLuint bufferObject;            // = 0; buffer with INSTANCE_TEXELS RGBA32F texels per instance
+  GLuint texture;                 // = 0; buffer texture reading the buffer object
+  unsigned int maxInstances;      // limit given by GL_MAX_TEXTURE_BUFFER_SIZE
+  unsigned int allocated;         // number of instances the buffer object has room for
+  std::vector<glm::vec4> texels;  // CPU copy filled before the upload
+  std::vector<unsigned int> asteroidOrder;  // visible asteroids grouped by their level of detail
+} instanceBuffer;
+
+// ID pass of the picking - asteroid handles are drawn into the ID buffer
+struct PickIdShaderProgram {
+  // identifier for the shader program
+  GLuint program;                 // = 0;
+  // uniforms locations
+  GLint transformsLocation;       // = -1;
+  GLint handlesLocation;          // = -1;
+} pickIdShaderProgram;
+
+// per-instance data of the ID pass, refilled only in frames drawing the ID pass
+struct PickIdBuffer {
+  GLuint transformBuffer;             // = 0; model matrix columns, 4 RGBA32F texels per instance
+  GLuint transformTexture;            // = 0;
+  GLuint handleBuffer;                // = 0; object handles, 1 R32UI texel per instance
+  GLuint handleTexture;               // = 0;
+  unsigned int maxInstances;          // limit given by GL_MAX_TEXTURE_BUFFER_SIZE
+  std::vector<glm::vec4> transforms;  // CPU copy filled before the upload
+} pickIdBuffer;
 
 struct ExplosionShaderProgram {
   // identifier for the shader program
@@ -39,9 +139,8 @@ struct ExplosionShaderProgram {
   GLint posLocation;           // = -1;
   GLint texCoordLocation;      // = -1;
   // uniforms locations
-  GLint PVMmatrixLocation;     // = -1;
-  GLint VmatrixLocation;       // = -1;
-  GLint timeLocation;          // = -1;
+  GLint billboardLocation;     // = -1;
+  GLint startTimeLocation;     // = -1;
   GLint texSamplerLocation;    // = -1;
   GLint frameDurationLocation; // = -1;
 
@@ -55,7 +154,7 @@ struct BannerShaderProgram {
   GLint texCoordLocation;   // = -1;
   // uniforms locations
   GLint PVMmatrixLocation;  // = -1;
-  GLint timeLocation;       // = -1;
+  GLint startTimeLocation;  // = -1;
   GLint texSamplerLocation; // = -1;
 } bannerShaderProgram;
 
@@ -69,63 +168,32 @@ struct SkyboxFarPlaneShaderProgram {
   GLint skyboxSamplerLocation;    // = -1;
 } skyboxFarPlaneShaderProgram;
 
-//**************************************************************************************************
-/// Makes a given location to be valid position inside a scene.
-/**
- Checks whether a given location \a position is valid position inside a scene.
- Valid position coordinates are always in range -(SCENE_WIDTH+objectSize)...SCENE_WIDTH+objectSize,
- -(SCENE_HEIGHT+objectSize)...SCENE_HEIGHT+objectSize, and -(SCENE_DEPTH+objectSize)...SCENE_DEPTH+objectSize.
- \param[in]  position       Position (object center) to be checked and corrected.
- \param[in]  objectSize     Size of the object which position is tested.
- \return                    Valid position inside a scene.
-*/
-glm::vec3 checkBounds(const glm::vec3 &position, float objectSize) {
- glm::vec3 newPosition = position;
-
-// ======== BEGIN OF SOLUTION - TASK 6_1-1 ======== //
-  // wrap a given position (object center) to be inside a scene
-  // you have to take into account the objectSize parameter
- if (position.x < -(SCENE_WIDTH + objectSize))
-     newPosition.x += 2.0f * (SCENE_WIDTH + objectSize);
- if (position.x > (SCENE_WIDTH + objectSize))
-     newPosition.x -= 2.0f * (SCENE_WIDTH + objectSize);
- if (position.y < -(SCENE_HEIGHT + objectSize))
-     newPosition.y += 2.0f * (SCENE_HEIGHT + objectSize);
- if (position.y > (SCENE_HEIGHT + objectSize))
-     newPosition.y -= 2.0f * (SCENE_HEIGHT + objectSize);
- if (position.z < -(SCENE_DEPTH + objectSize))
-     newPosition.z += 2.0f * (SCENE_DEPTH + objectSize);
- if (position.z > (SCENE_DEPTH + objectSize))
-     newPosition.z -= 2.0f * (SCENE_DEPTH + objectSize);
-// ========  END OF SOLUTION - TASK 6_1-1  ======== //
-   if( abs(newPosition.x) > (SCENE_WIDTH+objectSize) || abs(newPosition.y) > (SCENE_HEIGHT+objectSize) ) {
-     printf("Coordinates out of the window, [x, y, z] = [%f, %f, %f]\n", newPosition.x, newPosition.y, newPosition.z);
-   }
-     return newPosition;
-}
-
-void setTransformUniforms(const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix) {
-
-  glm::mat4 PVM = projectionMatrix * viewMatrix * modelMatrix;
-  glUniformMatrix4fv(shaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVM));
-
-  glUniformMatrix4fv(shaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-  glUniformMatrix4fv(shaderProgram.MmatrixLocation, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-  // just take 3x3 rotation part of the modelMatrix
-  // we presume the last row contains 0,0,0,1
+// just take 3x3 rotation part of the modelMatrix
+// we presume the last row contains 0,0,0,1
+static glm::mat4 normalTransform(const glm::mat4 &modelMatrix) {
+
   const glm::mat4 modelRotationMatrix = glm::mat4(
     modelMatrix[0],
     modelMatrix[1],
     modelMatrix[2],
     glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
   );
-  glm::mat4 normalMatrix = glm::transpose(glm::inverse(modelRotationMatrix));
 
   //or an alternative single-line method: 
   //glm::mat4 normalMatrix = glm::transpose(glm::inverse(glm::mat4(glm::mat3(modelRotationMatrix))));
 
-  glUniformMatrix4fv(shaderProgram.normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMatrix));  // correct matrix for non-rigid transform
+  return glm::transpose(glm::inverse(modelRotationMatrix));  // correct matrix for non-rigid transform
+}
+
+// view and projection are taken from the FrameData block, only the model data are uploaded per object
+void setTransformUniforms(const RenderPacket &packet) {
+
+  // the simple color shader has no FrameData block
+  if(shaderProgram.PVMmatrixLocation != -1)
+    glUniformMatrix4fv(shaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(packet.PVMmatrix));
+
+  glUniformMatrix4fv(shaderProgram.MmatrixLocation, 1, GL_FALSE, glm::value_ptr(packet.modelMatrix));
+  glUniformMatrix4fv(shaderProgram.normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(packet.normalMatrix));
 }
 
 void setMaterialUniforms(const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular, float shininess, GLuint texture) {
@@ -135,28 +203,113 @@ void setMaterialUniforms(const glm::vec3 &ambient, const glm::vec3 &diffuse, con
   glUniform3fv(shaderProgram.specularLocation, 1, glm::value_ptr(specular));
   glUniform1f(shaderProgram.shininessLocation,    shininess);
 
+  // the texture itself is bound to texturing unit 0 by the render queue
   if(texture != 0) {
     glUniform1i(shaderProgram.useTextureLocation, 1);  // do texture sampling
     glUniform1i(shaderProgram.texSamplerLocation, 0);  // texturing unit 0 -> samplerID   [for the GPU linker]
-    glActiveTexture(GL_TEXTURE0 + 0);                  // texturing unit 0 -> to be bound [for OpenGL BindTexture]
-    glBindTexture(GL_TEXTURE_2D, texture);
   }
   else {
     glUniform1i(shaderProgram.useTextureLocation, 0);  // do not sample the texture
   }
 }
 
-void drawSpaceShip(SpaceShipObject *spaceShip, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
+// modeling transforms of the objects, shared by the per-object and the instanced drawing
 
-  glUseProgram(shaderProgram.program);
+static glm::mat4 asteroidModelMatrix(const AsteroidPool &asteroids, unsigned int index) {
+  float angle = asteroids.rotationSpeed[index] * (asteroids.currentTime[index]-asteroids.startTime[index]); // angle in radians
 
-  // prepare modeling transform matrix
-  glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), spaceShip->position);
-  modelMatrix = glm::rotate(modelMatrix, glm::radians(spaceShip->viewAngle), glm::vec3(0, 0, 1));
-  modelMatrix = glm::scale(modelMatrix, glm::vec3(spaceShip->size, spaceShip->size, spaceShip->size));
+  glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), asteroids.position[index]);
+  modelMatrix = glm::scale(modelMatrix, glm::vec3(asteroids.size[index]));
+  modelMatrix = glm::rotate(modelMatrix, angle, glm::vec3(0, 0, 1));
+
+  return modelMatrix;
+}
+
+static glm::mat4 missileModelMatrix(const MissilePool &missiles, unsigned int index) {
+
+  // align missile coordinate system to match its position and direction - see alignObject() function
+  glm::mat4 modelMatrix = alignObject(missiles.position[index], missiles.direction[index], glm::vec3(0.0f, 0.0f, 1.0f));
+  modelMatrix = glm::scale(modelMatrix, glm::vec3(missiles.size[index]));
+
+  // angular speed = 2*pi*frequency => path = angular speed * time
+  const float frequency = 2.0f; // per second
+  const float angle = 2.0f*M_PI * frequency * (missiles.currentTime[index]-missiles.startTime[index]); // angle in radians
+  modelMatrix = glm::rotate(modelMatrix, angle, glm::vec3(0.0f, 0.0f, 1.0f));
+
+  return modelMatrix;
+}
+
+static glm::mat4 ufoModelMatrix(const UfoPool &ufos, unsigned int index) {
+
+  // align ufo coordinate system to match its position and direction - see alignObject() function
+  glm::mat4 modelMatrix = alignObject(ufos.position[index], ufos.direction[index], glm::vec3(0.0f, 0.0f, 1.0f));
+  modelMatrix = glm::scale(modelMatrix, glm::vec3(ufos.size[index]));
+
+  return modelMatrix;
+}
+
+// blinking of the ufo top, 1 = yellow part fully lit, 0 = magenta part fully lit
+static float ufoBlinkFactor(const UfoPool &ufos, unsigned int index) {
+
+  // angular speed = 2*pi*frequency => path = angular speed * time
+  const float frequency = 0.33f; // per second
+  float angle = 6.28f * frequency * (ufos.currentTime[index]-ufos.startTime[index]); // angle in radians
+  return 0.5f*(cos(angle) + 1.0f);
+}
+
+// level of detail of the space ship drawn in the last frame, see selectMeshLods()
+static unsigned int spaceShipLod = 0;
+
+// offset of the first index of the level of detail in the element buffer
+static const void* lodIndexOffset(const MeshGeometry *geometry, unsigned int lod) {
+
+  const size_t indexSize = (geometry->indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+  return (const void*)(geometry->lodFirstIndex[lod] * indexSize);
+}
+
+// draws one level of detail of a mesh loaded by loadSingleMesh()
+static void drawMeshLod(const MeshGeometry *geometry, unsigned int lod, GLsizei instanceCount) {
+
+  const GLsizei indexCount = 3 * geometry->lodTriangleCount[lod];
+
+  if(instanceCount == 1)
+    glDrawElements(GL_TRIANGLES, indexCount, geometry->indexType, lodIndexOffset(geometry, lod));
+  else
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, geometry->indexType, lodIndexOffset(geometry, lod), instanceCount);
+}
+
+unsigned int selectMeshLods(AsteroidPool &asteroids, const SpaceShipObject *spaceShip, const VisibleObjects &visible, int viewportHeight) {
+
+  const FrameUniforms &frame = frameUniformBuffer.data;
+  unsigned int triangles = 0;
+
+  // resident asteroids are drawn at the full level of detail, see drawMotionObjects()
+  if(asteroidGeometry != NULL && useGpuMotion == true) {
+    triangles += motionObjectCount(asteroids) * asteroidGeometry->lodTriangleCount[0];
+  }
+  // bounding sphere of the unit sized model has the radius of the culling sphere
+  else if(asteroidGeometry != NULL) {
+    for(size_t v = 0; v < visible.asteroids.size(); v++) {
+      const unsigned int i = visible.asteroids[v];
+      const float radius = projectedRadius(frame.Pmatrix, frame.PVmatrix, viewportHeight, asteroids.position[i], CULLING_RADIUS_SCALE * asteroids.size[i]);
+      asteroids.lod[i] = (unsigned char)selectMeshLod(radius, asteroids.lod[i], asteroidGeometry->lodCount);
+      triangles += asteroidGeometry->lodTriangleCount[asteroids.lod[i]];
+    }
+  }
+
+  if(spaceShipGeometry != NULL) {
+    const float radius = projectedRadius(frame.Pmatrix, frame.PVmatrix, viewportHeight, spaceShip->position, CULLING_RADIUS_SCALE * spaceShip->size);
+    spaceShipLod = selectMeshLod(radius, spaceShipLod, spaceShipGeometry->lodCount);
+    triangles += spaceShipGeometry->lodTriangleCount[spaceShipLod];
+  }
+
+  return triangles;
+}
+
+static void executeSpaceShip(const RenderPacket &packet) {
 
   // send matrices to the vertex & fragment shader
-  setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+  setTransformUniforms(packet);
 
   setMaterialUniforms(
     spaceShipGeometry->ambient,
@@ -167,26 +320,13 @@ void drawSpaceShip(SpaceShipObject *spaceShip, const glm::mat4 & viewMatrix, con
   );
 
   // draw geometry
-  glBindVertexArray(spaceShipGeometry->vertexArrayObject);
-  glDrawElements(GL_TRIANGLES, spaceShipGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
-
-  glBindVertexArray(0);
-  glUseProgram(0);
-
-  return;
+  drawMeshLod(spaceShipGeometry, packet.lod, 1);
 }
 
-void drawAsteroid(AsteroidObject* asteroid, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
-  float angle = asteroid->rotationSpeed * (asteroid->currentTime-asteroid->startTime); // angle in radians
-
-  glUseProgram(shaderProgram.program);
-
-  glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), asteroid->position);
-  modelMatrix = glm::scale(modelMatrix, glm::vec3(asteroid->size));
-  modelMatrix = glm::rotate(modelMatrix, angle, glm::vec3(0, 0, 1));
+static void executeAsteroid(const RenderPacket &packet) {
 
   // send matrices to the vertex & fragment shader
-  setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+  setTransformUniforms(packet);
 
   setMaterialUniforms(
     asteroidGeometry->ambient,
@@ -197,30 +337,13 @@ void drawAsteroid(AsteroidObject* asteroid, const glm::mat4 & viewMatrix, const
   );
 
   // draw geometry
-  glBindVertexArray(asteroidGeometry->vertexArrayObject);
-  glDrawElements(GL_TRIANGLES, asteroidGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
-
-  glBindVertexArray(0);
-  glUseProgram(0);
-
-  return;
+  drawMeshLod(asteroidGeometry, packet.lod, 1);
 }
 
-void drawMissile(MissileObject* missile, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
-  
-  glUseProgram(shaderProgram.program);
-
-  // align missile coordinate system to match its position and direction - see alignObject() function
-  glm::mat4 modelMatrix = alignObject(missile->position, missile->direction, glm::vec3(0.0f, 0.0f, 1.0f));
-  modelMatrix = glm::scale(modelMatrix, glm::vec3(missile->size));
-
-  // angular speed = 2*pi*frequency => path = angular speed * time
-  const float frequency = 2.0f; // per second
-  const float angle = 2.0f*M_PI * frequency * (missile->currentTime-missile->startTime); // angle in radians
-  modelMatrix = glm::rotate(modelMatrix, angle, glm::vec3(0.0f, 0.0f, 1.0f));
+static void executeMissile(const RenderPacket &packet) {
 
   // send matrices to the vertex & fragment shader
-  setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+  setTransformUniforms(packet);
 
   setMaterialUniforms(
     missileGeometry->ambient,
@@ -230,30 +353,15 @@ void drawMissile(MissileObject* missile, const glm::mat4 & viewMatrix, const glm
     missileGeometry->texture
   );
   // draw the missile using glDrawArrays 
-  glBindVertexArray(missileGeometry->vertexArrayObject);
   glDrawArrays(GL_TRIANGLES, 0, missileGeometry->numTriangles*3);
-
-  glBindVertexArray(0);
-  glUseProgram(0);
-
-  return;
 }
 
-void drawUfo(UfoObject* ufo, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
-
-  glUseProgram(shaderProgram.program);
-
-  // align ufo coordinate system to match its position and direction - see alignObject() function
-  glm::mat4 modelMatrix = alignObject(ufo->position, ufo->direction, glm::vec3(0.0f, 0.0f, 1.0f));
-  modelMatrix = glm::scale(modelMatrix, glm::vec3(ufo->size));
+static void executeUfo(const RenderPacket &packet) {
 
   // send matrices to the vertex & fragment shader
-  setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+  setTransformUniforms(packet);
 
-  // angular speed = 2*pi*frequency => path = angular speed * time
-  const float frequency = 0.33f; // per second
-  float angle = 6.28f * frequency * (ufo->currentTime-ufo->startTime); // angle in radians
-  float scaleFactor = 0.5f*(cos(angle) + 1.0f);
+  float scaleFactor = packet.parameters[0].x;
   glm::vec3 yellowMat = glm::vec3(scaleFactor, scaleFactor, 0.0f);
 
   setMaterialUniforms(
@@ -268,7 +376,6 @@ void drawUfo(UfoObject* ufo, const glm::mat4 & viewMatrix, const glm::mat4 & pro
   // glEnable(GL_CULL_FACE);
   // glCullFace(GL_FRONT);
   // draw the first three (yellow) triangles of ufo top using glDrawArrays 
-  glBindVertexArray(ufoGeometry->vertexArrayObject);
   glDrawArrays(GL_TRIANGLES, 0, 3*ufoGeometry->numTriangles/2);
   CHECK_GL_ERROR();
 
@@ -284,7 +391,6 @@ void drawUfo(UfoObject* ufo, const glm::mat4 & viewMatrix, const glm::mat4 & pro
   // glEnable(GL_CULL_FACE);
   // glCullFace(GL_BACK);
   // draw the second three (magenta) triangles of ufo top using glDrawArrays 
-  glBindVertexArray(ufoGeometry->vertexArrayObject);
   glDrawArrays(GL_TRIANGLES, 3*ufoGeometry->numTriangles/2, 3*ufoGeometry->numTriangles/2);
   CHECK_GL_ERROR();
 
@@ -297,54 +403,453 @@ void drawUfo(UfoObject* ufo, const glm::mat4 & viewMatrix, const glm::mat4 & pro
   );
 
   // draw the six triangles of ufo bottom using glDrawElements 
-  glDrawElements(GL_TRIANGLES, ufoGeometry->numTriangles*3, GL_UNSIGNED_INT, 0);
+  glDrawElements(GL_TRIANGLES, ufoGeometry->numTriangles*3, ufoGeometry->indexType, 0);
   // glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
   CHECK_GL_ERROR();
+}
+
+// distance of the object from the camera of the frame, sorts the opaque packets front to back
+static float viewDepth(const glm::vec3 &position) {
+
+  return -(frameUniformBuffer.data.Vmatrix * glm::vec4(position, 1.0f)).z;
+}
+
+// fills the state and transforms of one object drawn by the common shader program
+static void recordCommonObject(const MeshGeometry *geometry, RenderCallback draw, const glm::mat4 &modelMatrix, RenderPacket &packet) {
+
+  packet.program = shaderProgram.program;
+  packet.vertexArrayObject = geometry->vertexArrayObject;
+  packet.texture = geometry->texture;
+  packet.draw = draw;
+
+  packet.PVMmatrix = frameUniformBuffer.data.PVmatrix * modelMatrix;
+  packet.modelMatrix = modelMatrix;
+  packet.normalMatrix = normalTransform(modelMatrix);
+  packet.lod = 0;
+}
+
+// record functions of the pools - called by the worker threads, they must not call OpenGL
+
+static void recordAsteroid(const AsteroidPool &asteroids, unsigned int index, RenderPacket &packet) {
+
+  recordCommonObject(asteroidGeometry, executeAsteroid, asteroidModelMatrix(asteroids, index), packet);
+  packet.lod = asteroids.lod[index];
+}
+
+static void recordMissile(const MissilePool &missiles, unsigned int index, RenderPacket &packet) {
+
+  recordCommonObject(missileGeometry, executeMissile, missileModelMatrix(missiles, index), packet);
+}
+
+static void recordUfo(const UfoPool &ufos, unsigned int index, RenderPacket &packet) {
+
+  recordCommonObject(ufoGeometry, executeUfo, ufoModelMatrix(ufos, index), packet);
+  packet.parameters[0] = glm::vec4(ufoBlinkFactor(ufos, index), 0.0f, 0.0f, 0.0f);
+}
+
+// records the packets of the listed objects in parallel, each thread fills its own range of the queue
+template <class Pool>
+static void recordPackets(RenderPass pass, const Pool &pool, const unsigned int *indices, unsigned int count,
+                          void (*record)(const Pool &pool, unsigned int index, RenderPacket &packet)) {
+
+  if(count == 0)
+    return;
+
+  beginProfile(PROFILE_DRAW_RECORD);
+  const unsigned int first = reservePackets(count);
+
+  parallelFor(count, RECORD_GRAIN_SIZE, [&pool, indices, first, pass, record](unsigned int begin, unsigned int end) {
+    RenderPacket packet;
+    for(unsigned int i = begin; i < end; i++) {
+      const unsigned int index = indices[i];
+      record(pool, index, packet);
+      recordPacket(first + i, pass, viewDepth(pool.position[index]), packet);
+    }
+  });
+  endProfile(PROFILE_DRAW_RECORD);
+}
+
+void drawSpaceShip(SpaceShipObject *spaceShip) {
+
+  // prepare modeling transform matrix
+  glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), spaceShip->position);
+  modelMatrix = glm::rotate(modelMatrix, glm::radians(spaceShip->viewAngle), glm::vec3(0, 0, 1));
+  modelMatrix = glm::scale(modelMatrix, glm::vec3(spaceShip->size, spaceShip->size, spaceShip->size));
+
+  RenderPacket packet;
+  recordCommonObject(spaceShipGeometry, executeSpaceShip, modelMatrix, packet);
+  packet.lod = spaceShipLod;
+
+  submitPacket(RENDER_PASS_OPAQUE, viewDepth(spaceShip->position), packet);
+}
+
+void drawAsteroids(const AsteroidPool &asteroids, const unsigned int *indices, unsigned int count) {
+
+  recordPackets(RENDER_PASS_OPAQUE, asteroids, indices, count, recordAsteroid);
+}
+
+void drawMissiles(const MissilePool &missiles, const unsigned int *indices, unsigned int count) {
+
+  recordPackets(RENDER_PASS_OPAQUE, missiles, indices, count, recordMissile);
+}
+
+void drawUfos(const UfoPool &ufos, const unsigned int *indices, unsigned int count) {
+
+  recordPackets(RENDER_PASS_OPAQUE, ufos, indices, count, recordUfo);
+}
+
+// writes the INSTANCE_TEXELS texels of one instance to the CPU copy of the instance buffer
+static void writeInstance(glm::vec4 *texels, const glm::mat4 &modelMatrix, float scale, const glm::vec4 &tints) {
+
+  // the model matrix is a rotation with uniform scale -> its inverse transpose is the
+  // same matrix divided by the squared scale, no inversion is needed
+  const glm::mat3 normalMatrix = glm::mat3(modelMatrix) * (1.0f / (scale * scale));
+
+  texels[0] = modelMatrix[0];
+  texels[1] = modelMatrix[1];
+  texels[2] = modelMatrix[2];
+  texels[3] = modelMatrix[3];
+  texels[4] = glm::vec4(normalMatrix[0], 0.0f);
+  texels[5] = glm::vec4(normalMatrix[1], 0.0f);
+  texels[6] = glm::vec4(normalMatrix[2], 0.0f);
+  texels[7] = tints;
+}
+
+static void setInstancedMaterialUniforms(const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular, float shininess, GLuint texture) {
+
+  glUniform3fv(instancedShaderProgram.diffuseLocation,  1, glm::value_ptr(diffuse));
+  glUniform3fv(instancedShaderProgram.ambientLocation,  1, glm::value_ptr(ambient));
+  glUniform3fv(instancedShaderProgram.specularLocation, 1, glm::value_ptr(specular));
+  glUniform1f(instancedShaderProgram.shininessLocation,    shininess);
+
+  if(texture != 0) {
+    glUniform1i(instancedShaderProgram.useTextureLocation, 1);
+    glActiveTexture(GL_TEXTURE0 + 0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+  }
+  else {
+    glUniform1i(instancedShaderProgram.useTextureLocation, 0);
+  }
+}
+
+void setFrameUniforms(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, float time, const glm::vec3 &reflectorPosition, const glm::vec3 &reflectorDirection,
+                      const glm::vec4 &clusterScale, bool logarithmicSlices) {
+
+  FrameUniforms &frame = frameUniformBuffer.data;
+
+  frame.Vmatrix = viewMatrix;
+  frame.Pmatrix = projectionMatrix;
+  frame.PVmatrix = projectionMatrix * viewMatrix;
+
+  // lights are transformed to eye space here instead of in every vertex
+  const float sunSpeed = 0.5f;
+  frame.sunDirection = viewMatrix * glm::vec4(cos(time * sunSpeed), 0.0f, sin(time * sunSpeed), 0.0f);
+  frame.reflectorPosition = viewMatrix * glm::vec4(reflectorPosition, 1.0f);
+  frame.reflectorDirection = glm::vec4(glm::normalize(glm::vec3(viewMatrix * glm::vec4(reflectorDirection, 0.0f))), 0.0f);
+
+  frame.clusterScale = clusterScale;
+  frame.clusterLogDepth = logarithmicSlices ? 1.0f : 0.0f;
+
+  frame.time = time;
+
+  // orphan the previous buffer storage -> no waiting for draw calls of the last frame
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer.bufferObject);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &frame, GL_STREAM_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+// three draws of the ufo parts with their own tints, the instance data are already bound
+static void drawUfoInstances(unsigned int ufoCount) {
+
+  glBindVertexArray(ufoGeometry->vertexArrayObject);
+
+  // yellow triangles of ufo top, scaled by the blink factor
+  const glm::vec3 yellowMat = glm::vec3(1.0f, 1.0f, 0.0f);
+  setInstancedMaterialUniforms(yellowMat, yellowMat, yellowMat, ufoGeometry->shininess, ufoGeometry->texture);
+  glUniform1i(instancedShaderProgram.instanceTintLocation, INSTANCE_TINT_BLINK);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 3*ufoGeometry->numTriangles/2, ufoCount);
+
+  // magenta triangles of ufo top, scaled by the inverse blink factor
+  setInstancedMaterialUniforms(
+    ufoGeometry->ambient,
+    ufoGeometry->diffuse,
+    ufoGeometry->specular,
+    ufoGeometry->shininess,
+    ufoGeometry->texture
+  );
+  glUniform1i(instancedShaderProgram.instanceTintLocation, INSTANCE_TINT_BLINK_INVERSE);
+  glDrawArraysInstanced(GL_TRIANGLES, 3*ufoGeometry->numTriangles/2, 3*ufoGeometry->numTriangles/2, ufoCount);
+
+  // ufo bottom
+  glUniform1i(instancedShaderProgram.instanceTintLocation, INSTANCE_TINT_NONE);
+  glDrawElementsInstanced(GL_TRIANGLES, ufoGeometry->numTriangles*3, ufoGeometry->indexType, 0, ufoCount);
+}
+
+// asteroids and ufos with GPU resident motion, all of them at the full level of detail - records are not culled
+static void drawMotionObjects(const AsteroidPool &asteroids, const UfoPool &ufos) {
+
+  const unsigned int asteroidCount = motionObjectCount(asteroids);
+  const unsigned int ufoCount = motionObjectCount(ufos);
+  if(asteroidCount + ufoCount == 0)
+    return;
+
+  glUseProgram(instancedShaderProgram.program);
+
+  glUniform1i(instancedShaderProgram.texSamplerLocation, 0);
+  glUniform1i(instancedShaderProgram.instanceDataLocation, 1);
+  glUniform1i(instancedShaderProgram.instanceBaseLocation, 0);
+  glUniform4fv(instancedShaderProgram.ufoCurveShapeLocation, 1, glm::value_ptr(gpuMotion.curveShape));
+  glUniform1i(instancedShaderProgram.instanceTintLocation, INSTANCE_TINT_NONE);
+
+  if(asteroidCount > 0) {
+    glActiveTexture(GL_TEXTURE0 + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, gpuMotion.asteroids.texture);
+    glActiveTexture(GL_TEXTURE0 + 0);
+    glUniform1i(instancedShaderProgram.instanceMotionLocation, INSTANCE_MOTION_LINE);
+
+    setInstancedMaterialUniforms(
+      asteroidGeometry->ambient,
+      asteroidGeometry->diffuse,
+      asteroidGeometry->specular,
+      asteroidGeometry->shininess,
+      asteroidGeometry->texture
+    );
+
+    glBindVertexArray(asteroidGeometry->vertexArrayObject);
+    drawMeshLod(asteroidGeometry, 0, asteroidCount);
+  }
+
+  if(ufoCount > 0) {
+    glActiveTexture(GL_TEXTURE0 + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, gpuMotion.ufos.texture);
+    glActiveTexture(GL_TEXTURE0 + 0);
+    glUniform1i(instancedShaderProgram.instanceMotionLocation, INSTANCE_MOTION_CURVE);
+
+    drawUfoInstances(ufoCount);
+  }
+
+  glUniform1i(instancedShaderProgram.instanceMotionLocation, INSTANCE_MOTION_NONE);
+  CHECK_GL_ERROR();
 
   glBindVertexArray(0);
   glUseProgram(0);
+}
 
-  return;
+void drawInstancedObjects(const AsteroidPool &asteroids, const MissilePool &missiles, const UfoPool &ufos, const VisibleObjects &visible) {
+
+  // asteroids and ufos with GPU resident motion do not go through the instance buffer
+  const unsigned int visibleAsteroids = useGpuMotion ? 0 : (unsigned int)visible.asteroids.size();
+  const unsigned int visibleUfos      = useGpuMotion ? 0 : (unsigned int)visible.ufos.size();
+
+  // objects exceeding the capacity of the instance buffer are drawn one by one
+  const unsigned int asteroidCount = std::min(visibleAsteroids, instanceBuffer.maxInstances);
+  const unsigned int missileCount  = std::min((unsigned int)visible.missiles.size(), instanceBuffer.maxInstances - asteroidCount);
+  const unsigned int ufoCount      = std::min(visibleUfos, instanceBuffer.maxInstances - asteroidCount - missileCount);
+
+  beginProfile(PROFILE_DRAW_RECORD);
+
+  // asteroids are grouped by their level of detail, one draw call per level
+  unsigned int asteroidLodInstances[MESH_LODS_MAX] = { 0 };
+  for(unsigned int v = 0; v < asteroidCount; v++)
+    asteroidLodInstances[asteroids.lod[visible.asteroids[v]]]++;
+
+  unsigned int asteroidLodBase[MESH_LODS_MAX];
+  unsigned int instanceBase = 0;
+  for(unsigned int lod = 0; lod < MESH_LODS_MAX; lod++) {
+    asteroidLodBase[lod] = instanceBase;
+    instanceBase += asteroidLodInstances[lod];
+  }
+
+  instanceBuffer.asteroidOrder.resize(asteroidCount);
+  for(unsigned int v = 0; v < asteroidCount; v++) {
+    const unsigned int i = visible.asteroids[v];
+    instanceBuffer.asteroidOrder[asteroidLodBase[asteroids.lod[i]]++] = i;
+  }
+
+  const unsigned int instanceCount = asteroidCount + missileCount + ufoCount;
+
+  // fill instance data of the visible objects: asteroids first, then missiles and ufos,
+  // the position of each instance is known -> the threads write their ranges of instances at once
+  instanceBuffer.texels.resize(instanceCount * INSTANCE_TEXELS);
+
+  glm::vec4 *texels = (instanceCount > 0) ? &instanceBuffer.texels[0] : NULL;
+  const unsigned int *asteroidOrder = (asteroidCount > 0) ? &instanceBuffer.asteroidOrder[0] : NULL;
+
+  parallelFor(instanceCount, RECORD_GRAIN_SIZE, [&, texels, asteroidOrder](unsigned int begin, unsigned int end) {
+    const glm::vec4 noTint = glm::vec4(1.0f);
+
+    for(unsigned int n = begin; n < end; n++) {
+      glm::vec4 *instance = texels + n * INSTANCE_TEXELS;
+
+      if(n < asteroidCount) {
+        const unsigned int i = asteroidOrder[n];
+        writeInstance(instance, asteroidModelMatrix(asteroids, i), asteroids.size[i], noTint);
+      }
+      else if(n < asteroidCount + missileCount) {
+        const unsigned int i = visible.missiles[n - asteroidCount];
+        writeInstance(instance, missileModelMatrix(missiles, i), missiles.size[i], noTint);
+      }
+      else {
+        const unsigned int i = visible.ufos[n - asteroidCount - missileCount];
+        const float blink = ufoBlinkFactor(ufos, i);
+        writeInstance(instance, ufoModelMatrix(ufos, i), ufos.size[i], glm::vec4(blink, 1.0f - blink, 1.0f, 1.0f));
+      }
+    }
+  });
+
+  endProfile(PROFILE_DRAW_RECORD);
+
+  if(instanceCount > 0) {
+
+    // buffer grows geometrically, it never shrinks
+    if(instanceCount > instanceBuffer.allocated)
+      instanceBuffer.allocated = std::min(std::max(instanceCount, 2 * instanceBuffer.allocated), instanceBuffer.maxInstances);
+
+    // orphan the previous buffer storage -> no waiting for draw calls of the last frame
+    glBindBuffer(GL_TEXTURE_BUFFER, instanceBuffer.bufferObject);
+    glBufferData(GL_TEXTURE_BUFFER, instanceBuffer.allocated * INSTANCE_TEXELS * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, instanceBuffer.texels.size() * sizeof(glm::vec4), &instanceBuffer.texels[0]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glUseProgram(instancedShaderProgram.program);
+
+    // texturing unit 0 is used by the material textures, instance data are read from unit 1
+    glUniform1i(instancedShaderProgram.texSamplerLocation, 0);
+    glUniform1i(instancedShaderProgram.instanceDataLocation, 1);
+    glActiveTexture(GL_TEXTURE0 + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, instanceBuffer.texture);
+    glActiveTexture(GL_TEXTURE0 + 0);
+
+    glUniform1i(instancedShaderProgram.instanceTintLocation, INSTANCE_TINT_NONE);
+    glUniform1i(instancedShaderProgram.instanceMotionLocation, INSTANCE_MOTION_NONE);
+
+    if(asteroidCount > 0) {
+      setInstancedMaterialUniforms(
+        asteroidGeometry->ambient,
+        asteroidGeometry->diffuse,
+        asteroidGeometry->specular,
+        asteroidGeometry->shininess,
+        asteroidGeometry->texture
+      );
+
+      glBindVertexArray(asteroidGeometry->vertexArrayObject);
+
+      instanceBase = 0;
+      for(unsigned int lod = 0; lod < asteroidGeometry->lodCount; lod++) {
+        if(asteroidLodInstances[lod] == 0)
+          continue;
+        glUniform1i(instancedShaderProgram.instanceBaseLocation, instanceBase);
+        drawMeshLod(asteroidGeometry, lod, asteroidLodInstances[lod]);
+        instanceBase += asteroidLodInstances[lod];
+      }
+    }
+
+    if(missileCount > 0) {
+      glUniform1i(instancedShaderProgram.instanceBaseLocation, asteroidCount);
+      setInstancedMaterialUniforms(
+        missileGeometry->ambient,
+        missileGeometry->diffuse,
+        missileGeometry->specular,
+        missileGeometry->shininess,
+        missileGeometry->texture
+      );
+
+      glBindVertexArray(missileGeometry->vertexArrayObject);
+      glDrawArraysInstanced(GL_TRIANGLES, 0, missileGeometry->numTriangles*3, missileCount);
+    }
+
+    if(ufoCount > 0) {
+      glUniform1i(instancedShaderProgram.instanceBaseLocation, asteroidCount + missileCount);
+      drawUfoInstances(ufoCount);
+    }
+    CHECK_GL_ERROR();
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+  }
+
+  if(useGpuMotion == true)
+    drawMotionObjects(asteroids, ufos);
+
+  // fallback for visible objects that did not fit into the instance buffer
+  if(asteroidCount < visibleAsteroids)
+    drawAsteroids(asteroids, &visible.asteroids[asteroidCount], visibleAsteroids - asteroidCount);
+  if(missileCount < visible.missiles.size())
+    drawMissiles(missiles, &visible.missiles[missileCount], (unsigned int)visible.missiles.size() - missileCount);
+  if(ufoCount < visibleUfos)
+    drawUfos(ufos, &visible.ufos[ufoCount], visibleUfos - ufoCount);
 }
 
-void drawExplosion(ExplosionObject* explosion, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
-    
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_ONE, GL_ONE);
+void drawAsteroidIds(const AsteroidPool &asteroids) {
 
-  glUseProgram(explosionShaderProgram.program);
+  // asteroids exceeding the buffer texture size cannot be picked
+  const unsigned int count = std::min(objectCount(asteroids), pickIdBuffer.maxInstances);
+  if(count == 0)
+    return;
 
- // just take 3x3 rotation part of the view transform
-  glm::mat4 billboardRotationMatrix = glm::mat4(
-    viewMatrix[0],
-    viewMatrix[1],
-    viewMatrix[2],
-    glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
-  );
-  // inverse view rotation
-  billboardRotationMatrix = glm::transpose(billboardRotationMatrix);
+  pickIdBuffer.transforms.clear();
+  pickIdBuffer.transforms.reserve(count * 4);
 
-  glm::mat4 matrix = glm::translate(glm::mat4(1.0f), explosion->position);
-  matrix = glm::scale(matrix, glm::vec3(explosion->size));
-  matrix = matrix*billboardRotationMatrix; // make billboard to face the camera
+  for(unsigned int i = 0; i < count; i++) {
+    const glm::mat4 modelMatrix = asteroidModelMatrix(asteroids, i);
+    pickIdBuffer.transforms.push_back(modelMatrix[0]);
+    pickIdBuffer.transforms.push_back(modelMatrix[1]);
+    pickIdBuffer.transforms.push_back(modelMatrix[2]);
+    pickIdBuffer.transforms.push_back(modelMatrix[3]);
+  }
 
-  glm::mat4 PVMmatrix = projectionMatrix * viewMatrix * matrix;
-  glUniformMatrix4fv(explosionShaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVMmatrix));  // model-view-projection
-  glUniformMatrix4fv(explosionShaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));   // view
-  glUniform1f(explosionShaderProgram.timeLocation, explosion->currentTime - explosion->startTime);
-  glUniform1i(explosionShaderProgram.texSamplerLocation, 0);
-  glUniform1f(explosionShaderProgram.frameDurationLocation, explosion->frameDuration);
+  // handles of the dense pool are uploaded as they are
+  glBindBuffer(GL_TEXTURE_BUFFER, pickIdBuffer.transformBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, count * 4 * sizeof(glm::vec4), &pickIdBuffer.transforms[0], GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, pickIdBuffer.handleBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, count * sizeof(ObjectHandle), &asteroids.handle[0], GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
-  glBindVertexArray(explosionGeometry->vertexArrayObject);
-  glBindTexture(GL_TEXTURE_2D, explosionGeometry->texture);
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, explosionGeometry->numTriangles);
+  glUseProgram(pickIdShaderProgram.program);
+
+  glUniform1i(pickIdShaderProgram.transformsLocation, 0);
+  glUniform1i(pickIdShaderProgram.handlesLocation, 1);
+  glActiveTexture(GL_TEXTURE0 + 1);
+  glBindTexture(GL_TEXTURE_BUFFER, pickIdBuffer.handleTexture);
+  glActiveTexture(GL_TEXTURE0 + 0);
+  glBindTexture(GL_TEXTURE_BUFFER, pickIdBuffer.transformTexture);
+
+  // full level of detail - the pass is drawn only for a click and the pixel under the cursor has to be exact
+  glBindVertexArray(asteroidGeometry->vertexArrayObject);
+  drawMeshLod(asteroidGeometry, 0, count);
+  CHECK_GL_ERROR();
 
   glBindVertexArray(0);
   glUseProgram(0);
+}
 
-  glDisable(GL_BLEND);
+static void executeExplosion(const RenderPacket &packet) {
 
-  return;
+  // billboard is made to face the camera in the vertex shader
+  glUniform4fv(explosionShaderProgram.billboardLocation, 1, glm::value_ptr(packet.parameters[0]));  // center and size
+  glUniform1f(explosionShaderProgram.startTimeLocation, packet.parameters[1].x);
+  glUniform1i(explosionShaderProgram.texSamplerLocation, 0);
+  glUniform1f(explosionShaderProgram.frameDurationLocation, packet.parameters[1].y);
+
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, explosionGeometry->numTriangles);
+}
+
+static void recordExplosion(const ExplosionPool &explosions, unsigned int index, RenderPacket &packet) {
+
+  packet.program = explosionShaderProgram.program;
+  packet.vertexArrayObject = explosionGeometry->vertexArrayObject;
+  packet.texture = explosionGeometry->texture;
+  packet.draw = executeExplosion;
+
+  packet.parameters[0] = glm::vec4(explosions.position[index], explosions.size[index]);
+  packet.parameters[1] = glm::vec4(explosions.startTime[index], explosions.frameDuration[index], 0.0f, 0.0f);
+  packet.lod = 0;
+}
+
+void drawExplosions(const ExplosionPool &explosions, const unsigned int *indices, unsigned int count) {
+
+  // additive blending of the effects pass is set once for all explosions
+  recordPackets(RENDER_PASS_EFFECTS, explosions, indices, count, recordExplosion);
 }
 
 void drawBanner(BannerObject* banner, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
@@ -361,7 +866,7 @@ void drawBanner(BannerObject* banner, const glm::mat4 & viewMatrix, const glm::m
 
   glm::mat4 PVMmatrix = projectionMatrix * viewMatrix * matrix;
   glUniformMatrix4fv(bannerShaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVMmatrix));        // model-view-projection
-  glUniform1f(bannerShaderProgram.timeLocation, banner->currentTime - banner->startTime);
+  glUniform1f(bannerShaderProgram.startTimeLocation, banner->startTime);
   glUniform1i(bannerShaderProgram.texSamplerLocation, 0);
 
   glBindTexture(GL_TEXTURE_2D, bannerGeometry->texture);
@@ -408,36 +913,65 @@ void drawSkybox(const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix
 void cleanupShaderPrograms(void) {
 
   pgr::deleteProgramAndShaders(shaderProgram.program);
+  if(instancedShaderProgram.program != 0)
+    pgr::deleteProgramAndShaders(instancedShaderProgram.program);
 
+  pgr::deleteProgramAndShaders(pickIdShaderProgram.program);
   pgr::deleteProgramAndShaders(explosionShaderProgram.program);
   pgr::deleteProgramAndShaders(bannerShaderProgram.program);
   pgr::deleteProgramAndShaders(skyboxFarPlaneShaderProgram.program);
+
+  glDeleteBuffers(1, &frameUniformBuffer.bufferObject);
+}
+
+// connects the FrameData block of the program to the frame uniform buffer
+static void bindFrameUniforms(GLuint program) {
+
+  const GLuint blockIndex = glGetUniformBlockIndex(program, "FrameData");
+  if(blockIndex != GL_INVALID_INDEX)
+    glUniformBlockBinding(program, blockIndex, FRAME_UNIFORMS_BINDING);
+}
+
+// point light buffers stay bound to their texturing units -> the samplers are set once
+static void bindPointLightSamplers(GLuint program) {
+
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "pointLights"), POINT_LIGHTS_TEXTURE_UNIT);
+  glUniform1i(glGetUniformLocation(program, "lightClusters"), LIGHT_CLUSTERS_TEXTURE_UNIT);
+  glUniform1i(glGetUniformLocation(program, "lightIndices"), LIGHT_INDICES_TEXTURE_UNIT);
+  glUseProgram(0);
 }
 
 void initializeShaderPrograms(void) {
 
-  std::vector<GLuint> shaderList;
+  // the buffer stays bound to its binding point, programs select it by bindFrameUniforms()
+  glGenBuffers(1, &frameUniformBuffer.bufferObject);
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer.bufferObject);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUniformBuffer.bufferObject);
+
+  // programs are loaded from their binary cache if the sources and the driver did not change
+  std::vector<ProgramShader> shaderList;
 
   if(useLighting == true) {
     // load and compile shader for lighting (lights & materials)
 
     // push vertex shader and fragment shader
-    shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "lightingPerVertex.vert"));
-    shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "lightingPerVertex.frag"));
+    shaderList.push_back(shaderFromFile(GL_VERTEX_SHADER, "lightingPerVertex.vert"));
+    shaderList.push_back(shaderFromFile(GL_FRAGMENT_SHADER, "lightingPerVertex.frag"));
 
     // create the shader program with two shaders
-    shaderProgram.program = pgr::createProgram(shaderList);
+    shaderProgram.program = createCachedProgram("lighting", shaderList);
 
     // get vertex attributes locations, if the shader does not have this uniform -> return -1
     shaderProgram.posLocation      = glGetAttribLocation(shaderProgram.program, "position");
     shaderProgram.normalLocation   = glGetAttribLocation(shaderProgram.program, "normal");
     shaderProgram.texCoordLocation = glGetAttribLocation(shaderProgram.program, "texCoord");
     // get uniforms locations
-    shaderProgram.PVMmatrixLocation    = glGetUniformLocation(shaderProgram.program, "PVMmatrix");
-    shaderProgram.VmatrixLocation      = glGetUniformLocation(shaderProgram.program, "Vmatrix");
+    shaderProgram.PVMmatrixLocation    = -1;  // taken from the FrameData block
     shaderProgram.MmatrixLocation      = glGetUniformLocation(shaderProgram.program, "Mmatrix");
     shaderProgram.normalMatrixLocation = glGetUniformLocation(shaderProgram.program, "normalMatrix");
-    shaderProgram.timeLocation         = glGetUniformLocation(shaderProgram.program, "time");
     // material
     shaderProgram.ambientLocation      = glGetUniformLocation(shaderProgram.program, "material.ambient");
     shaderProgram.diffuseLocation      = glGetUniformLocation(shaderProgram.program, "material.diffuse");
@@ -446,45 +980,108 @@ void initializeShaderPrograms(void) {
     // texture
     shaderProgram.texSamplerLocation   = glGetUniformLocation(shaderProgram.program, "texSampler");
     shaderProgram.useTextureLocation   = glGetUniformLocation(shaderProgram.program, "material.useTexture");
-    // reflector
-    shaderProgram.reflectorPositionLocation  = glGetUniformLocation(shaderProgram.program, "reflectorPosition");
-    shaderProgram.reflectorDirectionLocation = glGetUniformLocation(shaderProgram.program, "reflectorDirection");
+    bindFrameUniforms(shaderProgram.program);
+    bindPointLightSamplers(shaderProgram.program);
+
+    // load and compile shader for instanced drawing (same lighting, transforms from the instance buffer)
+
+    shaderList.clear();
+
+    shaderList.push_back(shaderFromFile(GL_VERTEX_SHADER, "lightingInstanced.vert"));
+    shaderList.push_back(shaderFromFile(GL_FRAGMENT_SHADER, "lightingPerVertex.frag"));
+
+    // vertex array objects are set up for shaderProgram -> attributes have to be at the same locations
+    std::vector<AttributeBinding> attributes;
+    attributes.push_back({ (GLuint)shaderProgram.posLocation, "position" });
+    attributes.push_back({ (GLuint)shaderProgram.normalLocation, "normal" });
+    if(shaderProgram.texCoordLocation != -1)
+      attributes.push_back({ (GLuint)shaderProgram.texCoordLocation, "texCoord" });
+
+    instancedShaderProgram.program = createCachedProgram("lightingInstanced", shaderList, attributes);
+    if(instancedShaderProgram.program == 0)
+      pgr::dieWithError("Instanced shader program linking failed!");
+
+    // get uniforms locations
+    bindFrameUniforms(instancedShaderProgram.program);
+    bindPointLightSamplers(instancedShaderProgram.program);
+    // material
+    instancedShaderProgram.ambientLocation   = glGetUniformLocation(instancedShaderProgram.program, "material.ambient");
+    instancedShaderProgram.diffuseLocation   = glGetUniformLocation(instancedShaderProgram.program, "material.diffuse");
+    instancedShaderProgram.specularLocation  = glGetUniformLocation(instancedShaderProgram.program, "material.specular");
+    instancedShaderProgram.shininessLocation = glGetUniformLocation(instancedShaderProgram.program, "material.shininess");
+    // texture
+    instancedShaderProgram.texSamplerLocation = glGetUniformLocation(instancedShaderProgram.program, "texSampler");
+    instancedShaderProgram.useTextureLocation = glGetUniformLocation(instancedShaderProgram.program, "material.useTexture");
+    // instance data
+    instancedShaderProgram.instanceDataLocation = glGetUniformLocation(instancedShaderProgram.program, "instanceData");
+    instancedShaderProgram.instanceBaseLocation = glGetUniformLocation(instancedShaderProgram.program, "instanceBase");
+    instancedShaderProgram.instanceTintLocation = glGetUniformLocation(instancedShaderProgram.program, "instanceTint");
+    // GPU resident motion, the scene size and the curve unit never change
+    instancedShaderProgram.instanceMotionLocation = glGetUniformLocation(instancedShaderProgram.program, "instanceMotion");
+    instancedShaderProgram.ufoCurveShapeLocation  = glGetUniformLocation(instancedShaderProgram.program, "ufoCurveShape");
+    glUseProgram(instancedShaderProgram.program);
+    glUniform3f(glGetUniformLocation(instancedShaderProgram.program, "sceneSize"), SCENE_WIDTH, SCENE_HEIGHT, SCENE_DEPTH);
+    glUniform1i(glGetUniformLocation(instancedShaderProgram.program, "ufoCurve"), UFO_CURVE_TEXTURE_UNIT);
+    glUniform1i(instancedShaderProgram.instanceMotionLocation, INSTANCE_MOTION_NONE);
+    glUseProgram(0);
   }
   else {
     // load and compile simple shader (colors only, no lights at all)
 
     // push vertex shader and fragment shader
-    shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, colorVertexShaderSrc));
-    shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, colorFragmentShaderSrc));
+    shaderList.push_back(shaderFromSource(GL_VERTEX_SHADER, colorVertexShaderSrc));
+    shaderList.push_back(shaderFromSource(GL_FRAGMENT_SHADER, colorFragmentShaderSrc));
 
     // create the program with two shaders (fragment and vertex)
-    shaderProgram.program = pgr::createProgram(shaderList);
+    shaderProgram.program = createCachedProgram("color", shaderList);
     // get position and color attributes locations
     shaderProgram.posLocation   = glGetAttribLocation(shaderProgram.program, "position");
     shaderProgram.colorLocation = glGetAttribLocation(shaderProgram.program, "color");
     // get uniforms locations
     shaderProgram.PVMmatrixLocation = glGetUniformLocation(shaderProgram.program, "PVMmatrix");
 
+    // instanced shader evaluates lighting -> not available for the simple shader
+    instancedShaderProgram.program = 0;
+    useInstancing = false;
   }
 
+  // load and compile shader for the ID pass of the picking
+
+  shaderList.clear();
+
+  shaderList.push_back(shaderFromFile(GL_VERTEX_SHADER, "pickId.vert"));
+  shaderList.push_back(shaderFromFile(GL_FRAGMENT_SHADER, "pickId.frag"));
+
+  // asteroid vertex array object is set up for shaderProgram
+  std::vector<AttributeBinding> pickAttributes;
+  pickAttributes.push_back({ (GLuint)shaderProgram.posLocation, "position" });
+
+  pickIdShaderProgram.program = createCachedProgram("pickId", shaderList, pickAttributes);
+  if(pickIdShaderProgram.program == 0)
+    pgr::dieWithError("Picking shader program linking failed!");
+
+  bindFrameUniforms(pickIdShaderProgram.program);
+  pickIdShaderProgram.transformsLocation = glGetUniformLocation(pickIdShaderProgram.program, "transforms");
+  pickIdShaderProgram.handlesLocation    = glGetUniformLocation(pickIdShaderProgram.program, "handles");
+
   // load and compile shader for explosions (dynamic texture)
 
   shaderList.clear();
 
   // push vertex shader and fragment shader
-  shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "explosion.vert"));
-  shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "explosion.frag"));
+  shaderList.push_back(shaderFromFile(GL_VERTEX_SHADER, "explosion.vert"));
+  shaderList.push_back(shaderFromFile(GL_FRAGMENT_SHADER, "explosion.frag"));
 
   // create the program with two shaders
-  explosionShaderProgram.program = pgr::createProgram(shaderList);
+  explosionShaderProgram.program = createCachedProgram("explosion", shaderList);
 
   // get position and texture coordinates attributes locations
   explosionShaderProgram.posLocation      = glGetAttribLocation(explosionShaderProgram.program, "position");
   explosionShaderProgram.texCoordLocation = glGetAttribLocation(explosionShaderProgram.program, "texCoord");
   // get uniforms locations
-  explosionShaderProgram.PVMmatrixLocation     = glGetUniformLocation(explosionShaderProgram.program, "PVMmatrix");
-  explosionShaderProgram.VmatrixLocation       = glGetUniformLocation(explosionShaderProgram.program, "Vmatrix");
-  explosionShaderProgram.timeLocation          = glGetUniformLocation(explosionShaderProgram.program, "time");
+  bindFrameUniforms(explosionShaderProgram.program);
+  explosionShaderProgram.billboardLocation     = glGetUniformLocation(explosionShaderProgram.program, "billboard");
+  explosionShaderProgram.startTimeLocation     = glGetUniformLocation(explosionShaderProgram.program, "startTime");
   explosionShaderProgram.texSamplerLocation    = glGetUniformLocation(explosionShaderProgram.program, "texSampler");
   explosionShaderProgram.frameDurationLocation = glGetUniformLocation(explosionShaderProgram.program, "frameDuration");
 
@@ -493,18 +1090,19 @@ void initializeShaderPrograms(void) {
   shaderList.clear();
 
   // push vertex shader and fragment shader
-  shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "banner.vert"));
-  shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "banner.frag"));
+  shaderList.push_back(shaderFromFile(GL_VERTEX_SHADER, "banner.vert"));
+  shaderList.push_back(shaderFromFile(GL_FRAGMENT_SHADER, "banner.frag"));
 
   // Create the program with two shaders
-  bannerShaderProgram.program = pgr::createProgram(shaderList);
+  bannerShaderProgram.program = createCachedProgram("banner", shaderList);
 
   // get position and color attributes locations
   bannerShaderProgram.posLocation      = glGetAttribLocation(bannerShaderProgram.program, "position");
   bannerShaderProgram.texCoordLocation = glGetAttribLocation(bannerShaderProgram.program, "texCoord");
   // get uniforms locations
+  bindFrameUniforms(bannerShaderProgram.program);
   bannerShaderProgram.PVMmatrixLocation  = glGetUniformLocation(bannerShaderProgram.program, "PVMmatrix");
-  bannerShaderProgram.timeLocation       = glGetUniformLocation(bannerShaderProgram.program, "time");
+  bannerShaderProgram.startTimeLocation  = glGetUniformLocation(bannerShaderProgram.program, "startTime");
   bannerShaderProgram.texSamplerLocation = glGetUniformLocation(bannerShaderProgram.program, "texSampler");
 
   // load and compile shader for skybox (cube map)
@@ -512,11 +1110,11 @@ void initializeShaderPrograms(void) {
   shaderList.clear();
 
   // push vertex shader and fragment shader
-  shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, skyboxFarPlaneVertexShaderSrc));
-  shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, skyboxFarPlaneFragmentShaderSrc));
+  shaderList.push_back(shaderFromSource(GL_VERTEX_SHADER, skyboxFarPlaneVertexShaderSrc));
+  shaderList.push_back(shaderFromSource(GL_FRAGMENT_SHADER, skyboxFarPlaneFragmentShaderSrc));
 
   // create the program with two shaders
-  skyboxFarPlaneShaderProgram.program = pgr::createProgram(shaderList);
+  skyboxFarPlaneShaderProgram.program = createCachedProgram("skyboxFarPlane", shaderList);
 
   // handles to vertex attributes locations
   skyboxFarPlaneShaderProgram.screenCoordLocation = glGetAttribLocation(skyboxFarPlaneShaderProgram.program, "screenCoord");
@@ -525,13 +1123,8 @@ void initializeShaderPrograms(void) {
   skyboxFarPlaneShaderProgram.inversePVmatrixLocation = glGetUniformLocation(skyboxFarPlaneShaderProgram.program, "inversePVmatrix");
 }
 
-/** Load mesh using assimp library
- *  Vertex, normals and texture coordinates data are stored without interleaving |VVVVV...|NNNNN...|tttt
- * \param fileName [in] file to open/load
- * \param shader [in] vao will connect loaded data to shader
- * \param geometry
- */
-bool loadSingleMesh(const std::string &fileName, SCommonShaderProgram& shader, MeshGeometry** geometry) {
+// imports the mesh by Assimp and converts it to the layout of the MeshGeometry buffers
+static bool importMesh(const std::string &fileName, GLenum normalType, MeshData &meshData) {
   Assimp::Importer importer;
 
   // Unitize object in size (scale the model to fit into (-1..1)^3)
@@ -547,66 +1140,44 @@ bool loadSingleMesh(const std::string &fileName, SCommonShaderProgram& shader, M
   // abort if the loader fails
   if(scn == NULL) {
     std::cerr << "assimp error: " << importer.GetErrorString() << std::endl;
-    *geometry = NULL;
     return false;
   }
 
   // some formats store whole scene (multiple meshes and materials, lights, cameras, ...) in one file, we cannot handle that in our simplified example
   if(scn->mNumMeshes != 1) {
     std::cerr << "this simplified loader can only process files with only one mesh" << std::endl;
-    *geometry = NULL;
     return false;
   }
 
-  // in this phase we know we have one mesh in our loaded scene, we can directly copy its data to OpenGL ...
+  // in this phase we know we have one mesh in our loaded scene, we can directly copy its data
   const aiMesh * mesh = scn->mMeshes[0];
 
-  *geometry = new MeshGeometry;
-
-  // vertex buffer object, store all vertex positions and normals
-  glGenBuffers(1, &((*geometry)->vertexBufferObject));
-  glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, 8*sizeof(float)*mesh->mNumVertices, 0, GL_STATIC_DRAW); // allocate memory for vertices, normals, and texture coordinates
-  // first store all vertices
-  glBufferSubData(GL_ARRAY_BUFFER, 0, 3*sizeof(float)*mesh->mNumVertices, mesh->mVertices);
-  // then store all normals
-  glBufferSubData(GL_ARRAY_BUFFER, 3*sizeof(float)*mesh->mNumVertices, 3*sizeof(float)*mesh->mNumVertices, mesh->mNormals);
-  
-  // just texture 0 for now
-  float *textureCoords = new float[2 * mesh->mNumVertices];  // 2 floats per vertex
-  float *currentTextureCoord = textureCoords;
-
-  // copy texture coordinates
-  aiVector3D vect;
-    
+  // texture 0 only, we use 2D textures with 2 coordinates and ignore the third coordinate
+  std::vector<float> textureCoords;
   if(mesh->HasTextureCoords(0) ) {
-    // we use 2D textures with 2 coordinates and ignore the third coordinate
+    textureCoords.resize(2 * mesh->mNumVertices);
     for(unsigned int idx=0; idx<mesh->mNumVertices; idx++) {
-      vect = (mesh->mTextureCoords[0])[idx];
-      *currentTextureCoord++ = vect.x;
-      *currentTextureCoord++ = vect.y;
+      textureCoords[2*idx + 0] = mesh->mTextureCoords[0][idx].x;
+      textureCoords[2*idx + 1] = mesh->mTextureCoords[0][idx].y;
     }
   }
-    
-  // finally store all texture coordinates
-  glBufferSubData(GL_ARRAY_BUFFER, 6*sizeof(float)*mesh->mNumVertices, 2*sizeof(float)*mesh->mNumVertices, textureCoords);
 
   // copy all mesh faces into one big array (assimp supports faces with ordinary number of vertices, we use only 3 -> triangles)
-  unsigned int *indices = new unsigned int[mesh->mNumFaces * 3];
+  std::vector<unsigned int> indices(mesh->mNumFaces * 3);
   for(unsigned int f = 0; f < mesh->mNumFaces; ++f) {
     indices[f*3 + 0] = mesh->mFaces[f].mIndices[0];
     indices[f*3 + 1] = mesh->mFaces[f].mIndices[1];
     indices[f*3 + 2] = mesh->mFaces[f].mIndices[2];
   }
 
-  // copy our temporary index array to OpenGL and free the array
-  glGenBuffers(1, &((*geometry)->elementBufferObject));
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*geometry)->elementBufferObject);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 3 * sizeof(unsigned) * mesh->mNumFaces, indices, GL_STATIC_DRAW);
-
-  delete [] indices;
+  // interleaved packed vertices, triangles reordered for the vertex cache
+  if(buildMeshData((const float*)mesh->mVertices, (const float*)mesh->mNormals, textureCoords.empty() ? NULL : textureCoords.data(), mesh->mNumVertices,
+                   indices.data(), mesh->mNumFaces, normalType, meshData) == false) {
+    std::cerr << "importMesh(): " << fileName << " has no triangles" << std::endl;
+    return false;
+  }
 
-  // copy the material info to MeshGeometry structure
+  // copy the material info to MeshData structure
   const aiMaterial *mat  = scn->mMaterials[mesh->mMaterialIndex];
   aiColor4D color;
   aiString name;
@@ -618,15 +1189,15 @@ bool loadSingleMesh(const std::string &fileName, SCommonShaderProgram& shader, M
   if((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_DIFFUSE, &color)) != AI_SUCCESS)
     color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
 
-  (*geometry)->diffuse = glm::vec3(color.r, color.g, color.b);
+  meshData.diffuse = glm::vec3(color.r, color.g, color.b);
 
   if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_AMBIENT, &color)) != AI_SUCCESS)
     color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-  (*geometry)->ambient = glm::vec3(color.r, color.g, color.b);
+  meshData.ambient = glm::vec3(color.r, color.g, color.b);
 
   if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_SPECULAR, &color)) != AI_SUCCESS)
     color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-  (*geometry)->specular = glm::vec3(color.r, color.g, color.b);
+  meshData.specular = glm::vec3(color.r, color.g, color.b);
 
   ai_real shininess, strength;
   unsigned int max;	// changed: to unsigned
@@ -637,59 +1208,208 @@ bool loadSingleMesh(const std::string &fileName, SCommonShaderProgram& shader, M
   max = 1;
   if((retValue = aiGetMaterialFloatArray(mat, AI_MATKEY_SHININESS_STRENGTH, &strength, &max)) != AI_SUCCESS)
     strength = 1.0f;
-  (*geometry)->shininess = shininess * strength;
+  meshData.shininess = shininess * strength;
 
-  (*geometry)->texture = 0;
+  meshData.textureName = "";
 
-  // load texture image
+  // texture name, the image itself is decoded in decodeMeshAsset()
   if (mat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-    // get texture name 
     aiString path; // filename
 
     aiReturn texFound = mat->GetTexture(aiTextureType_DIFFUSE, 0, &path);
-    std::string textureName = path.data;
+    meshData.textureName = path.data;
+  }
+
+  return true;
+}
+
+// signed normalized GL_INT_2_10_10_10_REV vertex attributes are core since OpenGL 3.3
+static bool packedNormalsSupported(void) {
+
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+  if(major > 3 || (major == 3 && minor >= 3))
+    return true;
+
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
 
-    size_t found = fileName.find_last_of("/\\");
+  for(GLint i = 0; i < extensionCount; i++) {
+    const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+    if(extension != NULL && strcmp(extension, "GL_ARB_vertex_type_2_10_10_10_rev") == 0)
+      return true;
+  }
+
+  return false;
+}
+
+// mesh decoded by a loader thread, GL objects are created by createMeshGeometry()
+typedef struct _MeshAsset {
+  std::string fileName;
+  SCommonShaderProgram *shader;
+  GLenum normalType;        // queried on the GL thread, see packedNormalsSupported()
+  MeshData mesh;
+  ImageData texture;        // diffuse texture of the material, no pixels if there is none
+  MeshGeometry **geometry;
+} MeshAsset;
+
+// loads the mesh from the cache or by Assimp and decodes its texture, no GL calls
+static bool decodeMeshAsset(void *data) {
+
+  MeshAsset &asset = *(MeshAsset*)data;
+  MeshData &mesh = asset.mesh;
+
+  mesh.mapping.data = NULL;
+  mesh.vertexData = NULL;
+  mesh.indexData = NULL;
+
+  // binary cache is used as long as it was built from the same obj/mtl files, Assimp is not run at all then
+  bool sourceFound = false;
+  const unsigned long long sourceHash = hashMeshSource(asset.fileName, sourceFound);
+  const std::string cacheName = asset.fileName + MESH_CACHE_SUFFIX;
+
+  bool cached = sourceFound && loadMeshCache(cacheName, sourceHash, mesh);
+
+  // cache written on a GPU with different normal format support
+  if(cached && mesh.normalType != asset.normalType) {
+    releaseMeshData(mesh);
+    cached = false;
+  }
+
+  if(cached == false) {
+    if(importMesh(asset.fileName, asset.normalType, mesh) != true) {
+      releaseMeshData(mesh);
+      return false;
+    }
+
+    if(sourceFound && saveMeshCache(cacheName, sourceHash, mesh) == false)
+      std::cerr << "decodeMeshAsset(): cannot write mesh cache " << cacheName << std::endl;
+  }
+
+  asset.texture.pixels.clear();
+
+  if(mesh.textureName.empty() == false) {
+    std::string textureName = mesh.textureName;
+
+    size_t found = asset.fileName.find_last_of("/\\");
     // insert correct texture file path 
     if(found != std::string::npos) { // not found
       //subMesh_p->textureName.insert(0, "/");
-      textureName.insert(0, fileName.substr(0, found+1));
+      textureName.insert(0, asset.fileName.substr(0, found+1));
     }
 
     std::cout << "Loading texture file: " << textureName << std::endl;
-    (*geometry)->texture = pgr::createTexture(textureName);
+    decodeImage(textureName, asset.texture);
   }
+
+  return true;
+}
+
+// creates buffers, texture and vertex array object of the decoded mesh
+static void createMeshGeometry(MeshAsset &asset) {
+
+  MeshGeometry *geometry = new MeshGeometry;
+
+  // vertex buffer object, store interleaved vertex positions, normals and texture coordinates
+  glGenBuffers(1, &(geometry->vertexBufferObject));
+  glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBufferObject);
+  glBufferData(GL_ARRAY_BUFFER, asset.mesh.vertexDataSize, asset.mesh.vertexData, GL_STATIC_DRAW);
+
+  // element buffer object, 3 indices per triangle
+  geometry->indexType = asset.mesh.indexType;
+  glGenBuffers(1, &(geometry->elementBufferObject));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->elementBufferObject);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, asset.mesh.indexDataSize, asset.mesh.indexData, GL_STATIC_DRAW);
+
+  // copy the material info to MeshGeometry structure
+  geometry->diffuse = asset.mesh.diffuse;
+  geometry->ambient = asset.mesh.ambient;
+  geometry->specular = asset.mesh.specular;
+  geometry->shininess = asset.mesh.shininess;
+
+  // texture image decoded together with the mesh
+  geometry->texture = createTextureFromImage(asset.texture);
   CHECK_GL_ERROR();
 
-  glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
-  glBindVertexArray((*geometry)->vertexArrayObject);
+  glGenVertexArrays(1, &(geometry->vertexArrayObject));
+  glBindVertexArray(geometry->vertexArrayObject);
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*geometry)->elementBufferObject); // bind our element array buffer (indices) to vao
-  glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->elementBufferObject); // bind our element array buffer (indices) to vao
+  glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBufferObject);
 
-  glEnableVertexAttribArray(shader.posLocation);
-  glVertexAttribPointer(shader.posLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  glEnableVertexAttribArray(asset.shader->posLocation);
+  glVertexAttribPointer(asset.shader->posLocation, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
 
   if(useLighting == true) {
-    glEnableVertexAttribArray(shader.normalLocation);
-    glVertexAttribPointer(shader.normalLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)(3 * sizeof(float) * mesh->mNumVertices));
+    // packed normals are normalized to -1..1 by the GL, w component is ignored by the shader
+    glEnableVertexAttribArray(asset.shader->normalLocation);
+    glVertexAttribPointer(asset.shader->normalLocation, 4, asset.mesh.normalType, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
   }
   else {
-	  glDisableVertexAttribArray(shader.colorLocation);
+	  glDisableVertexAttribArray(asset.shader->colorLocation);
 	  // following line is problematic on AMD/ATI graphic cards
 	  // -> if you see black screen (no objects at all) than try to set color manually in vertex shader to see at least something
-    glVertexAttrib3f(shader.colorLocation, color.r, color.g, color.b);
+    glVertexAttrib3f(asset.shader->colorLocation, asset.mesh.specular.x, asset.mesh.specular.y, asset.mesh.specular.z);
   }
 
-  glEnableVertexAttribArray(shader.texCoordLocation);
-  glVertexAttribPointer(shader.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 0, (void*)(6 * sizeof(float) * mesh->mNumVertices));
+  glEnableVertexAttribArray(asset.shader->texCoordLocation);
+  glVertexAttribPointer(asset.shader->texCoordLocation, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
   CHECK_GL_ERROR();
 
   glBindVertexArray(0);
 
-  (*geometry)->numTriangles = mesh->mNumFaces;
+  geometry->numTriangles = asset.mesh.triangleCount;
 
-  return true;
+  // levels of detail follow each other in the element buffer
+  geometry->lodCount = asset.mesh.lodCount;
+  unsigned int firstIndex = 0;
+  for(unsigned int i = 0; i < MESH_LODS_MAX; i++) {
+    geometry->lodFirstIndex[i] = firstIndex;
+    geometry->lodTriangleCount[i] = (i < asset.mesh.lodCount) ? asset.mesh.lodTriangleCount[i] : 0;
+    firstIndex += 3 * geometry->lodTriangleCount[i];
+  }
+
+  *asset.geometry = geometry;
+}
+
+
+// upload function of the meshes loaded by initializeModels()
+static void uploadMeshAsset(void *data, bool decoded) {
+
+  MeshAsset &asset = *(MeshAsset*)data;
+
+  if(decoded == true) {
+    createMeshGeometry(asset);
+  }
+  else {
+    std::cerr << "initializeModels(): " << asset.fileName << " model loading failed." << std::endl;
+    *asset.geometry = NULL;
+  }
+  CHECK_GL_ERROR();
+
+  releaseMeshData(asset.mesh);
+  std::vector<unsigned char>().swap(asset.texture.pixels);
+}
+
+bool loadSingleMesh(const std::string &fileName, SCommonShaderProgram& shader, MeshGeometry** geometry) {
+
+  MeshAsset asset;
+  asset.fileName = fileName;
+  asset.shader = &shader;
+  asset.normalType = packedNormalsSupported() ? GL_INT_2_10_10_10_REV : GL_BYTE;
+  asset.geometry = geometry;
+
+  const bool loaded = decodeMeshAsset(&asset);
+  if(loaded == true)
+    createMeshGeometry(asset);
+  else
+    *geometry = NULL;
+
+  releaseMeshData(asset.mesh);
+
+  return loaded;
 }
 
 void initMissileGeometry(SCommonShaderProgram &shader, MeshGeometry **geometry) {
@@ -770,17 +1490,58 @@ void initUfoGeometry(SCommonShaderProgram &shader, MeshGeometry **geometry) {
   glBindVertexArray(0);
 
   (*geometry)->numTriangles = ufoTrianglesCount;
+  (*geometry)->indexType = GL_UNSIGNED_INT;
+}
+
+
+void initInstanceBuffer(void) {
+
+  // each instance takes INSTANCE_TEXELS texels of the buffer texture
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  instanceBuffer.maxInstances = (unsigned int)maxTexels / INSTANCE_TEXELS;
+  instanceBuffer.allocated = std::min(1024u, instanceBuffer.maxInstances);
+
+  glGenBuffers(1, &instanceBuffer.bufferObject);
+  glBindBuffer(GL_TEXTURE_BUFFER, instanceBuffer.bufferObject);
+  glBufferData(GL_TEXTURE_BUFFER, instanceBuffer.allocated * INSTANCE_TEXELS * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glGenTextures(1, &instanceBuffer.texture);
+  glBindTexture(GL_TEXTURE_BUFFER, instanceBuffer.texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instanceBuffer.bufferObject);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  CHECK_GL_ERROR();
 }
 
+void initPickIdBuffer(void) {
+
+  // each instance takes 4 texels of the transform buffer texture
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  pickIdBuffer.maxInstances = (unsigned int)maxTexels / 4;
+
+  glGenBuffers(1, &pickIdBuffer.transformBuffer);
+  glGenBuffers(1, &pickIdBuffer.handleBuffer);
+
+  glGenTextures(1, &pickIdBuffer.transformTexture);
+  glBindTexture(GL_TEXTURE_BUFFER, pickIdBuffer.transformTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pickIdBuffer.transformBuffer);
+
+  glGenTextures(1, &pickIdBuffer.handleTexture);
+  glBindTexture(GL_TEXTURE_BUFFER, pickIdBuffer.handleTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, pickIdBuffer.handleBuffer);
+
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  CHECK_GL_ERROR();
+}
 
 void initBannerGeometry(GLuint shader, MeshGeometry **geometry) {
 
   *geometry = new MeshGeometry;
-  
-  (*geometry)->texture = pgr::createTexture(BANNER_TEXTURE_NAME);
-  glBindTexture(GL_TEXTURE_2D, (*geometry)->texture);
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  // texture is loaded asynchronously, see initializeModels()
+  (*geometry)->texture = 0;
 
   glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
   glBindVertexArray((*geometry)->vertexArrayObject);
@@ -805,7 +1566,8 @@ void initExplosionGeometry(GLuint shader, MeshGeometry **geometry) {
 
   *geometry = new MeshGeometry;
 
-  (*geometry)->texture = pgr::createTexture(EXPLOSION_TEXTURE_NAME);
+  // texture is loaded asynchronously, see initializeModels()
+  (*geometry)->texture = 0;
 
   glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
   glBindVertexArray((*geometry)->vertexArrayObject);
@@ -858,53 +1620,112 @@ void initSkyboxGeometry(GLuint shader, MeshGeometry **geometry) {
 
   (*geometry)->numTriangles = 2;
 
-  glActiveTexture(GL_TEXTURE0);
-
+  // faces of the cube map are loaded asynchronously, see initializeModels()
   glGenTextures(1, &((*geometry)->texture));
-  glBindTexture(GL_TEXTURE_CUBE_MAP, (*geometry)->texture);
+  CHECK_GL_ERROR();
+}
 
-  const char * suffixes[] = { "posx", "negx", "posy", "negy", "posz", "negz" };
-  GLuint targets[] = {
-    GL_TEXTURE_CUBE_MAP_POSITIVE_X, GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
-    GL_TEXTURE_CUBE_MAP_POSITIVE_Y, GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
-    GL_TEXTURE_CUBE_MAP_POSITIVE_Z, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
-  };
+// texture decoded by a loader thread
+typedef struct _TextureAsset {
+  const char *fileName;
+  GLint wrapS;              // horizontal wrap mode of the texture
+  ImageData image;
+  GLuint *texture;          // where the created texture is stored
+} TextureAsset;
+
+// one face of the skybox cube map
+typedef struct _SkyboxFaceAsset {
+  std::string fileName;
+  GLenum target;
+  ImageData image;
+} SkyboxFaceAsset;
+
+static MeshAsset meshAssets[2];
+static TextureAsset textureAssets[2];
+static SkyboxFaceAsset skyboxFaceAssets[6];
+static unsigned int skyboxFacesUploaded = 0;
+
+static bool decodeTextureAsset(void *data) {
+
+  TextureAsset &asset = *(TextureAsset*)data;
+  return decodeImage(asset.fileName, asset.image);
+}
 
-  for( int i = 0; i < 6; i++ ) {
-    std::string texName = std::string(SKYBOX_CUBE_TEXTURE_FILE_PREFIX) + "_" + suffixes[i] + ".jpg";
-    std::cout << "Loading cube map texture: " << texName << std::endl;
-    if(!pgr::loadTexImage2D(texName, targets[i])) {
-      pgr::dieWithError("Skybox cube map loading failed!");
-    }
+static void uploadTextureAsset(void *data, bool decoded) {
+
+  TextureAsset &asset = *(TextureAsset*)data;
+
+  // the object is drawn without the texture, as it was when pgr::createTexture() failed
+  if(decoded == false) {
+    std::cerr << "uploadTextureAsset(): texture " << asset.fileName << " not loaded" << std::endl;
+    *asset.texture = 0;
+    return;
   }
 
-  glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-  glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+  *asset.texture = createTextureFromImage(asset.image);
 
-  // unbind the texture (just in case someone will mess up with texture calls later)
-  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  if(*asset.texture != 0 && asset.wrapS != GL_REPEAT) {
+    glBindTexture(GL_TEXTURE_2D, *asset.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, asset.wrapS);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
   CHECK_GL_ERROR();
+
+  std::vector<unsigned char>().swap(asset.image.pixels);
 }
 
-/** Initialize vertex buffers and vertex arrays for all objects. 
- */
-void initializeModels() {
+static bool decodeSkyboxFaceAsset(void *data) {
 
-  // load asteroid model from external file
-  if(loadSingleMesh(ASTEROID_MODEL_NAME, shaderProgram, &asteroidGeometry) != true) {
-    std::cerr << "initializeModels(): Asteroid model loading failed." << std::endl;
+  SkyboxFaceAsset &asset = *(SkyboxFaceAsset*)data;
+
+  std::cout << "Loading cube map texture: " << asset.fileName << std::endl;
+  return decodeImage(asset.fileName, asset.image);
+}
+
+// faces are uploaded one by one, mipmaps are generated when the last face arrives
+static void uploadSkyboxFaceAsset(void *data, bool decoded) {
+
+  SkyboxFaceAsset &asset = *(SkyboxFaceAsset*)data;
+
+  if(decoded == false)
+    pgr::dieWithError("Skybox cube map loading failed!");
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxGeometry->texture);
+
+  uploadImage(asset.image, asset.target);
+  std::vector<unsigned char>().swap(asset.image.pixels);
+
+  if(++skyboxFacesUploaded == 6) {
+    glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
   }
+
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
   CHECK_GL_ERROR();
+}
 
-  // load space ship model from external file
-  if(loadSingleMesh(SPACESHIP_MODEL_NAME, shaderProgram, &spaceShipGeometry) != true) {
-    std::cerr << "initializeModels(): Space ship model loading failed." << std::endl;
+/** Initialize vertex buffers and vertex arrays for all objects and start loading of the meshes
+ *  and textures, the models can be used when updateAssetLoading() returns true.
+ */
+void initializeModels(unsigned int loaderThreadCount) {
+
+  // asteroid and space ship models from external files
+  const char *meshFileNames[] = { ASTEROID_MODEL_NAME, SPACESHIP_MODEL_NAME };
+  MeshGeometry **meshGeometries[] = { &asteroidGeometry, &spaceShipGeometry };
+  const GLenum normalType = packedNormalsSupported() ? GL_INT_2_10_10_10_REV : GL_BYTE;
+
+  for(int i = 0; i < 2; i++) {
+    meshAssets[i].fileName = meshFileNames[i];
+    meshAssets[i].shader = &shaderProgram;
+    meshAssets[i].normalType = normalType;
+    meshAssets[i].geometry = meshGeometries[i];
+    queueAsset(meshFileNames[i], decodeMeshAsset, uploadMeshAsset, &meshAssets[i]);
   }
-  CHECK_GL_ERROR();
 
   // fill MeshGeometry structure for missile object
   initMissileGeometry(shaderProgram, &missileGeometry);
@@ -912,18 +1733,57 @@ void initializeModels() {
   // fill MeshGeometry structure for ufo object
   initUfoGeometry(shaderProgram, &ufoGeometry);
 
+  // buffer for instanced drawing of asteroids, missiles and ufos
+  if(instancedShaderProgram.program != 0)
+    initInstanceBuffer();
+
+  // buffers for the ID pass of the picking
+  initPickIdBuffer();
+
   // fill MeshGeometry structure for explosion object
   initExplosionGeometry(explosionShaderProgram.program, &explosionGeometry);
 
   // fill MeshGeometry structure for banner object
   initBannerGeometry(bannerShaderProgram.program, &bannerGeometry);
 
+  textureAssets[0].fileName = EXPLOSION_TEXTURE_NAME;
+  textureAssets[0].wrapS = GL_REPEAT;
+  textureAssets[0].texture = &explosionGeometry->texture;
+
+  textureAssets[1].fileName = BANNER_TEXTURE_NAME;
+  textureAssets[1].wrapS = GL_CLAMP_TO_BORDER;
+  textureAssets[1].texture = &bannerGeometry->texture;
+
+  for(int i = 0; i < 2; i++)
+    queueAsset(textureAssets[i].fileName, decodeTextureAsset, uploadTextureAsset, &textureAssets[i]);
+
   // fill MeshGeometry structure for skybox object
   initSkyboxGeometry(skyboxFarPlaneShaderProgram.program, &skyboxGeometry);
+
+  const char * suffixes[] = { "posx", "negx", "posy", "negy", "posz", "negz" };
+  GLuint targets[] = {
+    GL_TEXTURE_CUBE_MAP_POSITIVE_X, GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+    GL_TEXTURE_CUBE_MAP_POSITIVE_Y, GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+    GL_TEXTURE_CUBE_MAP_POSITIVE_Z, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
+  };
+
+  skyboxFacesUploaded = 0;
+
+  for( int i = 0; i < 6; i++ ) {
+    skyboxFaceAssets[i].fileName = std::string(SKYBOX_CUBE_TEXTURE_FILE_PREFIX) + "_" + suffixes[i] + ".jpg";
+    skyboxFaceAssets[i].target = targets[i];
+    queueAsset(skyboxFaceAssets[i].fileName.c_str(), decodeSkyboxFaceAsset, uploadSkyboxFaceAsset, &skyboxFaceAssets[i]);
+  }
+
+  startAssetLoading(loaderThreadCount);
 }
 
 void cleanupGeometry(MeshGeometry *geometry) {
 
+  // model not loaded
+  if(geometry == NULL)
+    return;
+
   glDeleteVertexArrays(1, &(geometry->vertexArrayObject));
   glDeleteBuffers(1, &(geometry->elementBufferObject));
   glDeleteBuffers(1, &(geometry->vertexBufferObject));
@@ -942,4 +1802,14 @@ void cleanupModels() {
   cleanupGeometry(explosionGeometry);
   cleanupGeometry(bannerGeometry);
   cleanupGeometry(skyboxGeometry);
+
+  glDeleteTextures(1, &instanceBuffer.texture);
+  glDeleteBuffers(1, &instanceBuffer.bufferObject);
+  instanceBuffer.texture = 0;
+  instanceBuffer.bufferObject = 0;
+
+  glDeleteTextures(1, &pickIdBuffer.transformTexture);
+  glDeleteTextures(1, &pickIdBuffer.handleTexture);
+  glDeleteBuffers(1, &pickIdBuffer.transformBuffer);
+  glDeleteBuffers(1, &pickIdBuffer.handleBuffer);
 }
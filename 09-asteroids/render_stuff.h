@@ -10,7 +10,10 @@
 #ifndef __RENDER_STUFF_H
 #define __RENDER_STUFF_H
 
+#include <vector>
 #include "data.h"
+#include "mesh_lod.h"
+#include "object_pool.h"
 
 // defines geometry of object in the scene (space ship, ufo, asteroid, etc.)
 // geometry is shared among all instances of the same object type
@@ -19,6 +22,11 @@ typedef struct _MeshGeometry {
   GLuint        elementBufferObject;  // identifier for the element buffer object
   GLuint        vertexArrayObject;    // identifier for the vertex array object
   unsigned int  numTriangles;         // number of triangles in the mesh
+  GLenum        indexType;            // type of the indices in the element buffer object
+  // levels of detail of the meshes loaded by loadSingleMesh(), level 0 = numTriangles from index 0
+  unsigned int  lodCount;
+  unsigned int  lodFirstIndex[MESH_LODS_MAX];
+  unsigned int  lodTriangleCount[MESH_LODS_MAX];
   // material
   glm::vec3     ambient;
   glm::vec3     diffuse;
@@ -28,53 +36,13 @@ typedef struct _MeshGeometry {
 
 } MeshGeometry;
 
-// parameters of individual objects in the scene (e.g. position, size, speed, etc.)
-typedef struct _Object {
-  glm::vec3 position;
-  glm::vec3 direction;
-  float     speed;
-  float     size;
-
-  bool destroyed;
-
-  float startTime;
-  float currentTime;
-
-} Object;
-
-typedef struct _SpaceShipObject : public Object {
-
-  float viewAngle; // in degrees
-
-} SpaceShipObject;
-
-typedef struct _AsteroidObject : public Object {
-
-  float rotationSpeed;
-
-} AsteroidObject;
-
-typedef struct _MissileObject : public Object {
-
-} MissileObject;
-
-typedef struct _UfoObject : public Object {
-
-  float     rotationSpeed;
-  glm::vec3 initPosition;
-
-} UfoObject;
-
-typedef struct _ExplosionObject : public Object {
-
-  int    textureFrames;
-  float  frameDuration;
-
-} ExplosionObject;
-
-typedef struct _BannerObject : public Object {
-
-} BannerObject;
+// dense indices of the objects drawn in this frame, filled by cullObjects()
+typedef struct _VisibleObjects {
+  std::vector<unsigned int> asteroids;
+  std::vector<unsigned int> missiles;
+  std::vector<unsigned int> ufos;
+  std::vector<unsigned int> explosions;
+} VisibleObjects;
 
 typedef struct _commonShaderProgram {
   // identifier for the shader program
@@ -85,13 +53,10 @@ typedef struct _commonShaderProgram {
   GLint normalLocation;    // = -1;
   GLint texCoordLocation;  // = -1;
   // uniforms locations
-  GLint PVMmatrixLocation;    // = -1;
-  GLint VmatrixLocation;      // = -1;  view/camera matrix
+  GLint PVMmatrixLocation;    // = -1;  simple color shader only, view and projection are in the FrameData block
   GLint MmatrixLocation;      // = -1;  modeling matrix
   GLint normalMatrixLocation; // = -1;  inverse transposed Mmatrix
 
-  GLint timeLocation;         // = -1; elapsed time in seconds
-
   // material 
   GLint diffuseLocation;    // = -1;
   GLint ambientLocation;    // = -1;
@@ -100,26 +65,73 @@ typedef struct _commonShaderProgram {
   // texture
   GLint useTextureLocation; // = -1; 
   GLint texSamplerLocation; // = -1;
-  // reflector related uniforms
-  GLint reflectorPositionLocation;  // = -1; 
-  GLint reflectorDirectionLocation; // = -1;
 } SCommonShaderProgram;
 
 
-glm::vec3 checkBounds(const glm::vec3 & position, float objectSize = 1.0f);
-
-void drawSpaceShip(SpaceShipObject* spaceShip, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawAsteroid(AsteroidObject* asteroid, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawMissile(MissileObject* missile, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawUfo(UfoObject* ufo, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawExplosion(ExplosionObject* explosion, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+//**************************************************************************************************
+/// Fills the per-frame uniform buffer shared by the shader programs.
+/**
+ Must be called before the first draw of a frame. The camera, the sun animation and the space ship
+ reflector are uploaded once and read by all draw functions below except drawBanner() and drawSkybox(),
+ which use their own matrices.
+
+ \param[in]  viewMatrix          Camera of the frame.
+ \param[in]  projectionMatrix    Projection of the frame.
+ \param[in]  time                Elapsed time in seconds.
+ \param[in]  reflectorPosition   Space ship reflector position (world coordinates).
+ \param[in]  reflectorDirection  Space ship reflector direction (world coordinates).
+ \param[in]  clusterScale        Light clusters per pixel (xy), depth slice scale and bias (zw), see binPointLights().
+ \param[in]  logarithmicSlices   Depth slices of the light clusters are logarithmic.
+*/
+void setFrameUniforms(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, float time, const glm::vec3 &reflectorPosition, const glm::vec3 &reflectorDirection,
+                      const glm::vec4 &clusterScale, bool logarithmicSlices);
+
+//**************************************************************************************************
+/// Selects the levels of detail of the visible asteroids and the space ship.
+/**
+ The level follows the radius of the bounding sphere projected by the camera of setFrameUniforms(),
+ which has to be called first. A level changes only when the radius crosses its threshold by
+ MESH_LOD_HYSTERESIS, so objects near a threshold do not pop every frame.
+
+ \param[in]  asteroids       Asteroids, their lod is updated.
+ \param[in]  spaceShip       Space ship.
+ \param[in]  visible         Visible objects of the frame.
+ \param[in]  viewportHeight  Height of the viewport in pixels.
+ \return                     Number of triangles drawn for the visible asteroids and the space ship.
+*/
+unsigned int selectMeshLods(AsteroidPool &asteroids, const SpaceShipObject *spaceShip, const VisibleObjects &visible, int viewportHeight);
+
+// queue packets to the render queue, the objects are drawn by executeRenderQueue(RENDER_PASS_OPAQUE)
+void drawSpaceShip(SpaceShipObject* spaceShip);
+
+//**************************************************************************************************
+/// Queues packets of the objects given by their dense indices.
+/**
+ The transforms and materials of the packets are computed by the job system, each thread records
+ its own range of packets. The objects are drawn by executeRenderQueue(RENDER_PASS_OPAQUE) on the
+ thread owning the OpenGL context, which only uploads the recorded uniforms.
+
+ \param[in]  asteroids  Pool of the objects.
+ \param[in]  indices    Dense indices of the drawn objects, e.g. VisibleObjects::asteroids.
+ \param[in]  count      Number of indices.
+*/
+void drawAsteroids(const AsteroidPool &asteroids, const unsigned int *indices, unsigned int count);
+void drawMissiles(const MissilePool &missiles, const unsigned int *indices, unsigned int count);
+void drawUfos(const UfoPool &ufos, const unsigned int *indices, unsigned int count);
+// draws the visible asteroids, missiles and ufos using one instanced draw call per geometry,
+// objects exceeding the capacity of the instance buffer are queued as single packets
+void drawInstancedObjects(const AsteroidPool &asteroids, const MissilePool &missiles, const UfoPool &ufos, const VisibleObjects &visible);
+// ID pass of the picking - draws handles of all asteroids by one instanced draw call
+void drawAsteroidIds(const AsteroidPool &asteroids);
+// queues packets drawn by executeRenderQueue(RENDER_PASS_EFFECTS), recorded as by drawAsteroids()
+void drawExplosions(const ExplosionPool &explosions, const unsigned int *indices, unsigned int count);
 void drawBanner(BannerObject* banner, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
 void drawSkybox(const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
 
 void initializeShaderPrograms();
 void cleanupShaderPrograms();
 
-void initializeModels();
+void initializeModels(unsigned int loaderThreadCount);
 void cleanupModels();
 
 #endif // __RENDER_STUFF_H
@@ -0,0 +1,228 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    replay.cpp
+ * \brief   Recording and replaying of games - the seed and the input of each simulation step
+ *          are stored to a compact binary log, so the same game can be played again exactly.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "replay.h"
+#include "mesh_cache.h" // mapFile()
+
+static const char REPLAY_MAGIC[4] = { 'A', 'R', 'P', 'L' };
+
+typedef struct _ReplayHeader {
+  char         magic[4];
+  unsigned int version;
+  unsigned int headerSize;    // sizeof(ReplayHeader) of the writer
+  unsigned int seed;
+  int          collisionMode;
+  float        timeStep;
+} ReplayHeader;
+
+// largest step: time, keys, command count, commands (command + argument) and the state hash
+#define REPLAY_TICK_SIZE_MAX (4 + 1 + 1 + TICK_COMMANDS_MAX * (1 + 4) + 4)
+
+struct Replay {
+
+  // recording
+  FILE         *recordFile;     // NULL if not recording
+  unsigned int recordedTicks;
+
+  // replaying
+  MappedFile   log;             // log.data is NULL if not replaying
+  size_t       position;        // offset of the next step in the log
+  unsigned int replayedTicks;
+  unsigned int expectedHash;    // state hash recorded with the last read step
+  unsigned int divergedTick;    // first step whose state differed from the recording, 0 = none
+
+} replay;
+
+bool beginRecording(const std::string &fileName, const ReplaySettings &settings) {
+
+  endRecording();
+
+  replay.recordFile = std::fopen(fileName.c_str(), "wb");
+  if(replay.recordFile == NULL) {
+    std::cerr << "beginRecording(): cannot create " << fileName << std::endl;
+    return false;
+  }
+
+  ReplayHeader header;
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+  header.version = REPLAY_VERSION;
+  header.headerSize = sizeof(ReplayHeader);
+  header.seed = settings.seed;
+  header.collisionMode = settings.collisionMode;
+  header.timeStep = settings.timeStep;
+
+  if(std::fwrite(&header, sizeof(header), 1, replay.recordFile) != 1) {
+    std::cerr << "beginRecording(): cannot write " << fileName << std::endl;
+    std::fclose(replay.recordFile);
+    replay.recordFile = NULL;
+    return false;
+  }
+
+  replay.recordedTicks = 0;
+
+  return true;
+}
+
+bool isRecording(void) {
+
+  return replay.recordFile != NULL;
+}
+
+void recordTick(const TickInput &input, unsigned int stateHash) {
+
+  if(replay.recordFile == NULL)
+    return;
+
+  // the step is assembled first and written by one call
+  unsigned char data[REPLAY_TICK_SIZE_MAX];
+  size_t size = 0;
+
+  memcpy(data + size, &input.elapsedTime, 4); size += 4;
+  data[size++] = input.keys;
+  data[size++] = input.commandCount;
+  for(unsigned int i = 0; i < input.commandCount; i++) {
+    data[size++] = input.command[i];
+    memcpy(data + size, &input.argument[i], 4); size += 4;
+  }
+  memcpy(data + size, &stateHash, 4); size += 4;
+
+  if(std::fwrite(data, 1, size, replay.recordFile) != size) {
+    std::cerr << "recordTick(): write failed, recording stopped after " << replay.recordedTicks << " steps" << std::endl;
+    std::fclose(replay.recordFile);
+    replay.recordFile = NULL;
+    return;
+  }
+
+  replay.recordedTicks++;
+}
+
+unsigned int endRecording(void) {
+
+  if(replay.recordFile == NULL)
+    return 0;
+
+  if(std::fclose(replay.recordFile) != 0)
+    std::cerr << "endRecording(): the log may be incomplete" << std::endl;
+
+  replay.recordFile = NULL;
+
+  return replay.recordedTicks;
+}
+
+bool loadReplay(const std::string &fileName, ReplaySettings &settings) {
+
+  closeReplay();
+
+  if(mapFile(fileName, replay.log) == false) {
+    std::cerr << "loadReplay(): cannot read " << fileName << std::endl;
+    return false;
+  }
+
+  ReplayHeader header;
+  if(replay.log.size < sizeof(header)) {
+    std::cerr << "loadReplay(): " << fileName << " is not a replay" << std::endl;
+    unmapFile(replay.log);
+    return false;
+  }
+  memcpy(&header, replay.log.data, sizeof(header));
+
+  if(memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != REPLAY_VERSION ||
+     header.headerSize != sizeof(ReplayHeader)) {
+    std::cerr << "loadReplay(): " << fileName << " is not a replay of version " << REPLAY_VERSION << std::endl;
+    unmapFile(replay.log);
+    return false;
+  }
+
+  // the mode indexes collisionModeNames[] and selects the collision test of every step
+  if(header.collisionMode < 0 || header.collisionMode >= COLLISION_MODES_COUNT) {
+    std::cerr << "loadReplay(): " << fileName << " has unknown collision mode " << header.collisionMode << std::endl;
+    unmapFile(replay.log);
+    return false;
+  }
+
+  settings.seed = header.seed;
+  settings.collisionMode = header.collisionMode;
+  settings.timeStep = header.timeStep;
+
+  replay.position = sizeof(header);
+  replay.replayedTicks = 0;
+  replay.expectedHash = 0;
+  replay.divergedTick = 0;
+
+  return true;
+}
+
+bool isReplaying(void) {
+
+  return replay.log.data != NULL;
+}
+
+bool nextReplayTick(TickInput &input) {
+
+  if(replay.log.data == NULL)
+    return false;
+
+  const unsigned char *data = replay.log.data + replay.position;
+  const size_t available = replay.log.size - replay.position;
+
+  // time, keys and command count
+  if(available < 6)
+    return false;
+
+  memcpy(&input.elapsedTime, data, 4);
+  input.keys = data[4];
+  input.commandCount = data[5];
+
+  const size_t size = 6 + input.commandCount * 5 + 4;
+  if(input.commandCount > TICK_COMMANDS_MAX || available < size)
+    return false;
+
+  for(unsigned int i = 0; i < input.commandCount; i++) {
+    input.command[i] = data[6 + i * 5];
+    memcpy(&input.argument[i], data + 6 + i * 5 + 1, 4);
+  }
+  memcpy(&replay.expectedHash, data + size - 4, 4);
+
+  replay.position += size;
+  replay.replayedTicks++;
+
+  return true;
+}
+
+void verifyReplayTick(unsigned int stateHash) {
+
+  if(stateHash == replay.expectedHash || replay.divergedTick != 0)
+    return;
+
+  replay.divergedTick = replay.replayedTicks;
+  std::cerr << "verifyReplayTick(): replay diverged from the recording at step " << replay.divergedTick << std::endl;
+}
+
+std::string replayReport(void) {
+
+  char report[128];
+
+  if(replay.divergedTick == 0)
+    snprintf(report, sizeof(report), "Replayed %u steps, the game matched the recording\n", replay.replayedTicks);
+  else
+    snprintf(report, sizeof(report), "Replayed %u steps, the game diverged from the recording at step %u\n", replay.replayedTicks, replay.divergedTick);
+
+  return report;
+}
+
+void closeReplay(void) {
+
+  if(replay.log.data != NULL)
+    unmapFile(replay.log);
+}
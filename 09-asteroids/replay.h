@@ -0,0 +1,74 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    replay.h
+ * \brief   Recording and replaying of games - the seed and the input of each simulation step
+ *          are stored to a compact binary log, so the same game can be played again exactly.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+#include <string>
+#include "pgr.h"
+#include "simulation.h"
+
+// version of the log layout - increase whenever the layout or the meaning of the recorded input changes
+#define REPLAY_VERSION 1
+
+// session the log was recorded in, the game itself is started by COMMAND_RESTART of the first step
+typedef struct _ReplaySettings {
+  unsigned int seed;          // seed of the simulation random generator
+  int          collisionMode; // CollisionMode at the beginning of the game
+  float        timeStep;      // fixed time step of a headless recording, 0 if the steps followed the clock
+} ReplaySettings;
+
+//**************************************************************************************************
+/// Creates the log file and writes the session settings.
+/**
+ The caller seeds the simulation with settings.seed and queues COMMAND_RESTART before the first
+ recorded step, replays do the same.
+
+ \param[in]  fileName  Log file, an existing file is overwritten.
+ \param[in]  settings  Settings of the recorded session.
+ \return               False if the file cannot be created.
+*/
+bool beginRecording(const std::string &fileName, const ReplaySettings &settings);
+
+// true between beginRecording() and endRecording()
+bool isRecording(void);
+
+// appends the input of a step and the state hash after the step
+void recordTick(const TickInput &input, unsigned int stateHash);
+
+// closes the log and returns the number of recorded steps
+unsigned int endRecording(void);
+
+//**************************************************************************************************
+/// Opens a log for replaying.
+/**
+ The log is memory mapped, reading the steps does not touch the disk in timed runs. A log
+ truncated by a crash of the recording is replayed up to its last complete step.
+
+ \param[in]   fileName  Log file written by beginRecording().
+ \param[out]  settings  Settings of the recorded session.
+ \return                False if the file cannot be read or has a different version.
+*/
+bool loadReplay(const std::string &fileName, ReplaySettings &settings);
+
+// true between loadReplay() and closeReplay()
+bool isReplaying(void);
+
+// reads the input of the next step, returns false when the log has ended
+bool nextReplayTick(TickInput &input);
+
+// compares the state after the last read step with the recording, the first difference is reported
+void verifyReplayTick(unsigned int stateHash);
+
+// number of replayed steps and the first step that diverged from the recording
+std::string replayReport(void);
+
+// unmaps the log
+void closeReplay(void);
+
+#endif // __REPLAY_H
@@ -0,0 +1,982 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    simulation.cpp
+ * \brief   Game logic of the Asteroids game - object updates, collisions and spawning.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include "pgr.h"
+#include "simulation.h"
+#include "spline.h"
+#include "job_system.h"
+#include "kinetic_collisions.h"
+#include "profiler.h"
+
+// minimum number of objects updated by one job
+#define UPDATE_GRAIN_SIZE 1024
+
+// the grid is built only for a pool needing at least this many missile x object tests in the step,
+// below it the brute force is faster (checkCollisions benchmark: crossover at about 600 asteroids and 6 missiles)
+#define COLLISION_GRID_MIN_TESTS 4096
+
+// ufos evaluate the curve in batches of this size
+#define UFO_CURVE_BATCH 64
+// arc-length table entries per segment of the ufo curve
+#define UFO_CURVE_SAMPLES_PER_SEGMENT 128
+
+const char* collisionModeNames[COLLISION_MODES_COUNT] = { "brute force", "grid", "grid + verification", "kinetic" };
+
+GameState   gameState;
+GameObjects gameObjects;
+
+// broadphase structures, rebuilt in each checkCollisions() call
+struct CollisionBroadphase {
+
+  CollisionGrid asteroidGrid;
+  CollisionGrid ufoGrid;
+
+  std::vector<unsigned int> candidates;   // objects to be tested by the narrowphase
+
+  KineticCollisions kinetic;              // kept between the calls, reset by a new game or another mode
+} collisionBroadphase;
+
+// ufos follow curveData with constant speed
+CurveArcLengthTable ufoCurve;
+
+// there is only one space ship and one banner -> no need to allocate them
+static SpaceShipObject spaceShipStorage;
+static BannerObject    bannerStorage;
+
+// NULL in the headless mode
+static ExplosionListener explosionListener = NULL;
+
+// largest value returned by simulationRandom()
+#define SIMULATION_RANDOM_MAX 0x7fffffff
+
+// FNV-1a hash of the game state
+#define FNV32_OFFSET_BASIS 2166136261u
+#define FNV32_PRIME        16777619u
+
+// random generator of the game logic - unlike rand() it is not shared with other code (drivers, libraries)
+// and gives the same sequence on all platforms, so a recorded game replays exactly
+static unsigned int randomState = 1;
+
+// commands queued by queueCommand(), taken by the next gatherTickInput()
+struct CommandQueue {
+  unsigned char command[TICK_COMMANDS_MAX];
+  unsigned int  argument[TICK_COMMANDS_MAX];
+  unsigned int  count;
+} commandQueue;
+
+// xorshift32, returns 0 ... SIMULATION_RANDOM_MAX
+static int simulationRandom(void) {
+
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+
+  return (int)(randomState >> 1);
+}
+
+void seedSimulationRandom(unsigned int seed) {
+
+  // xorshift never leaves the zero state
+  randomState = (seed != 0) ? seed : 0x9e3779b9u;
+}
+
+//**************************************************************************************************
+/// Checks whether a given point is inside a sphere or not.
+/**
+ \param[in]  point      Point to be tested.
+ \param[in]  center     Center of the sphere.
+ \param[in]  radius     Radius of the sphere.
+ \return                True if the point lies inside the sphere, otherwise false.
+*/
+bool pointInSphere(const glm::vec3 &point, const glm::vec3 &center, float radius) {
+// ======== BEGIN OF SOLUTION - TASK 6_2-1 ======== //
+  // check whether the given point lies within a sphere of given radius or not
+    
+    // varianta 1
+    //float dx = point.x - center.x;
+    //float dy = point.y - center.y;
+    //float dz = point.z - center.z;
+    //float dst = dx * dx + dy * dy + dz * dz;
+
+    //if (dst <= radius * radius)
+    //    return true;
+
+    
+    // varianta 2
+    if (glm::dot(point - center, point - center) <= radius * radius)
+        return true;
+
+
+    // varianta 3
+    //if (glm::distance(center, point) <= radius)
+    //    return true;
+
+
+// ========  END OF SOLUTION - TASK 6_2-1  ======== //
+
+  return false;
+}
+
+//**************************************************************************************************
+/// Checks if there is intersection between two given spheres or not.
+/**
+ \param[in]  center1    First sphere center.
+ \param[in]  radius1    First sphere radius.
+ \param[in]  center2    Second sphere center.
+ \param[in]  radius2    Second sphere radius.
+ \return                True if the spheres overlap, otherwise false.
+*/
+bool spheresIntersection(const glm::vec3 &center1, float radius1, const glm::vec3 &center2, float radius2) {
+// ======== BEGIN OF SOLUTION - TASK 6_2-2 ======== //
+  // check whether given spheres are intersecting each other or not
+/*    glm::vec3 delta = center1 - center2;
+
+    if (glm::dot(delta, delta) < (radius1 + radius2) * (radius1 + radius2))
+        return true;*/
+
+    float dx = center1.x - center2.x;
+    float dy = center1.y - center2.y;
+    float dz = center1.z - center2.z;
+    float dst = dx * dx + dy * dy + dz * dz;
+
+    if (glm::distance(center1, center2) <= (radius1 + radius2))
+        return true;
+
+
+// ========  END OF SOLUTION - TASK 6_2-2  ======== //
+
+  return false;
+}
+
+void insertExplosion(const glm::vec3 &position) {
+
+  ExplosionObject newExplosion;
+
+  newExplosion.speed = 0.0f;
+  newExplosion.destroyed = false;
+
+  newExplosion.startTime = gameState.elapsedTime;
+  newExplosion.currentTime = newExplosion.startTime;
+
+  newExplosion.size = BILLBOARD_SIZE;
+  newExplosion.direction = glm::vec3(0.0f, 0.0f, 1.0f);
+
+  newExplosion.frameDuration = 0.1f;
+  newExplosion.textureFrames = 16;
+
+  newExplosion.position = position;
+
+  insertObject(gameObjects.explosions, newExplosion);
+
+  if(explosionListener != NULL)
+    explosionListener(position, gameState.elapsedTime);
+}
+
+void setExplosionListener(ExplosionListener listener) {
+
+  explosionListener = listener;
+}
+
+void increaseSpaceShipSpeed(float deltaSpeed) {
+
+  gameObjects.spaceShip->speed =
+    std::min(gameObjects.spaceShip->speed + deltaSpeed, SPACESHIP_SPEED_MAX);
+}
+
+void decreaseSpaceShipSpeed(float deltaSpeed) {
+
+  gameObjects.spaceShip->speed =
+    std::max(gameObjects.spaceShip->speed - deltaSpeed, 0.0f);
+}
+
+void turnSpaceShipLeft(float deltaAngle) {
+
+  gameObjects.spaceShip->viewAngle += deltaAngle;
+
+  if(gameObjects.spaceShip->viewAngle > 360.0f)
+    gameObjects.spaceShip->viewAngle -= 360.0f;
+
+  float angle = glm::radians(gameObjects.spaceShip->viewAngle);
+
+  gameObjects.spaceShip->direction.x = cos(angle);
+  gameObjects.spaceShip->direction.y = sin(angle);
+}
+
+void turnSpaceShipRight(float deltaAngle) {
+
+  gameObjects.spaceShip->viewAngle -= deltaAngle;
+
+  if(gameObjects.spaceShip->viewAngle < 0.0f)
+    gameObjects.spaceShip->viewAngle += 360.0f;
+
+  float angle = glm::radians(gameObjects.spaceShip->viewAngle);
+
+  gameObjects.spaceShip->direction.x = cos(angle);
+  gameObjects.spaceShip->direction.y = sin(angle);
+}
+
+void teleport(void) {
+
+  // generate new space ship position randomly
+  gameObjects.spaceShip->position = glm::vec3(
+    (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+    (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+    0.0f
+  );
+}
+
+void cleanUpObjects(void) {
+
+  // delete asteroids
+  clearObjects(gameObjects.asteroids);
+
+  // delete missiles
+  clearObjects(gameObjects.missiles);
+
+  // delete ufos
+  clearObjects(gameObjects.ufos);
+
+  // delete explosions
+  clearObjects(gameObjects.explosions);
+
+  // remove banner
+  gameObjects.bannerObject = NULL;
+}
+
+static void appendPoolReport(std::string &report, const char* name, const ObjectPool &pool, float seconds) {
+
+  char line[128];
+  snprintf(line, sizeof(line), "%-10s  %6u %6u %8u %9.1f %8llu\n", name, objectCount(pool), pool.stats.peak,
+    pool.capacity, (seconds > 0.0f) ? pool.stats.inserted / seconds : 0.0f, pool.stats.rejected);
+
+  report += line;
+}
+
+std::string objectPoolReport(float seconds) {
+
+  std::string report = "pool          live   peak capacity inserts/s rejected\n";
+
+  appendPoolReport(report, "asteroids", gameObjects.asteroids, seconds);
+  appendPoolReport(report, "missiles", gameObjects.missiles, seconds);
+  appendPoolReport(report, "ufos", gameObjects.ufos, seconds);
+  appendPoolReport(report, "explosions", gameObjects.explosions, seconds);
+
+  return report;
+}
+
+// generates random position that does not collide with the spaceship
+glm::vec3 generateRandomPosition(void) {
+ glm::vec3 newPosition;
+  bool invalidPosition = false;
+
+  do {
+
+    // position is generated randomly
+    // coordinates are in range -1.0f ... 1.0f
+    newPosition = glm::vec3(
+      (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+      (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+      0.0f
+    );
+    invalidPosition = pointInSphere(newPosition, gameObjects.spaceShip->position, 3.0f*SPACESHIP_SIZE);
+
+  } while (invalidPosition == true);
+
+  return newPosition;
+}
+
+AsteroidObject createAsteroid(void) {
+ AsteroidObject newAsteroid;
+
+  newAsteroid.destroyed = false;
+
+  newAsteroid.startTime = gameState.elapsedTime;
+  newAsteroid.currentTime = newAsteroid.startTime;
+
+  newAsteroid.size = ASTEROID_SIZE;
+
+  // generate motion direction randomly in range -1.0f ... 1.0f
+  newAsteroid.direction = glm::vec3(
+    (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+    (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+    0.0f
+  );
+  newAsteroid.direction = glm::normalize(newAsteroid.direction);
+
+  // position is generated randomly as well
+  newAsteroid.position = generateRandomPosition();
+
+  // motion speed 0.0f ... 1.0f
+  newAsteroid.speed = ASTEROID_SPEED_MAX * (float)(simulationRandom() / (double)SIMULATION_RANDOM_MAX);
+  // rotation speed 0.0f ... 1.0f
+  newAsteroid.rotationSpeed = ASTEROID_ROTATION_SPEED_MAX * (float)(simulationRandom() / (double)SIMULATION_RANDOM_MAX);
+
+  return newAsteroid;
+}
+
+UfoObject createUfo(void) {
+ UfoObject newUfo;
+
+  newUfo.destroyed = false;
+
+  newUfo.startTime = gameState.elapsedTime;
+  newUfo.currentTime = newUfo.startTime;
+
+  newUfo.size = UFO_SIZE;
+
+  // generate initial position randomly
+  newUfo.initPosition = generateRandomPosition();
+  newUfo.position = newUfo.initPosition;
+  // random speed in range 0.0f ... 1.0f
+  newUfo.speed = (float)(simulationRandom() / (double)SIMULATION_RANDOM_MAX);
+  // random rotation speed in range 0.0f ... 1.0f
+  newUfo.rotationSpeed = UFO_ROTATION_SPEED_MAX * (float)(simulationRandom() / (double)SIMULATION_RANDOM_MAX);
+
+  // generate randomly in range -1.0f ... 1.0f
+  newUfo.direction = glm::vec3(
+    (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+    (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+    0.0f
+  );
+  newUfo.direction = glm::normalize(newUfo.direction);
+
+  return newUfo;
+}
+
+void initializeSimulation(unsigned int seed) {
+
+  // initialize random seed
+  seedSimulationRandom(seed);
+  commandQueue.count = 0;
+
+  gameObjects.spaceShip = NULL;
+  gameObjects.bannerObject = NULL;
+
+  gameState.collisionMode = COLLISIONS_GRID;
+
+  buildCurveArcLengthTable(curveData, curveSize, UFO_CURVE_SAMPLES_PER_SEGMENT, ufoCurve);
+}
+
+void finalizeSimulation(void) {
+
+  cleanUpObjects();
+
+  gameObjects.spaceShip = NULL;
+}
+
+void resetSimulation(float elapsedTime, unsigned int asteroidCount) {
+
+  cleanUpObjects();
+  resetKineticCollisions(collisionBroadphase.kinetic);
+
+  gameState.elapsedTime = elapsedTime;
+
+  // pools keep their storage from the previous game, only a larger scene needs more
+  reserveObjects(gameObjects.asteroids, asteroidCount + ASTEROIDS_CAPACITY);
+  reserveObjects(gameObjects.missiles, MISSILES_CAPACITY);
+  reserveObjects(gameObjects.ufos, UFOS_CAPACITY);
+  reserveObjects(gameObjects.explosions, EXPLOSIONS_CAPACITY);
+
+  // initialize space ship
+  gameObjects.spaceShip = &spaceShipStorage;
+
+  gameObjects.spaceShip->position = glm::vec3(0.0f, 0.0f, 0.0f);
+  gameObjects.spaceShip->viewAngle = 90.0f; // degrees
+  gameObjects.spaceShip->direction = glm::vec3(cos(glm::radians(gameObjects.spaceShip->viewAngle)), sin(glm::radians(gameObjects.spaceShip->viewAngle)), 0.0f);
+  gameObjects.spaceShip->speed = 0.0f;
+  gameObjects.spaceShip->size = SPACESHIP_SIZE;
+  gameObjects.spaceShip->destroyed = false;
+  gameObjects.spaceShip->startTime = gameState.elapsedTime;
+  gameObjects.spaceShip->currentTime = gameObjects.spaceShip->startTime;
+
+  // initialize asteroids
+  for(unsigned int i=0; i<asteroidCount; i++) {
+    insertObject(gameObjects.asteroids, createAsteroid());
+  }
+
+  // reset key map
+  for(int i=0; i<KEYS_COUNT; i++)
+    gameState.keyMap[i] = false;
+
+  gameState.gameOver = false;
+  gameState.missileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
+  gameState.ufoMissileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
+}
+
+static void hashBytes(unsigned int &hash, const void *data, size_t size) {
+
+  const unsigned char *bytes = (const unsigned char*)data;
+  for(size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV32_PRIME;
+  }
+}
+
+static void hashPool(unsigned int &hash, const ObjectPool &pool) {
+
+  const unsigned int count = objectCount(pool);
+  hashBytes(hash, &count, sizeof(count));
+  if(count > 0) {
+    hashBytes(hash, &pool.position[0], count * sizeof(glm::vec3));
+    hashBytes(hash, &pool.destroyed[0], count * sizeof(unsigned char));
+  }
+}
+
+unsigned int simulationStateHash(void) {
+
+  unsigned int hash = FNV32_OFFSET_BASIS;
+
+  hashBytes(hash, &gameState.gameOver, sizeof(gameState.gameOver));
+  hashBytes(hash, &randomState, sizeof(randomState));
+
+  if(gameObjects.spaceShip != NULL) {
+    hashBytes(hash, &gameObjects.spaceShip->position, sizeof(glm::vec3));
+    hashBytes(hash, &gameObjects.spaceShip->direction, sizeof(glm::vec3));
+    hashBytes(hash, &gameObjects.spaceShip->speed, sizeof(float));
+  }
+
+  hashPool(hash, gameObjects.asteroids);
+  hashPool(hash, gameObjects.missiles);
+  hashPool(hash, gameObjects.ufos);
+  hashPool(hash, gameObjects.explosions);
+
+  return hash;
+}
+
+bool queueCommand(GameCommand command, unsigned int argument) {
+
+  if(commandQueue.count >= TICK_COMMANDS_MAX)
+    return false;
+
+  commandQueue.command[commandQueue.count] = (unsigned char)command;
+  commandQueue.argument[commandQueue.count] = argument;
+  commandQueue.count++;
+
+  return true;
+}
+
+TickInput gatherTickInput(float elapsedTime) {
+
+  TickInput input;
+
+  input.elapsedTime = elapsedTime;
+
+  input.keys = 0;
+  for(int i = 0; i < KEYS_COUNT; i++) {
+    if(gameState.keyMap[i] == true)
+      input.keys |= (unsigned char)(1 << i);
+  }
+
+  bool restarted = false;
+  input.commandCount = 0;
+
+  for(unsigned int i = 0; i < commandQueue.count; i++) {
+    unsigned int argument = commandQueue.argument[i];
+
+    if(commandQueue.command[i] == COMMAND_RESTART)
+      restarted = true;
+
+    // handles depend on the history of the pool, dense indices only on the current game
+    // -> the recorded index is valid in any replay, an asteroid gone since the click is dropped
+    if(commandQueue.command[i] == COMMAND_DESTROY_ASTEROID) {
+      argument = objectIndex(gameObjects.asteroids, argument);
+      if(argument == INVALID_OBJECT_INDEX || restarted == true)
+        continue;
+    }
+
+    input.command[input.commandCount] = commandQueue.command[i];
+    input.argument[input.commandCount] = argument;
+    input.commandCount++;
+  }
+
+  commandQueue.count = 0;
+
+  return input;
+}
+
+static void applyCommand(unsigned char command, unsigned int argument) {
+
+  switch(command) {
+    case COMMAND_RESTART:
+      resetSimulation(gameState.elapsedTime, argument);
+      break;
+    case COMMAND_TELEPORT:
+      if(gameState.gameOver != true)
+        teleport();
+      break;
+    case COMMAND_EXPLOSION: {
+        glm::vec3 explosionPosition = glm::vec3(
+          (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+          (float)(2.0 * (simulationRandom() / (double)SIMULATION_RANDOM_MAX) - 1.0),
+          0.0f
+        );
+        insertExplosion(explosionPosition);
+      }
+      break;
+    case COMMAND_GAME_OVER:
+      gameState.gameOver = true;
+      break;
+    case COMMAND_DESTROY_ASTEROID:
+      if(argument < objectCount(gameObjects.asteroids) && gameObjects.asteroids.destroyed[argument] == false) {
+        gameObjects.asteroids.destroyed[argument] = true;          // remove asteroid
+        insertExplosion(gameObjects.asteroids.position[argument]); // insert explosion billboard
+      }
+      break;
+    case COMMAND_COLLISION_MODE:
+      if(argument < COLLISION_MODES_COUNT)
+        gameState.collisionMode = (int)argument;
+      break;
+    default:
+      ;
+  }
+}
+
+void createMissile(const glm::vec3 &missilePosition, const glm::vec3 &missileDirection, float &missileLaunchTime) {
+
+  float currentTime = gameState.elapsedTime;
+  if(currentTime-missileLaunchTime < MISSILE_LAUNCH_TIME_DELAY)
+    return;
+
+  missileLaunchTime = currentTime;
+
+  MissileObject newMissile;
+
+  newMissile.destroyed   = false;
+  newMissile.startTime   = gameState.elapsedTime;
+  newMissile.currentTime = newMissile.startTime;
+  newMissile.size        = MISSILE_SIZE;
+  newMissile.speed       = MISSILE_SPEED;
+  newMissile.position    = missilePosition;
+  newMissile.direction   = glm::normalize(missileDirection);
+  
+  insertObject(gameObjects.missiles, newMissile);
+}
+
+BannerObject* createBanner(void) {
+ BannerObject* newBanner = &bannerStorage;
+ 
+  newBanner->size = BANNER_SIZE;
+  newBanner->position = glm::vec3(0.0f, 0.0f, 0.0f);
+  newBanner->direction = glm::vec3(0.0f, 1.0f, 0.0f);
+  newBanner->speed = 0.0f;
+  newBanner->size = 1.0f;
+
+  newBanner->destroyed = false;
+
+  newBanner->startTime = gameState.elapsedTime;
+  newBanner->currentTime = newBanner->startTime;
+
+  return newBanner;
+}
+
+// Collects indices of objects (lower than count) that have to be tested against the missile at the given position.
+// Candidates are returned in ascending order, i.e. in the order the brute force loop visits the objects.
+void gatherCandidates(bool useGrid, const CollisionGrid &grid, const ObjectPool &objects, const glm::vec3 &missilePosition, unsigned int count, std::vector<unsigned int> &candidates) {
+
+  if(useGrid == false) {
+    candidates.resize(count);
+    for(unsigned int i = 0; i < count; i++)
+      candidates[i] = i;
+    return;
+  }
+
+  queryCollisionGrid(grid, missilePosition, 0.0f, candidates);
+
+  // objects created after the grid was built (asteroid parts) are not in the grid -> test them all
+  for(unsigned int i = grid.objectCount; i < count; i++)
+    candidates.push_back(i);
+
+  if(gameState.collisionMode == COLLISIONS_VERIFY) {
+    // each object hit by the missile must be among the candidates
+    for(unsigned int i = 0; i < count; i++) {
+      if(objects.destroyed[i] == false && pointInSphere(missilePosition, objects.position[i], objects.size[i]) == true) {
+        if(std::binary_search(candidates.begin(), candidates.end(), i) == false)
+          printf("Collision grid missed object %u hit by missile at [%f, %f, %f]\n", i, missilePosition.x, missilePosition.y, missilePosition.z);
+      }
+    }
+  }
+}
+
+// Applies the contacts of missiles and the space ship with asteroids predicted up to the current time.
+// Objects are hit where they meet between the steps, so fast missiles cannot pass small asteroids.
+static void processKineticCollisions(void) {
+
+  AsteroidPool &asteroids = gameObjects.asteroids;
+  MissilePool  &missiles  = gameObjects.missiles;
+  KineticCollisions &kinetic = collisionBroadphase.kinetic;
+
+  syncKineticCollisions(kinetic, asteroids, missiles, *gameObjects.spaceShip, gameState.elapsedTime);
+
+  KineticContact contact;
+  while(nextKineticContact(kinetic, asteroids, missiles, gameState.elapsedTime, contact) == true) {
+    const unsigned int a = objectIndex(asteroids, contact.asteroid);
+
+    asteroids.destroyed[a] = true;              // mark asteroid dead
+    insertExplosion(contact.objectPosition);    // insert explosion billboard
+
+    if(contact.kind == KINETIC_SPACESHIP) {
+      gameState.gameOver = true;                // -> game over
+      continue;
+    }
+
+    missiles.destroyed[objectIndex(missiles, contact.object)] = true;
+
+    // asteroid break-up into random number of parts
+    if(asteroids.size[a] > ASTEROID_SIZE_MIN) {
+      int howManyAsteroids = simulationRandom() % ASTEROID_PARTS + 1;
+
+      for(int i=0; i<howManyAsteroids; i++) {
+        AsteroidObject newAsteroid = createAsteroid();
+
+        // parts start at the contact, the pool keeps them at the current time like all other objects
+        newAsteroid.size = asteroids.size[a] * ASTEROID_SIZE_FACTOR;
+        newAsteroid.position = checkBounds(contact.asteroidPosition + (gameState.elapsedTime - contact.time) * newAsteroid.speed * newAsteroid.direction, newAsteroid.size);
+
+        const ObjectHandle handle = insertObject(asteroids, newAsteroid);
+        insertKineticAsteroid(kinetic, asteroids, missiles, handle, contact.asteroidPosition, contact.time);
+      }
+    }
+  }
+}
+
+// Test collisons between objects in the scene and insert explosion billboards.
+void checkCollisions(void) {
+
+  AsteroidPool &asteroids = gameObjects.asteroids;
+  MissilePool  &missiles  = gameObjects.missiles;
+  UfoPool      &ufos      = gameObjects.ufos;
+
+  const bool kinetic = (gameState.collisionMode == COLLISIONS_KINETIC);
+
+  // predicted contacts replace the tests of asteroids against the space ship and the missiles below
+  if(kinetic == true)
+    processKineticCollisions();
+  else
+    collisionBroadphase.kinetic.active = false; // trajectories are taken again when the mode is switched back
+
+  // test collisions between asteroid and spaceship
+  for(unsigned int a = 0; a < objectCount(asteroids) && kinetic == false; a++) {
+
+    if(asteroids.destroyed[a] == false) {
+      // check whether a given asteroid collides with spaceship or not
+      // calls spheresIntersection() function with appropriate parameters
+      if(spheresIntersection(gameObjects.spaceShip->position, gameObjects.spaceShip->size, asteroids.position[a], asteroids.size[a]) == true) {
+        asteroids.destroyed[a] = true;	                   // mark asteroid dead
+        insertExplosion(gameObjects.spaceShip->position);  // insert explostion billboard
+        gameState.gameOver = true;                         // -> game over
+      }
+    }
+  }
+
+  // test collisions beween ufo and spaceship
+  for(unsigned int u = 0; u < objectCount(ufos); u++) {
+
+    if(ufos.destroyed[u] == false) {
+      // check whether a given ufo collides with spaceship or not
+      // calls spheresIntersection() function with appropriate parameters
+      if(spheresIntersection(gameObjects.spaceShip->position, gameObjects.spaceShip->size, ufos.position[u], ufos.size[u]) == true) {
+        ufos.destroyed[u] = true;	                         // mark ufo dead
+        insertExplosion(gameObjects.spaceShip->position);  // insert explosion billboard
+        gameState.gameOver = true;                         // -> game over
+      }
+    }
+  }
+
+  // check collisions missile x asteroid and missile x ufo
+  // broadphase selects candidates (either all objects or objects from the neighboring grid cells)
+  // and the narrowphase tests are the same for all modes -> all modes give identical results
+  std::vector<unsigned int> &candidates = collisionBroadphase.candidates;
+
+  // grids are queried by missiles only -> not built in steps without them or with a few tests only,
+  // the verification always uses them
+  const unsigned int missileCount = objectCount(missiles);
+  const bool gridMode = (gameState.collisionMode != COLLISIONS_BRUTE_FORCE);
+  const bool verify = (gameState.collisionMode == COLLISIONS_VERIFY);
+  const bool asteroidGrid = gridMode && kinetic == false && missileCount > 0 &&
+    (verify || missileCount * objectCount(asteroids) >= COLLISION_GRID_MIN_TESTS);
+  const bool ufoGrid = gridMode && missileCount > 0 &&
+    (verify || missileCount * objectCount(ufos) >= COLLISION_GRID_MIN_TESTS);
+
+  if(asteroidGrid == true)
+    buildCollisionGrid(collisionBroadphase.asteroidGrid, asteroids.position.data(), asteroids.size.data(), objectCount(asteroids));
+  if(ufoGrid == true)
+    buildCollisionGrid(collisionBroadphase.ufoGrid, ufos.position.data(), ufos.size.data(), objectCount(ufos));
+
+  for(unsigned int m = 0; m < objectCount(missiles); m++) {
+
+    // missile has already hit an asteroid between the steps
+    if(kinetic == true && missiles.destroyed[m] == true)
+      continue;
+
+    // test missile with each asteroid
+    // asteroids created by the break-up below are appended behind asteroidCount and are not tested by this missile
+    const unsigned int asteroidCount = objectCount(asteroids);
+    if(kinetic == false)
+      gatherCandidates(asteroidGrid, collisionBroadphase.asteroidGrid, asteroids, missiles.position[m], asteroidCount, candidates);
+    else
+      candidates.clear(); // hits were predicted by processKineticCollisions()
+
+    for(size_t c = 0; c < candidates.size(); c++) {
+      const unsigned int a = candidates[c];
+
+      if(asteroids.destroyed[a] == false) {
+        // check whether a given missile hits asteroid or not
+        // calls pointInSphere() function with proper parameters
+        if(pointInSphere(missiles.position[m], asteroids.position[a], asteroids.size[a]) == true) {	
+          missiles.destroyed[m] = true;                // remove missile
+          asteroids.destroyed[a] = true;               // remove asteroid
+          insertExplosion(missiles.position[m]);       // insert explosion billboard
+
+          // asteroid break-up into random number of parts
+          if(asteroids.size[a] > ASTEROID_SIZE_MIN) {
+            int howManyAsteroids = simulationRandom() % ASTEROID_PARTS + 1;
+
+            for(int i=0; i<howManyAsteroids; i++) {
+              AsteroidObject newAsteroid = createAsteroid();
+
+              // same position, smaller size
+              newAsteroid.position = asteroids.position[a];
+              newAsteroid.size = asteroids.size[a] * ASTEROID_SIZE_FACTOR;
+
+              insertObject(asteroids, newAsteroid);
+            }
+          }
+        }
+      }
+    }
+
+    // test missile against each ufo
+    gatherCandidates(ufoGrid, collisionBroadphase.ufoGrid, ufos, missiles.position[m], objectCount(ufos), candidates);
+
+    for(size_t c = 0; c < candidates.size(); c++) {
+      const unsigned int u = candidates[c];
+
+      if(ufos.destroyed[u] == false) {
+        // check whether a given missile hits ufo or not
+        // calls pointInSphere() function with proper parameters
+        if(pointInSphere(missiles.position[m], ufos.position[u], ufos.size[u]) == true) {
+          missiles.destroyed[m] = true;           // remove missile
+          ufos.destroyed[u] = true;               // mark ufo dead
+          insertExplosion(missiles.position[m]);  // insert explosion billboard
+        }
+      }
+    }
+
+    // check whether a given missile hits spaceship or not
+    // calls pointInSphere() function with proper parameters
+    if(pointInSphere(missiles.position[m], gameObjects.spaceShip->position, gameObjects.spaceShip->size) == true) {
+      missiles.destroyed[m] = true;           // remove missile
+      insertExplosion(missiles.position[m]);  // insert explosion billboard
+      gameState.gameOver = true;              // -> game over
+    }
+  }
+}
+
+void updateObjects(float elapsedTime) {
+
+  // update space ship 
+  float timeDelta = elapsedTime - gameObjects.spaceShip->currentTime;
+  gameObjects.spaceShip->currentTime = elapsedTime;
+  gameObjects.spaceShip->position += timeDelta * gameObjects.spaceShip->speed * gameObjects.spaceShip->direction;
+
+  // check the new position and wrap it if it is necessary
+  gameObjects.spaceShip->position = checkBounds(gameObjects.spaceShip->position, gameObjects.spaceShip->size);
+
+  // update asteroids
+  AsteroidPool &asteroids = gameObjects.asteroids;
+
+  removeDestroyedObjects(asteroids);
+
+  // objects are independent of each other -> loops are split among the job system threads,
+  // each item is written by exactly one thread, so the results do not depend on the thread count
+  parallelFor(objectCount(asteroids), UPDATE_GRAIN_SIZE, [&asteroids, elapsedTime](unsigned int begin, unsigned int end) {
+    for(unsigned int i = begin; i < end; i++) {
+      float timeDelta = elapsedTime - asteroids.currentTime[i];
+
+      asteroids.currentTime[i] = elapsedTime;
+      asteroids.position[i] += timeDelta * asteroids.speed[i] * asteroids.direction[i];
+
+      // check the new position and wrap it if it is necessary
+      asteroids.position[i] = checkBounds(asteroids.position[i], asteroids.size[i]);
+    }
+  });
+
+  // update missiles
+  MissilePool &missiles = gameObjects.missiles;
+
+  parallelFor(objectCount(missiles), UPDATE_GRAIN_SIZE, [&missiles, elapsedTime](unsigned int begin, unsigned int end) {
+    for(unsigned int i = begin; i < end; i++) {
+      float timeDelta = elapsedTime - missiles.currentTime[i];
+
+      missiles.currentTime[i] = elapsedTime;
+      missiles.position[i] += timeDelta * missiles.speed[i] * missiles.direction[i];
+
+      // check the new position and wrap it if it is necessary
+      missiles.position[i] = checkBounds(missiles.position[i], missiles.size[i]);
+
+      if((missiles.currentTime[i]-missiles.startTime[i])*missiles.speed[i] > MISSILE_MAX_DISTANCE) 
+        missiles.destroyed[i] = true;
+    }
+  });
+
+  removeDestroyedObjects(missiles);
+
+  // update ufos
+  UfoPool &ufos = gameObjects.ufos;
+
+  removeDestroyedObjects(ufos);
+
+  // ufo speed is given in curve parameter units per second -> the same average speed in distance units
+  const float ufoLengthPerParameter = ufoCurve.totalLength / float(curveSize);
+
+  // curve evaluation is more expensive -> smaller chunks
+  parallelFor(objectCount(ufos), UPDATE_GRAIN_SIZE / 4, [&ufos, elapsedTime, ufoLengthPerParameter](unsigned int begin, unsigned int end) {
+    float distances[UFO_CURVE_BATCH];
+
+    for(unsigned int batch = begin; batch < end; batch += UFO_CURVE_BATCH) {
+      const unsigned int batchEnd = std::min(end, batch + UFO_CURVE_BATCH);
+
+      for(unsigned int i = batch; i < batchEnd; i++) {
+        ufos.currentTime[i] = elapsedTime;
+        distances[i - batch] = ufoLengthPerParameter * ufos.speed[i] * (ufos.currentTime[i] - ufos.startTime[i]);
+      }
+
+      // positions on the curve are written first, then moved to the ufo start
+      evaluateClosedCurveByArcLength(ufoCurve, distances, batchEnd - batch, &ufos.position[batch], &ufos.direction[batch]);
+
+      for(unsigned int i = batch; i < batchEnd; i++) {
+        // check the new position and wrap it if it is necessary
+        ufos.position[i] = checkBounds(ufos.initPosition[i] + ufos.position[i], ufos.size[i]);
+      }
+    }
+  });
+
+  // update explosion billboards
+  ExplosionPool &explosions = gameObjects.explosions;
+
+  parallelFor(objectCount(explosions), UPDATE_GRAIN_SIZE, [&explosions, elapsedTime](unsigned int begin, unsigned int end) {
+    for(unsigned int i = begin; i < end; i++) {
+      explosions.currentTime[i] = elapsedTime;
+
+      if(explosions.currentTime[i] > explosions.startTime[i] + explosions.textureFrames[i]*explosions.frameDuration[i])
+        explosions.destroyed[i] = true;
+    }
+  });
+
+  removeDestroyedObjects(explosions);
+}
+
+void simulationStep(float elapsedTime) {
+
+  simulationStep(gatherTickInput(elapsedTime));
+}
+
+void simulationStep(const TickInput &input) {
+
+  beginProfile(PROFILE_TICK);
+
+  // update scene time
+  gameState.elapsedTime = input.elapsedTime;
+
+  // key map of the step, a restart below releases all keys
+  for(int i = 0; i < KEYS_COUNT; i++)
+    gameState.keyMap[i] = (input.keys & (1 << i)) != 0;
+
+  for(unsigned int i = 0; i < input.commandCount; i++)
+    applyCommand(input.command[i], input.argument[i]);
+
+  // call appropriate actions according to the currently pressed keys in key map
+  // (combinations of keys are supported but not used in this implementation)
+  if(gameState.keyMap[KEY_RIGHT_ARROW] == true)
+    turnSpaceShipRight(SPACESHIP_VIEW_ANGLE_DELTA);
+
+  if(gameState.keyMap[KEY_LEFT_ARROW] == true)
+    turnSpaceShipLeft(SPACESHIP_VIEW_ANGLE_DELTA);
+
+  if(gameState.keyMap[KEY_UP_ARROW] == true)
+    increaseSpaceShipSpeed();
+
+  if(gameState.keyMap[KEY_DOWN_ARROW] == true)
+    decreaseSpaceShipSpeed();
+
+  if((gameState.gameOver == true) && (gameObjects.bannerObject != NULL)) {
+    gameObjects.bannerObject->currentTime = gameState.elapsedTime;
+  }
+
+  // update objects in the scene
+  beginProfile(PROFILE_UPDATE);
+  updateObjects(gameState.elapsedTime);
+  endProfile(PROFILE_UPDATE);
+
+  beginProfile(PROFILE_SPAWN);
+
+  // space pressed -> launch missile
+  if(gameState.keyMap[KEY_SPACE] == true) {
+    // missile position and direction
+    glm::vec3 missilePosition = gameObjects.spaceShip->position;
+    glm::vec3 missileDirection = gameObjects.spaceShip->direction;
+
+    missilePosition += missileDirection*1.5f*SPACESHIP_SIZE;
+
+    createMissile(missilePosition, missileDirection, gameState.missileLaunchTime);
+  }
+
+  endProfile(PROFILE_SPAWN);
+
+  // test collisions among objects in the scene
+  beginProfile(PROFILE_COLLISIONS);
+  checkCollisions();
+  endProfile(PROFILE_COLLISIONS);
+
+  beginProfile(PROFILE_SPAWN);
+
+  // generate new ufos randomly
+  if(objectCount(gameObjects.ufos) < UFOS_COUNT_MIN) {
+    int howManyUfos = simulationRandom() % (UFOS_COUNT_MAX - UFOS_COUNT_MIN + 1);
+
+    for(int i=0; i<howManyUfos; i++) {
+      insertObject(gameObjects.ufos, createUfo());
+    }
+  }
+
+  if(objectCount(gameObjects.ufos) > 0 && (simulationRandom() % 100) == 0) { // generate ufo missile or not?
+    unsigned int ufoIndex = simulationRandom() % objectCount(gameObjects.ufos); // which ufo should shoot?
+
+    // missile position and direction
+    glm::vec3 missilePosition = gameObjects.ufos.position[ufoIndex];
+    glm::vec3 missileDirection = gameObjects.ufos.direction[ufoIndex];
+
+    missilePosition += missileDirection*1.5f*UFO_SIZE;
+
+    createMissile(missilePosition, missileDirection, gameState.ufoMissileLaunchTime);
+  }
+
+  // generate new asteroids randomly
+  if(objectCount(gameObjects.asteroids) < ASTEROIDS_COUNT_MIN) {
+    int howManyAsteroids = simulationRandom() % (ASTEROIDS_COUNT_MAX - ASTEROIDS_COUNT_MIN + 1);
+
+    for(int i=0; i<howManyAsteroids; i++) {
+      insertObject(gameObjects.asteroids, createAsteroid());
+    }
+  }
+
+  endProfile(PROFILE_SPAWN);
+
+  // game over? -> create banner with scrolling text "game over"
+  if(gameState.gameOver == true) {
+    gameState.keyMap[KEY_SPACE] = false;
+    if(gameObjects.bannerObject == NULL) {
+      // if game over and banner still not created -> create banner
+      gameObjects.bannerObject = createBanner();
+    }
+  }
+
+  endProfile(PROFILE_TICK);
+  profileCommit(PROFILE_SIMULATION_FIRST, PROFILE_SIMULATION_LAST);
+}
@@ -0,0 +1,156 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    simulation.h
+ * \brief   Game logic of the Asteroids game - object updates, collisions and spawning.
+ *
+ * Nothing in here touches OpenGL or GLUT, so the simulation can be stepped without a window.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __SIMULATION_H
+#define __SIMULATION_H
+
+#include <string>
+#include "data.h"
+#include "object_pool.h"
+#include "collision_grid.h"
+#include "spline.h"
+
+// how missile hits are searched for in checkCollisions()
+enum CollisionMode {
+  COLLISIONS_BRUTE_FORCE, // each missile is tested against all asteroids and ufos
+  COLLISIONS_GRID,        // candidates are taken from the uniform grid broadphase, small pools are tested by brute force
+  COLLISIONS_VERIFY,      // grid is used and its candidates are compared against the brute force results
+  COLLISIONS_KINETIC,     // missile and space ship contacts with asteroids are predicted, ufos use the grid
+  COLLISION_MODES_COUNT
+};
+
+extern const char* collisionModeNames[COLLISION_MODES_COUNT];
+
+// capacities of the object pools, reserved by resetSimulation() -> spawning objects never allocates memory
+// - asteroids: ASTEROIDS_COUNT_MAX asteroids with all their parts, each asteroid breaks up twice at most
+//   (scenes started with more asteroids get this much room on top of the initial asteroids)
+// - missiles: the space ship and the ufos launch one missile per MISSILE_LAUNCH_TIME_DELAY each at most
+// - explosions are decoration only, explosions not fitting into the pool are dropped
+#define ASTEROIDS_CAPACITY   (ASTEROIDS_COUNT_MAX * (1 + ASTEROID_PARTS + ASTEROID_PARTS * ASTEROID_PARTS))
+#define MISSILES_CAPACITY    (2 * ((unsigned int)(MISSILE_MAX_DISTANCE / (MISSILE_SPEED * MISSILE_LAUNCH_TIME_DELAY)) + 2))
+#define UFOS_CAPACITY        UFOS_COUNT_MAX
+#define EXPLOSIONS_CAPACITY  256
+
+// player actions changing the game besides the key map - they are queued by the input callbacks and
+// applied at the beginning of the next simulation step, so that all inputs of a step can be recorded
+enum GameCommand {
+  COMMAND_RESTART,          // argument: number of asteroids of the new game
+  COMMAND_TELEPORT,
+  COMMAND_EXPLOSION,        // explosion at a random position
+  COMMAND_GAME_OVER,
+  COMMAND_DESTROY_ASTEROID, // argument: handle of the asteroid when queued, dense index in TickInput
+  COMMAND_COLLISION_MODE,   // argument: CollisionMode
+  GAME_COMMANDS_COUNT
+};
+
+// commands applied by one simulation step at most, further commands are refused by queueCommand()
+#define TICK_COMMANDS_MAX 8
+
+// everything a simulation step depends on besides the game state and the random generator
+struct TickInput {
+  float         elapsedTime;
+  unsigned char keys;                         // bit (1 << KEY_*) set for each pressed key
+  unsigned char commandCount;
+  unsigned char command[TICK_COMMANDS_MAX];   // GameCommand
+  unsigned int  argument[TICK_COMMANDS_MAX];
+};
+
+struct GameState {
+
+  int windowWidth;    // set by reshape callback
+  int windowHeight;   // set by reshape callback
+
+  bool freeCameraMode;        // false;
+  float cameraElevationAngle; // in degrees = initially 0.0f
+
+  bool gameOver;              // false;
+  bool keyMap[KEYS_COUNT];    // false
+
+  float elapsedTime;
+  float missileLaunchTime;
+  float ufoMissileLaunchTime;
+
+  int collisionMode;          // COLLISIONS_GRID
+
+};
+
+struct GameObjects {
+
+  SpaceShipObject *spaceShip; // NULL, points to static storage while the game runs
+
+  AsteroidPool asteroids;
+  MissilePool  missiles;
+  UfoPool      ufos;
+
+  ExplosionPool explosions;
+  BannerObject* bannerObject; // NULL, points to static storage once the game is over
+};
+
+extern GameState   gameState;
+extern GameObjects gameObjects;
+
+// ufos follow curveData with constant speed, built by initializeSimulation()
+extern CurveArcLengthTable ufoCurve;
+
+bool pointInSphere(const glm::vec3 &point, const glm::vec3 &center, float radius);
+bool spheresIntersection(const glm::vec3 &center1, float radius1, const glm::vec3 &center2, float radius2);
+
+void insertExplosion(const glm::vec3 &position);
+
+// called by insertExplosion() for each explosion, lets the renderer add its effects (e.g. particles)
+typedef void (*ExplosionListener)(const glm::vec3 &position, float time);
+void setExplosionListener(ExplosionListener listener);
+
+void increaseSpaceShipSpeed(float deltaSpeed = SPACESHIP_SPEED_INCREMENT);
+void decreaseSpaceShipSpeed(float deltaSpeed = SPACESHIP_SPEED_INCREMENT);
+void turnSpaceShipLeft(float deltaAngle);
+void turnSpaceShipRight(float deltaAngle);
+void teleport(void);
+
+AsteroidObject createAsteroid(void);
+UfoObject createUfo(void);
+void createMissile(const glm::vec3 &missilePosition, const glm::vec3 &missileDirection, float &missileLaunchTime);
+BannerObject* createBanner(void);
+
+void cleanUpObjects(void);
+
+// returns false if the queue of the next step is full and the command was dropped
+bool queueCommand(GameCommand command, unsigned int argument = 0);
+
+// takes the key map and the queued commands as the input of a step at the given time
+TickInput gatherTickInput(float elapsedTime);
+
+// hash of the object positions, the space ship and the random generator state - equal hashes after
+// each step of a replay show that the replay follows the recorded game exactly
+unsigned int simulationStateHash(void);
+
+// table with live, peak and capacity of each object pool, insertions per second over the given time
+// and insertions refused because the pool was full
+std::string objectPoolReport(float seconds);
+
+// sets the initial state of the simulation, seeds the random generator used by the game logic
+void initializeSimulation(unsigned int seed);
+// restarts the random generator of the game logic, e.g. at the beginning of a recording or a replay
+void seedSimulationRandom(unsigned int seed);
+// releases all objects including the space ship
+void finalizeSimulation(void);
+
+// starts a new game at the given time with a given number of asteroids
+void resetSimulation(float elapsedTime, unsigned int asteroidCount = ASTEROIDS_COUNT_MIN);
+
+void checkCollisions(void);
+void updateObjects(float elapsedTime);
+
+// advances the game to the given time - applies the key map to the space ship, updates objects,
+// launches missiles, tests collisions, and spawns new asteroids and ufos
+void simulationStep(float elapsedTime);
+// the same step driven by the given input instead of the current key map and command queue
+void simulationStep(const TickInput &input);
+
+#endif // __SIMULATION_H
@@ -9,6 +9,12 @@
 
 #include "spline.h"
 
+// SSE2 is part of every x86-64 target
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPLINE_USE_SSE
+#endif
+
 //**************************************************************************************************
 /// Checks whether vector is zero-length or not.
 bool isVectorNull(const glm::vec3 &vect) {
@@ -216,6 +222,345 @@ glm::vec3 evaluateClosedCurve_1stDerivative(
   return result;
 }
 
+//**************************************************************************************************
+/// Computes the polynomial coefficients of a Catmull-Rom curve segment.
+/**
+  \param[in] P0       First control point of the curve segment.
+  \param[in] P1       Second control point of the curve segment.
+  \param[in] P2       Third control point of the curve segment.
+  \param[in] P3       Fourth control point of the curve segment.
+  \return             Coefficients of the segment.
+*/
+CurveSegmentCoefficients computeCurveSegmentCoefficients(
+    const glm::vec3& P0,
+    const glm::vec3& P1,
+    const glm::vec3& P2,
+    const glm::vec3& P3
+) {
+  CurveSegmentCoefficients segment;
+
+  // the basis matrix of evaluateCurveSegment() multiplied by the control points
+  const glm::vec3 a = 0.5f * (-P0 + 3.0f*P1 - 3.0f*P2 + P3);
+  const glm::vec3 b = 0.5f * (2.0f*P0 - 5.0f*P1 + 4.0f*P2 - P3);
+  const glm::vec3 c = 0.5f * (-P0 + P2);
+  const glm::vec3 d = P1;
+
+  for(int i = 0; i < 3; i++) {
+    segment.coefficients[i][0] = a[i];
+    segment.coefficients[i][1] = b[i];
+    segment.coefficients[i][2] = c[i];
+    segment.coefficients[i][3] = d[i];
+  }
+
+  return segment;
+}
+
+//**************************************************************************************************
+/// Computes the polynomial coefficients of all segments of a closed curve.
+/**
+  \param[in]  points    Array of curve control points.
+  \param[in]  count     Number of curve control points.
+  \param[out] segments  Coefficients of \a count segments, segment i starts at control point i.
+*/
+void computeClosedCurveCoefficients(
+    const glm::vec3                        points[],
+    const size_t                           count,
+    std::vector<CurveSegmentCoefficients> &segments
+) {
+  segments.resize(count);
+
+  for(size_t index = 0; index < count; index++) {
+    segments[index] = computeCurveSegmentCoefficients(
+        points[(index-1+count)%count],
+        points[(index        )%count],
+        points[(index+1      )%count],
+        points[(index+2      )%count]
+        );
+  }
+}
+
+// Horner scheme for one parameter
+static void evaluateCurveSegmentCoefficients(const CurveSegmentCoefficients &segment, const float t, glm::vec3 &position, glm::vec3 &derivative) {
+
+  for(int i = 0; i < 3; i++) {
+    const float *k = segment.coefficients[i];
+    position[i] = ((k[0]*t + k[1])*t + k[2])*t + k[3];
+    derivative[i] = (3.0f*k[0]*t + 2.0f*k[1])*t + k[2];
+  }
+}
+
+//**************************************************************************************************
+/// Evaluates positions and 1st derivatives of curve segments for a batch of parameters.
+/**
+  Four parameters are evaluated at once by SSE where available.
+
+  \param[in]  segments        Coefficients of the curve segments.
+  \param[in]  segmentIndices  Segment evaluated for each parameter, \a n items.
+  \param[in]  t               Segment parameters, \a n items within range [0, 1].
+  \param[in]  n               Number of parameters.
+  \param[out] positions       Positions on the curve, \a n items.
+  \param[out] derivatives     1st derivatives of the curve, \a n items.
+*/
+void evaluateCurveSegmentsBatch(
+    const CurveSegmentCoefficients segments[],
+    const unsigned int             segmentIndices[],
+    const float                    t[],
+    const size_t                   n,
+    glm::vec3                      positions[],
+    glm::vec3                      derivatives[]
+) {
+  size_t j = 0;
+
+#ifdef SPLINE_USE_SSE
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 three = _mm_set1_ps(3.0f);
+
+  for(; j + 4 <= n; j += 4) {
+    const __m128 tt = _mm_loadu_ps(t + j);
+
+    const float *k0 = segments[segmentIndices[j    ]].coefficients[0];
+    const float *k1 = segments[segmentIndices[j + 1]].coefficients[0];
+    const float *k2 = segments[segmentIndices[j + 2]].coefficients[0];
+    const float *k3 = segments[segmentIndices[j + 3]].coefficients[0];
+
+    float position[3][4], derivative[3][4];
+
+    for(int i = 0; i < 3; i++) {
+      // rows a,b,c,d of four segments -> one register per coefficient, one lane per parameter
+      __m128 a = _mm_loadu_ps(k0 + 4*i);
+      __m128 b = _mm_loadu_ps(k1 + 4*i);
+      __m128 c = _mm_loadu_ps(k2 + 4*i);
+      __m128 d = _mm_loadu_ps(k3 + 4*i);
+      _MM_TRANSPOSE4_PS(a, b, c, d);
+
+      const __m128 p = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, tt), b), tt), c), tt), d);
+      const __m128 dp = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(three, a), tt), _mm_mul_ps(two, b)), tt), c);
+
+      _mm_storeu_ps(position[i], p);
+      _mm_storeu_ps(derivative[i], dp);
+    }
+
+    for(int lane = 0; lane < 4; lane++) {
+      positions[j + lane] = glm::vec3(position[0][lane], position[1][lane], position[2][lane]);
+      derivatives[j + lane] = glm::vec3(derivative[0][lane], derivative[1][lane], derivative[2][lane]);
+    }
+  }
+#endif
+
+  // the rest of the batch (the whole batch without SSE)
+  for(; j < n; j++)
+    evaluateCurveSegmentCoefficients(segments[segmentIndices[j]], t[j], positions[j], derivatives[j]);
+}
+
+//**************************************************************************************************
+/// Evaluates positions and 1st derivatives of a closed curve for a batch of parameters.
+/**
+  \param[in]  segments     Coefficients of the closed curve, see computeClosedCurveCoefficients().
+  \param[in]  count        Number of curve segments (= control points).
+  \param[in]  params       Curve parameters, any values (the curve is periodic), \a n items.
+  \param[in]  n            Number of parameters.
+  \param[out] positions    Positions on the curve, \a n items.
+  \param[out] derivatives  1st derivatives of the curve, \a n items.
+*/
+void evaluateClosedCurveBatch(
+    const CurveSegmentCoefficients segments[],
+    const size_t                   count,
+    const float                    params[],
+    const size_t                   n,
+    glm::vec3                      positions[],
+    glm::vec3                      derivatives[]
+) {
+  // segment lookup is done in blocks -> the kernel gets whole groups of four
+  const size_t BLOCK = 64;
+  unsigned int indices[BLOCK];
+  float t[BLOCK];
+
+  for(size_t begin = 0; begin < n; begin += BLOCK) {
+    const size_t blockSize = (n - begin < BLOCK) ? n - begin : BLOCK;
+
+    for(size_t j = 0; j < blockSize; j++) {
+      const float param = cyclic_clamp(params[begin + j], 0.0f, float(count));
+
+      size_t index = size_t(param);
+      if(index >= count)
+        index = count - 1;
+
+      indices[j] = (unsigned int)index;
+      t[j] = param - index;
+    }
+
+    evaluateCurveSegmentsBatch(segments, indices, t, blockSize, positions + begin, derivatives + begin);
+  }
+}
+
+// single segment evaluated by the batch kernel, the parameter fills a whole SSE group
+static void evaluateCurveSegmentByBatch(const glm::vec3& P0, const glm::vec3& P1, const glm::vec3& P2, const glm::vec3& P3, const float t,
+                                        glm::vec3 &position, glm::vec3 &derivative) {
+
+  const CurveSegmentCoefficients segment = computeCurveSegmentCoefficients(P0, P1, P2, P3);
+  const unsigned int indices[4] = { 0, 0, 0, 0 };
+  const float params[4] = { t, t, t, t };
+  glm::vec3 positions[4], derivatives[4];
+
+  evaluateCurveSegmentsBatch(&segment, indices, params, 4, positions, derivatives);
+
+  position = positions[0];
+  derivative = derivatives[0];
+}
+
+//**************************************************************************************************
+/// Evaluates a position on Catmull-Rom curve segment by the batch kernel (for testCurve()).
+glm::vec3 evaluateCurveSegmentBatched(
+    const glm::vec3& P0,
+    const glm::vec3& P1,
+    const glm::vec3& P2,
+    const glm::vec3& P3,
+    const float t
+) {
+  glm::vec3 position, derivative;
+  evaluateCurveSegmentByBatch(P0, P1, P2, P3, t, position, derivative);
+  return position;
+}
+
+//**************************************************************************************************
+/// Evaluates a first derivative of Catmull-Rom curve segment by the batch kernel (for testCurve()).
+glm::vec3 evaluateCurveSegmentBatched_1stDerivative(
+    const glm::vec3& P0,
+    const glm::vec3& P1,
+    const glm::vec3& P2,
+    const glm::vec3& P3,
+    const float t
+) {
+  glm::vec3 position, derivative;
+  evaluateCurveSegmentByBatch(P0, P1, P2, P3, t, position, derivative);
+  return derivative;
+}
+
+// length of the curve between parameters t0 and t1 (3-point Gauss-Legendre quadrature)
+static float curveLength(const glm::vec3 points[], const size_t count, const float t0, const float t1) {
+
+  static const float nodes[3]   = { 0.5f - 0.5f * 0.7745966692f, 0.5f, 0.5f + 0.5f * 0.7745966692f };
+  static const float weights[3] = { 5.0f / 18.0f, 8.0f / 18.0f, 5.0f / 18.0f };
+
+  float length = 0.0f;
+
+  for(int i = 0; i < 3; i++)
+    length += weights[i] * glm::length(evaluateClosedCurve_1stDerivative(points, count, t0 + nodes[i] * (t1 - t0)));
+
+  return length * (t1 - t0);
+}
+
+//**************************************************************************************************
+/// Builds the arc-length table of a closed curve.
+/**
+  Lengths are integrated by the 3-point Gauss-Legendre quadrature of the 1st derivative.
+
+  \param[in]  points              Array of curve control points.
+  \param[in]  count               Number of curve control points.
+  \param[in]  samplesPerSegment   Table entries per curve segment.
+  \param[out] table               Built table.
+*/
+void buildCurveArcLengthTable(
+    const glm::vec3      points[],
+    const size_t         count,
+    const unsigned int   samplesPerSegment,
+    CurveArcLengthTable &table
+) {
+  const size_t sampleCount = count * (samplesPerSegment > 0 ? samplesPerSegment : 1);
+  const float step = float(count) / sampleCount;
+
+  // cumulative length at uniformly spaced parameters, each step is integrated on 4 subintervals
+  std::vector<float> lengths(sampleCount + 1, 0.0f);
+
+  for(size_t k = 0; k < sampleCount; k++) {
+    float length = 0.0f;
+    for(int j = 0; j < 4; j++)
+      length += curveLength(points, count, (k + 0.25f * j) * step, (k + 0.25f * (j + 1)) * step);
+    lengths[k + 1] = lengths[k] + length;
+  }
+
+  computeClosedCurveCoefficients(points, count, table.segments);
+  table.count = count;
+  table.totalLength = lengths[sampleCount];
+  table.distanceScale = (table.totalLength > 0.0f) ? sampleCount / table.totalLength : 0.0f;
+  table.parameters.resize(sampleCount + 1);
+
+  // invert the cumulative lengths at uniformly spaced distances
+  size_t k = 0;
+  for(size_t i = 0; i < sampleCount; i++) {
+    const float distance = i * table.totalLength / sampleCount;
+
+    while(k + 1 < sampleCount && lengths[k + 1] < distance)
+      k++;
+
+    const float interval = lengths[k + 1] - lengths[k];
+    const float fraction = (interval > 0.0f) ? (distance - lengths[k]) / interval : 0.0f;
+
+    table.parameters[i] = (k + glm::clamp(fraction, 0.0f, 1.0f)) * step;
+  }
+  table.parameters[sampleCount] = float(count);
+}
+
+//**************************************************************************************************
+/// Converts the distance along a closed curve to the curve parameter.
+/**
+  \param[in] table    Arc-length table of the curve.
+  \param[in] distance Distance from the curve start, any value (the curve is periodic).
+  \return             Curve parameter in range [0, \a count].
+*/
+float curveArcLengthToParameter(
+    const CurveArcLengthTable &table,
+    const float                distance
+) {
+  if(table.totalLength <= 0.0f)
+    return 0.0f;
+
+  const float position = cyclic_clamp(distance, 0.0f, table.totalLength) * table.distanceScale;
+  const size_t last = table.parameters.size() - 2;
+
+  size_t index = size_t(position);
+  if(index > last)
+    index = last;
+
+  const float fraction = position - index;
+
+  return table.parameters[index] + fraction * (table.parameters[index + 1] - table.parameters[index]);
+}
+
+//**************************************************************************************************
+/// Evaluates positions and unit tangents of a closed curve for a batch of distances.
+/**
+  Parameters are looked up in the table, the curve is evaluated by evaluateClosedCurveBatch().
+
+  \param[in]  table      Arc-length table of the curve.
+  \param[in]  distances  Distances from the curve start, any values (the curve is periodic).
+  \param[in]  n          Number of distances.
+  \param[out] positions  Positions on the curve, \a n items.
+  \param[out] tangents   Normalized 1st derivatives of the curve, \a n items.
+*/
+void evaluateClosedCurveByArcLength(
+    const CurveArcLengthTable &table,
+    const float                distances[],
+    const size_t               n,
+    glm::vec3                  positions[],
+    glm::vec3                  tangents[]
+) {
+  const size_t BLOCK = 64;
+  float params[BLOCK];
+
+  for(size_t begin = 0; begin < n; begin += BLOCK) {
+    const size_t blockSize = (n - begin < BLOCK) ? n - begin : BLOCK;
+
+    for(size_t j = 0; j < blockSize; j++)
+      params[j] = curveArcLengthToParameter(table, distances[begin + j]);
+
+    evaluateClosedCurveBatch(&table.segments[0], table.count, params, blockSize, positions + begin, tangents + begin);
+
+    for(size_t j = begin; j < begin + blockSize; j++)
+      tangents[j] = isVectorNull(tangents[j]) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::normalize(tangents[j]);
+  }
+}
+
 //**************************************************************************************************
 /// Curve validity test points.
 glm::vec3 curveTestPoints[] = {
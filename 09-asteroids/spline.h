@@ -9,6 +9,7 @@
 #ifndef __SPLINE_H
 #define __SPLINE_H
 
+#include <vector>
 #include "pgr.h" // glm
 
 //**************************************************************************************************
@@ -126,6 +127,162 @@ glm::vec3 evaluateClosedCurve_1stDerivative(
     const float     t
 );
 
+//**************************************************************************************************
+/// Polynomial coefficients of one Catmull-Rom curve segment.
+/**
+  Position of the segment is ((a*t + b)*t + c)*t + d, its 1st derivative (3a*t + 2b)*t + c.
+  Row i holds coefficients a, b, c, d of coordinate i, so that one row is one SSE register.
+*/
+typedef struct _CurveSegmentCoefficients {
+  float coefficients[3][4];
+} CurveSegmentCoefficients;
+
+//**************************************************************************************************
+/// Computes the polynomial coefficients of a Catmull-Rom curve segment.
+/**
+  \param[in] P0       First control point of the curve segment.
+  \param[in] P1       Second control point of the curve segment.
+  \param[in] P2       Third control point of the curve segment.
+  \param[in] P3       Fourth control point of the curve segment.
+  \return             Coefficients of the segment.
+*/
+CurveSegmentCoefficients computeCurveSegmentCoefficients(
+    const glm::vec3& P0,
+    const glm::vec3& P1,
+    const glm::vec3& P2,
+    const glm::vec3& P3
+);
+//**************************************************************************************************
+/// Computes the polynomial coefficients of all segments of a closed curve.
+/**
+  \param[in]  points    Array of curve control points.
+  \param[in]  count     Number of curve control points.
+  \param[out] segments  Coefficients of \a count segments, segment i starts at control point i.
+*/
+void computeClosedCurveCoefficients(
+    const glm::vec3                        points[],
+    const size_t                           count,
+    std::vector<CurveSegmentCoefficients> &segments
+);
+//**************************************************************************************************
+/// Evaluates positions and 1st derivatives of curve segments for a batch of parameters.
+/**
+  Four parameters are evaluated at once by SSE where available.
+
+  \param[in]  segments        Coefficients of the curve segments.
+  \param[in]  segmentIndices  Segment evaluated for each parameter, \a n items.
+  \param[in]  t               Segment parameters, \a n items within range [0, 1].
+  \param[in]  n               Number of parameters.
+  \param[out] positions       Positions on the curve, \a n items.
+  \param[out] derivatives     1st derivatives of the curve, \a n items.
+*/
+void evaluateCurveSegmentsBatch(
+    const CurveSegmentCoefficients segments[],
+    const unsigned int             segmentIndices[],
+    const float                    t[],
+    const size_t                   n,
+    glm::vec3                      positions[],
+    glm::vec3                      derivatives[]
+);
+//**************************************************************************************************
+/// Evaluates positions and 1st derivatives of a closed curve for a batch of parameters.
+/**
+  \param[in]  segments     Coefficients of the closed curve, see computeClosedCurveCoefficients().
+  \param[in]  count        Number of curve segments (= control points).
+  \param[in]  params       Curve parameters, any values (the curve is periodic), \a n items.
+  \param[in]  n            Number of parameters.
+  \param[out] positions    Positions on the curve, \a n items.
+  \param[out] derivatives  1st derivatives of the curve, \a n items.
+*/
+void evaluateClosedCurveBatch(
+    const CurveSegmentCoefficients segments[],
+    const size_t                   count,
+    const float                    params[],
+    const size_t                   n,
+    glm::vec3                      positions[],
+    glm::vec3                      derivatives[]
+);
+//**************************************************************************************************
+/// Evaluates a position on Catmull-Rom curve segment by the batch kernel (for testCurve()).
+glm::vec3 evaluateCurveSegmentBatched(
+    const glm::vec3& P0,
+    const glm::vec3& P1,
+    const glm::vec3& P2,
+    const glm::vec3& P3,
+    const float t
+);
+//**************************************************************************************************
+/// Evaluates a first derivative of Catmull-Rom curve segment by the batch kernel (for testCurve()).
+glm::vec3 evaluateCurveSegmentBatched_1stDerivative(
+    const glm::vec3& P0,
+    const glm::vec3& P1,
+    const glm::vec3& P2,
+    const glm::vec3& P3,
+    const float t
+);
+
+//**************************************************************************************************
+/// Arc-length table of a closed curve composed of Catmull-Rom segments.
+/**
+  Maps the distance travelled along the curve to the curve parameter, so that the curve can be
+  followed with constant speed although the speed of the Catmull-Rom parameterization varies.
+  The curve parameter is tabulated for uniformly spaced distances, a lookup is a single
+  linear interpolation.
+*/
+typedef struct _CurveArcLengthTable {
+  std::vector<CurveSegmentCoefficients> segments; ///< Coefficients of the curve segments.
+  size_t                                count;    ///< Number of control points.
+  float                                 totalLength;   ///< Length of the whole closed curve.
+  float                                 distanceScale; ///< Number of table intervals per unit of distance.
+  std::vector<float>                    parameters;    ///< Curve parameter of distance i/distanceScale, i = 0...table size.
+} CurveArcLengthTable;
+
+//**************************************************************************************************
+/// Builds the arc-length table of a closed curve.
+/**
+  Lengths are integrated by the 3-point Gauss-Legendre quadrature of the 1st derivative.
+
+  \param[in]  points              Array of curve control points.
+  \param[in]  count               Number of curve control points.
+  \param[in]  samplesPerSegment   Table entries per curve segment.
+  \param[out] table               Built table.
+*/
+void buildCurveArcLengthTable(
+    const glm::vec3      points[],
+    const size_t         count,
+    const unsigned int   samplesPerSegment,
+    CurveArcLengthTable &table
+);
+//**************************************************************************************************
+/// Converts the distance along a closed curve to the curve parameter.
+/**
+  \param[in] table    Arc-length table of the curve.
+  \param[in] distance Distance from the curve start, any value (the curve is periodic).
+  \return             Curve parameter in range [0, \a count].
+*/
+float curveArcLengthToParameter(
+    const CurveArcLengthTable &table,
+    const float                distance
+);
+//**************************************************************************************************
+/// Evaluates positions and unit tangents of a closed curve for a batch of distances.
+/**
+  Parameters are looked up in the table, the curve is evaluated by evaluateClosedCurveBatch().
+
+  \param[in]  table      Arc-length table of the curve.
+  \param[in]  distances  Distances from the curve start, any values (the curve is periodic).
+  \param[in]  n          Number of distances.
+  \param[out] positions  Positions on the curve, \a n items.
+  \param[out] tangents   Normalized 1st derivatives of the curve, \a n items.
+*/
+void evaluateClosedCurveByArcLength(
+    const CurveArcLengthTable &table,
+    const float                distances[],
+    const size_t               n,
+    glm::vec3                  positions[],
+    glm::vec3                  tangents[]
+);
+
 //**************************************************************************************************
 /// Curve validity test points.
 extern glm::vec3 curveTestPoints[];